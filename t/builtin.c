@@ -0,0 +1,83 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include "test-simple.c.inc"
+
+static int round_trips(const unibi_term *ut) {
+    char buf[8192];
+    const size_t n = unibi_dump(ut, buf, sizeof buf);
+    unibi_term *vt;
+    int r;
+    if (n == (size_t)-1 || n > sizeof buf || !(vt = unibi_from_mem(buf, n))) {
+        return 0;
+    }
+    r = unibi_equal(ut, vt);
+    unibi_destroy(vt);
+    return r;
+}
+
+int main(void) {
+    unibi_term *ut, *vt;
+    size_t i, n;
+    int all_ok;
+
+    plan(11);
+
+    n = unibi_count_builtin();
+    ok(n > 0, "there are built-in entries");
+    all_ok = 1;
+    for (i = 1; i < n; i++) {
+        if (strcmp(unibi_builtin_name(i - 1), unibi_builtin_name(i)) >= 0) {
+            all_ok = 0;
+        }
+    }
+    ok(all_ok && !unibi_builtin_name(n), "names are sorted");
+
+    all_ok = 1;
+    for (i = 0; i < n; i++) {
+        if (!(ut = unibi_from_builtin(unibi_builtin_name(i)))) {
+            all_ok = 0;
+            continue;
+        }
+        if (!round_trips(ut)) {
+            all_ok = 0;
+        }
+        unibi_destroy(ut);
+    }
+    ok(all_ok, "every entry loads and survives a dump");
+
+    ut = unibi_from_builtin("xterm-256color");
+    ok(ut != NULL, "xterm-256color is built in");
+    if (!ut) {
+        bail_out(strerror(errno));
+    }
+    ok(strcmp(unibi_get_name(ut), "xterm with 256 colors") == 0, "name");
+    ok(unibi_get_num(ut, unibi_max_colors) == 256, "colors");
+    ok(strcmp(unibi_get_str(ut, unibi_cursor_address), "\033[%i%p1%d;%p2%dH") == 0, "cup");
+
+    vt = unibi_from_builtin("xterm-256color");
+    ok(
+        vt && unibi_get_str(vt, unibi_cursor_address) == unibi_get_str(ut, unibi_cursor_address) &&
+        unibi_get_ext_str(vt, 0) == unibi_get_ext_str(ut, 0),
+        "strings are shared, not copied"
+    );
+    unibi_set_str(vt, unibi_cursor_address, "changed");
+    ok(
+        strcmp(unibi_get_str(ut, unibi_cursor_address), "\033[%i%p1%d;%p2%dH") == 0,
+        "entries are independent objects"
+    );
+    unibi_destroy(vt);
+    unibi_destroy(ut);
+
+    ut = unibi_from_builtin("vt100-am");
+    ok(ut && strcmp(unibi_get_name(ut), "DEC VT100 (w/advanced video)") == 0, "found by alias");
+    if (ut) {
+        unibi_destroy(ut);
+    }
+
+    errno = 0;
+    ok(!unibi_from_builtin("no-such-terminal") && errno == ENOENT, "unknown name");
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+struct wlog {
+    size_t used;
+    char buf[4096];
+};
+
+static void out(void *ctx, const char *p, size_t n) {
+    struct wlog *wlog = ctx;
+    if (n > sizeof wlog->buf - wlog->used) {
+        n = sizeof wlog->buf - wlog->used;
+    }
+    memcpy(wlog->buf + wlog->used, p, n);
+    wlog->used += n;
+}
+
+static void pad(void *ctx, size_t delay, int scale, int force) {
+    char tmp[64];
+    snprintf(tmp, sizeof tmp, "<pad %zu %d %d>", delay, scale, force);
+    out(ctx, tmp, strlen(tmp));
+}
+
+static int vars_equal(const unibi_var_t *a, const unibi_var_t *b, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (unibi_num_from_var(a[i]) != unibi_num_from_var(b[i]) || unibi_str_from_var(a[i]) != unibi_str_from_var(b[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static const int param_sets[][9] = {
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 1, 2, 3, 4, 5, 6, 7, 8, 9 },
+    { 9, 200, 1, 0, 1, 0, 1, 0, 1 },
+    { 255, 7, 15, 96, 31, 2, 1, 1, 1 },
+};
+
+/* run fmt through both unibi_format and a compiled program; compare output,
+ * padding, variables and parameters */
+static int same(const char *fmt) {
+    static struct wlog wa, wb;
+    unibi_prog *prog;
+    size_t k;
+    int r = 1;
+
+    if (!(prog = unibi_compile(fmt))) {
+        return 0;
+    }
+    for (k = 0; r && k < sizeof param_sets / sizeof param_sets[0]; k++) {
+        unibi_var_t va[52] = {{0}}, vb[52] = {{0}}, pa[9], pb[9];
+        size_t i;
+        for (i = 0; i < 9; i++) {
+            pa[i] = pb[i] = unibi_var_from_num(param_sets[k][i]);
+        }
+        wa.used = wb.used = 0;
+        unibi_format(va, va + 26, fmt, pa, out, &wa, pad, &wa);
+        unibi_exec(prog, vb, vb + 26, pb, out, &wb, pad, &wb);
+        r =
+            wa.used == wb.used &&
+            memcmp(wa.buf, wb.buf, wa.used) == 0 &&
+            vars_equal(va, vb, 52) &&
+            vars_equal(pa, pb, 9);
+        if (!r) {
+            diag("%s: \"%.*s\" vs \"%.*s\"", fmt, (int)wa.used, wa.buf, (int)wb.used, wb.buf);
+        }
+    }
+    unibi_prog_destroy(prog);
+    return r;
+}
+
+static int same_all(const char *name) {
+    unibi_term *ut;
+    enum unibi_string i;
+    size_t k, n;
+    int r = 1;
+
+    if (!(ut = unibi_from_builtin(name))) {
+        return 0;
+    }
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        const char *s = unibi_get_str(ut, i);
+        if (s && !same(s)) {
+            r = 0;
+        }
+    }
+    n = unibi_count_ext_str(ut);
+    for (k = 0; k < n; k++) {
+        const char *s = unibi_get_ext_str(ut, k);
+        if (s && !same(s)) {
+            r = 0;
+        }
+    }
+    unibi_destroy(ut);
+    return r;
+}
+
+static const char *const tricky[] = {
+    "",
+    "plain text",
+    "%",
+    "%%%",
+    "%z%p0%Px%g!%'a%'%{12%{}%:%5%.%:-5.2%e",
+    "a$<5>b$<2.5*/>c$<3/*>$<x>$<7$",
+    "%p1%c%p2%s%p2%l%d",
+    "%p1%:-5d|%p2%#x|%p3%05.3o|%p4% d|%p5%+X|%p1%10.4s|",
+    "%i%p1%d;%p2%d",
+    "%p1%Pa%p2%PZ%ga%gZ%+%d",
+    "%{5}%{3}%-%{4}%*%{7}%m%{2}%/%{6}%&%{1}%|%{3}%^%d%{2}%{2}%=%{1}%<%{9}%>%A%{0}%O%!%~%d",
+    "A%?%{0}%tB%?%{0}%tC%eD%;E%eF%?%{1}%tG%eH%;I%;J",
+    "A%?%{0}%tB%e%{0}%tC%e%{42}%tF%eJ%;K",
+    "x%;y%ez%?%tw",
+    "%?%p1%t%'%e'%;after",
+};
+
+int main(void) {
+    static const char *const terms[] = {
+        "xterm-256color", "screen-256color", "tmux-256color", "rxvt-256color", "linux", "vt220", "ansi",
+    };
+    unibi_var_t param[9] = {{0}};
+    unibi_prog *prog;
+    char buf[64];
+    size_t i, n;
+
+    plan(9 + (int)(sizeof terms / sizeof terms[0]));
+
+    {
+        int r = 1;
+        for (i = 0; i < sizeof tricky / sizeof tricky[0]; i++) {
+            if (!same(tricky[i])) {
+                r = 0;
+            }
+        }
+        ok(r, "edge cases match unibi_format");
+    }
+
+    for (i = 0; i < sizeof terms / sizeof terms[0]; i++) {
+        ok(same_all(terms[i]), "all strings of %s match unibi_format", terms[i]);
+    }
+
+    prog = unibi_compile("\033[%i%p1%d;%p2%dH");
+    ok(prog != NULL, "compiled");
+    if (!prog) {
+        bail_out(strerror(errno));
+    }
+    param[0] = unibi_var_from_num(4);
+    param[1] = unibi_var_from_num(9);
+    n = unibi_run_prog(prog, param, buf, sizeof buf);
+    ok(n == 7 && memcmp(buf, "\033[5;10H", n) == 0, "unibi_run_prog");
+    ok(unibi_num_from_var(param[0]) == 5, "percent-i changes the parameters");
+    n = unibi_run_prog(prog, param, buf, 3);
+    ok(n == 7 && memcmp(buf, "\033[6", 3) == 0, "truncated output");
+    unibi_prog_destroy(prog);
+
+    prog = unibi_compile("%p1%p2%/%d");
+    ok(prog != NULL, "division compiled");
+    if (!prog) {
+        bail_out(strerror(errno));
+    }
+    param[0] = unibi_var_from_num(7);
+    param[1] = unibi_var_from_num(0);
+    n = unibi_run_prog(prog, param, buf, sizeof buf);
+    ok(n == 1 && buf[0] == '0', "division by zero yields 0");
+    unibi_prog_destroy(prog);
+
+    n = unibi_run("%p1%p2%/%d", param, buf, sizeof buf);
+    ok(n == 1 && buf[0] == '0', "unibi_run: division by zero yields 0");
+    n = unibi_run("%p1%p2%m%d", param, buf, sizeof buf);
+    ok(n == 1 && buf[0] == '0', "unibi_run: remainder by zero yields 0");
+
+    return 0;
+}
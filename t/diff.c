@@ -0,0 +1,82 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+#define SIZE_ERR ((size_t)-1)
+
+struct change {
+    enum unibi_diff_op op;
+    enum unibi_cap_type type;
+    int cap;
+    size_t ia, ib;
+};
+
+struct log {
+    size_t n;
+    struct change c[16];
+};
+
+static void record(void *ctx, enum unibi_diff_op op, enum unibi_cap_type type, int cap, size_t ia, size_t ib) {
+    struct log *log = ctx;
+    if (log->n < sizeof log->c / sizeof log->c[0]) {
+        struct change *c = &log->c[log->n];
+        c->op = op;
+        c->type = type;
+        c->cap = cap;
+        c->ia = ia;
+        c->ib = ib;
+    }
+    log->n++;
+}
+
+static int is_change(const struct change *c, enum unibi_diff_op op, enum unibi_cap_type type, int cap, size_t ia, size_t ib) {
+    return c->op == op && c->type == type && c->cap == cap && c->ia == ia && c->ib == ib;
+}
+
+int main(void) {
+    unibi_term *a, *b;
+    struct log log;
+
+    plan(12);
+
+    a = unibi_dummy();
+    b = unibi_dummy();
+
+    log.n = 0;
+    ok(unibi_diff(a, b, record, &log) == 0 && log.n == 0, "no differences between dummies");
+
+    unibi_set_bool(a, unibi_auto_right_margin, 1);
+    unibi_set_bool(b, unibi_back_color_erase, 1);
+    unibi_set_num(a, unibi_columns, 80);
+    unibi_set_num(b, unibi_columns, 132);
+    unibi_set_num(b, unibi_max_colors, 256);
+    unibi_set_str(a, unibi_bell, "\007");
+    unibi_set_str(b, unibi_bell, "\007");
+    unibi_set_str(a, unibi_flash_screen, "\033g");
+
+    unibi_add_ext_bool(a, "XT", 1);
+    unibi_add_ext_bool(a, "AX", 1);
+    unibi_add_ext_bool(b, "AX", 1);
+    unibi_add_ext_num(b, "RGB", 8);
+    unibi_add_ext_str(a, "Ss", "\033[%p1%d q");
+    unibi_add_ext_str(b, "Se", "\033[2 q");
+    unibi_add_ext_str(b, "Ss", "\033[%p1%d  q");
+
+    log.n = 0;
+    ok(unibi_diff(a, b, record, &log) == 0, "diff succeeded");
+    ok(log.n == 9, "9 differences");
+    ok(is_change(&log.c[0], unibi_diff_removed, unibi_cap_bool, unibi_auto_right_margin, SIZE_ERR, SIZE_ERR), "am removed");
+    ok(is_change(&log.c[1], unibi_diff_added, unibi_cap_bool, unibi_back_color_erase, SIZE_ERR, SIZE_ERR), "bce added");
+    ok(is_change(&log.c[2], unibi_diff_removed, unibi_cap_bool, -1, 0, SIZE_ERR), "ext XT removed");
+    ok(is_change(&log.c[3], unibi_diff_changed, unibi_cap_num, unibi_columns, SIZE_ERR, SIZE_ERR), "cols changed");
+    ok(is_change(&log.c[4], unibi_diff_added, unibi_cap_num, unibi_max_colors, SIZE_ERR, SIZE_ERR), "colors added");
+    ok(is_change(&log.c[5], unibi_diff_added, unibi_cap_num, -1, SIZE_ERR, 0), "ext RGB added");
+    ok(is_change(&log.c[6], unibi_diff_removed, unibi_cap_str, unibi_flash_screen, SIZE_ERR, SIZE_ERR), "flash removed");
+    ok(is_change(&log.c[7], unibi_diff_added, unibi_cap_str, -1, SIZE_ERR, 0), "ext Se added");
+    ok(is_change(&log.c[8], unibi_diff_changed, unibi_cap_str, -1, 0, 1), "ext Ss changed");
+
+    unibi_destroy(a);
+    unibi_destroy(b);
+
+    return 0;
+}
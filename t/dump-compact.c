@@ -0,0 +1,74 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+int main(void) {
+    static char plain[4096], compact[4096];
+    static char big[20001];
+    unibi_term *ut, *rt;
+    size_t n, m;
+    char *p;
+
+    plan(12);
+
+    ut = unibi_dummy();
+    unibi_set_str(ut, unibi_exit_attribute_mode, "\033(B\033[m");
+    unibi_set_str(ut, unibi_exit_standout_mode, "\033[m");
+    unibi_set_str(ut, unibi_exit_underline_mode, "\033[m");
+    unibi_set_str(ut, unibi_cursor_up, "\033[A");
+    unibi_set_str(ut, unibi_key_up, "\033OA");
+    unibi_add_ext_str(ut, "E3", "\033[3J");
+    unibi_add_ext_str(ut, "E4", "\033[3J");
+
+    n = unibi_dump(ut, plain, sizeof plain);
+    m = unibi_dump_compact(ut, compact, sizeof compact);
+    ok(n <= sizeof plain && m <= sizeof compact, "both dumps fit");
+    ok(m == n - 4 - 4, "shared strings are stored once");
+
+    rt = unibi_from_mem(compact, m);
+    ok(rt != NULL, "compact dump can be read back");
+    ok(unibi_equal(ut, rt), "compact dump round-trips");
+    ok(
+        unibi_get_str(rt, unibi_exit_standout_mode) == unibi_get_str(rt, unibi_exit_underline_mode),
+        "identical strings share an offset"
+    );
+    ok(
+        unibi_get_str(rt, unibi_exit_standout_mode) ==
+        unibi_get_str(rt, unibi_exit_attribute_mode) + 3,
+        "suffixes point into the longer string"
+    );
+    ok(strcmp(unibi_get_ext_str(rt, 1), "\033[3J") == 0, "extended strings are intact");
+    unibi_destroy(rt);
+
+    ok(unibi_dump_compact(ut, compact, m - 1) == m, "size is reported when the buffer is too small");
+
+    unibi_set_str(ut, unibi_exit_attribute_mode, NULL);
+    unibi_set_str(ut, unibi_exit_underline_mode, NULL);
+    unibi_set_str(ut, unibi_key_up, NULL);
+    n = unibi_dump(ut, plain, sizeof plain);
+    m = unibi_dump_compact(ut, compact, sizeof compact);
+    ok(m == n && memcmp(plain, compact, n) == 0, "nothing to share gives the plain layout");
+
+    unibi_destroy(ut);
+
+    memset(big, 'x', sizeof big - 1);
+    ut = unibi_dummy();
+    unibi_set_str(ut, unibi_key_f1, big);
+    unibi_set_str(ut, unibi_key_f2, big);
+    errno = 0;
+    ok(unibi_dump(ut, plain, sizeof plain) == (size_t)-1 && errno == EINVAL, "too big for the plain layout");
+    m = unibi_dump_compact(ut, NULL, 0);
+    p = malloc(m);
+    ok(m != (size_t)-1 && p && unibi_dump_compact(ut, p, m) == m, "shared table fits the compact layout");
+    rt = p ? unibi_from_mem(p, m) : NULL;
+    ok(rt && unibi_equal(ut, rt), "big compact dump round-trips");
+    if (rt) {
+        unibi_destroy(rt);
+    }
+    free(p);
+    unibi_destroy(ut);
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <unibilium.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+struct sink {
+    char buf[16384];
+    size_t used;
+    size_t calls;
+    size_t fail_after;
+};
+
+static int collect(void *ctx, const char *p, size_t n) {
+    struct sink *s = ctx;
+    if (s->calls++ == s->fail_after) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (s->used + n > sizeof s->buf) {
+        return -1;
+    }
+    memcpy(s->buf + s->used, p, n);
+    s->used += n;
+    return 0;
+}
+
+static void sink_init(struct sink *s) {
+    s->used = 0;
+    s->calls = 0;
+    s->fail_after = (size_t)-1;
+}
+
+static size_t dump_via_fd(const unibi_term *ut, char *buf, size_t n, size_t *got) {
+    FILE *fp = tmpfile();
+    size_t r;
+    if (!fp) {
+        bail_out(strerror(errno));
+    }
+    r = unibi_dump_fd(ut, fileno(fp));
+    rewind(fp);
+    *got = fread(buf, 1, n, fp);
+    fclose(fp);
+    return r;
+}
+
+int main(void) {
+    static char ref[16384], fdbuf[16384];
+    static char names[300][8];
+    struct sink s;
+    unibi_term *ut;
+    size_t n, r, got, i;
+
+    plan(14);
+
+    ut = unibi_dummy();
+    unibi_set_name(ut, "streamed");
+    unibi_set_bool(ut, unibi_auto_right_margin, 1);
+    unibi_set_num(ut, unibi_columns, 80);
+    unibi_set_str(ut, unibi_bell, "\007");
+    unibi_set_str(ut, unibi_clear_screen, "\033[H\033[2J");
+    unibi_add_ext_bool(ut, "AX", 1);
+    unibi_add_ext_num(ut, "U8", 1);
+    unibi_add_ext_str(ut, "Ss", "\033[%p1%d q");
+
+    n = unibi_dump(ut, ref, sizeof ref);
+    ok(n <= sizeof ref, "reference dump fits");
+
+    sink_init(&s);
+    r = unibi_dump_to(ut, collect, &s);
+    ok(r == n && s.used == n, "unibi_dump_to size matches");
+    ok(memcmp(s.buf, ref, n) == 0, "unibi_dump_to output matches");
+
+    r = dump_via_fd(ut, fdbuf, sizeof fdbuf, &got);
+    ok(r == n && got == n, "unibi_dump_fd size matches");
+    ok(memcmp(fdbuf, ref, n) == 0, "unibi_dump_fd output matches");
+
+    sink_init(&s);
+    s.fail_after = 2;
+    errno = 0;
+    r = unibi_dump_to(ut, collect, &s);
+    ok(r == (size_t)-1 && errno == ENOSPC, "write errors are reported");
+    ok(s.calls == 3, "no writes after an error");
+
+    ok(unibi_dump_fd(ut, -1) == (size_t)-1 && errno == EBADF, "bad fd is reported");
+
+    {
+        static char buf[16384];
+        ok(unibi_dump(ut, buf, sizeof buf) == n && memcmp(buf, ref, n) == 0, "repeated dump is identical");
+
+        unibi_set_str(ut, unibi_bell, "\033[?5h\033[?5l");
+        unibi_set_ext_str(ut, 0, NULL);
+        r = unibi_dump(ut, buf, sizeof buf);
+        {
+            unibi_term *rt = unibi_from_mem(buf, r);
+            ok(
+                rt &&
+                strcmp(unibi_get_str(rt, unibi_bell), "\033[?5h\033[?5l") == 0 &&
+                unibi_get_ext_str(rt, 0) == NULL,
+                "dump follows setters"
+            );
+            if (rt) {
+                unibi_destroy(rt);
+            }
+        }
+
+        sink_init(&s);
+        ok(unibi_dump_to(ut, collect, &s) == r && memcmp(s.buf, buf, r) == 0, "repeated dump is identical");
+        unibi_set_str(ut, unibi_bell, "\007");
+        unibi_set_ext_str(ut, 0, "\033[%p1%d q");
+    }
+
+    for (i = 0; i < 300; i++) {
+        sprintf(names[i], "x%u", (unsigned)i);
+        unibi_add_ext_str(ut, names[i], i % 3 ? "\033[0m" : NULL);
+        unibi_add_ext_num(ut, names[i], (int)i);
+    }
+
+    n = unibi_dump(ut, ref, sizeof ref);
+    ok(n <= sizeof ref, "large reference dump fits");
+
+    sink_init(&s);
+    r = unibi_dump_to(ut, collect, &s);
+    ok(r == n && memcmp(s.buf, ref, n) == 0, "large unibi_dump_to output matches");
+
+    r = dump_via_fd(ut, fdbuf, sizeof fdbuf, &got);
+    ok(r == n && got == n && memcmp(fdbuf, ref, n) == 0, "large unibi_dump_fd output matches");
+
+    unibi_destroy(ut);
+
+    return 0;
+}
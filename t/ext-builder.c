@@ -0,0 +1,64 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+#define SIZE_ERR ((size_t)-1)
+
+static unibi_term *test_term(void) {
+    static const char *aliases[] = { "test", NULL };
+    unibi_term *const t = unibi_dummy();
+    unibi_set_name(t, "not a real terminal");
+    unibi_set_aliases(t, aliases);
+    unibi_set_str(t, unibi_bell, "BONG!");
+    return t;
+}
+
+int main(void) {
+    unibi_term *a, *b;
+    unibi_ext_builder *eb;
+    char buf_a[4096], buf_b[4096];
+    size_t n_a, n_b;
+
+    plan(16);
+
+    a = test_term();
+    ok(unibi_add_ext_bool(a, "AX", 1) != SIZE_ERR, "add AX");
+    ok(unibi_add_ext_str(a, "Ss", "\033]50;%p1%s\007") != SIZE_ERR, "add Ss");
+    ok(unibi_add_ext_num(a, "RGB", 8) != SIZE_ERR, "add RGB");
+    ok(unibi_add_ext_bool(a, "XT", 1) != SIZE_ERR, "add XT");
+    ok(unibi_add_ext_str(a, "Se", "\033[2 q") != SIZE_ERR, "add Se");
+
+    b = test_term();
+    ok(unibi_add_ext_bool(b, "AX", 1) != SIZE_ERR, "add AX directly");
+    eb = unibi_ext_builder_create();
+    ok(eb != NULL, "builder created");
+    ok(
+        unibi_ext_builder_add_str(eb, "Ss", "\033]50;%p1%s\007") == 0 &&
+        unibi_ext_builder_add_num(eb, "RGB", 8) == 0 &&
+        unibi_ext_builder_add_bool(eb, "XT", 1) == 0 &&
+        unibi_ext_builder_add_str(eb, "Se", "\033[2 q") == 0,
+        "builder filled"
+    );
+    ok(unibi_ext_builder_commit(eb, b) == 0, "builder committed");
+
+    ok(unibi_count_ext_bool(b) == 2 && unibi_count_ext_num(b) == 1 && unibi_count_ext_str(b) == 2, "ext counts");
+    ok(strcmp(unibi_get_ext_bool_name(b, 1), "XT") == 0, "ext_bool[1].name = \"XT\"");
+    ok(strcmp(unibi_get_ext_num_name(b, 0), "RGB") == 0 && unibi_get_ext_num(b, 0) == 8, "ext_num[0] = RGB#8");
+    ok(strcmp(unibi_get_ext_str_name(b, 1), "Se") == 0, "ext_str[1].name = \"Se\"");
+
+    n_a = unibi_dump(a, buf_a, sizeof buf_a);
+    n_b = unibi_dump(b, buf_b, sizeof buf_b);
+    ok(n_a == n_b && n_a <= sizeof buf_a && memcmp(buf_a, buf_b, n_a) == 0, "builder dump == incremental dump");
+
+    ok(unibi_ext_builder_commit(eb, b) == 0 && unibi_count_ext_str(b) == 2, "empty commit is a no-op");
+
+    unibi_ext_builder_add_bool(eb, "Tc", 1);
+    unibi_ext_builder_commit(eb, b);
+    ok(unibi_count_ext_bool(b) == 3 && strcmp(unibi_get_ext_str_name(b, 0), "Ss") == 0, "builder reusable after commit");
+
+    unibi_ext_builder_destroy(eb);
+    unibi_destroy(a);
+    unibi_destroy(b);
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static int keep_upper(void *ctx, enum unibi_cap_type type, size_t i, const char *name) {
+    unsigned *calls = ctx;
+    (void)type;
+    (void)i;
+    ++*calls;
+    return name[0] >= 'A' && name[0] <= 'Z';
+}
+
+int main(void) {
+    unibi_term *t;
+    unsigned calls = 0;
+    size_t r;
+
+    plan(9);
+
+    t = unibi_dummy();
+    unibi_add_ext_bool(t, "AX", 1);
+    unibi_add_ext_bool(t, "xx", 1);
+    unibi_add_ext_bool(t, "XT", 0);
+    unibi_add_ext_num(t, "yy", 1);
+    unibi_add_ext_num(t, "RGB", 24);
+    unibi_add_ext_str(t, "zz", "zz");
+    unibi_add_ext_str(t, "Ss", "\033[%p1%d q");
+    unibi_add_ext_str(t, "ww", NULL);
+
+    r = unibi_filter_ext(t, keep_upper, &calls);
+    ok(r == 4, "removed 4 capabilities");
+    ok(calls == 8, "predicate called once per capability");
+
+    ok(unibi_count_ext_bool(t) == 2, "2 ext bools left");
+    ok(strcmp(unibi_get_ext_bool_name(t, 0), "AX") == 0 && unibi_get_ext_bool(t, 0) == 1, "ext_bool[0] = AX");
+    ok(strcmp(unibi_get_ext_bool_name(t, 1), "XT") == 0 && unibi_get_ext_bool(t, 1) == 0, "ext_bool[1] = XT@");
+    ok(unibi_count_ext_num(t) == 1 && strcmp(unibi_get_ext_num_name(t, 0), "RGB") == 0 && unibi_get_ext_num(t, 0) == 24, "ext_num[0] = RGB#24");
+    ok(unibi_count_ext_str(t) == 1 && strcmp(unibi_get_ext_str_name(t, 0), "Ss") == 0, "ext_str[0] = Ss");
+
+    unibi_shrink_ext(t);
+    ok(unibi_count_ext_str(t) == 1 && strcmp(unibi_get_ext_str(t, 0), "\033[%p1%d q") == 0, "contents survive shrinking");
+
+    ok(unibi_add_ext_str(t, "Se", "\033[2 q") == 1, "can add after shrinking");
+
+    unibi_destroy(t);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+int main(void) {
+    enum unibi_cap_type type;
+    int i, bad;
+
+    plan(6);
+
+    bad = 0;
+    for (i = unibi_boolean_begin_ + 1; i < unibi_boolean_end_; i++) {
+        if (unibi_find_cap(unibi_short_name_bool(i), &type) != i || type != unibi_cap_bool) {
+            bad++;
+        }
+    }
+    ok(bad == 0, "all boolean names are found");
+
+    bad = 0;
+    for (i = unibi_numeric_begin_ + 1; i < unibi_numeric_end_; i++) {
+        if (unibi_find_cap(unibi_short_name_num(i), &type) != i || type != unibi_cap_num) {
+            bad++;
+        }
+    }
+    ok(bad == 0, "all numeric names are found");
+
+    bad = 0;
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        if (unibi_find_cap(unibi_short_name_str(i), &type) != i || type != unibi_cap_str) {
+            bad++;
+        }
+    }
+    ok(bad == 0, "all string names are found");
+
+    ok(unibi_find_cap("cup", NULL) == unibi_cursor_address, "type is optional");
+    ok(unibi_find_cap("Ss", &type) == -1, "extended names are not found");
+    ok(unibi_find_cap("", &type) == -1, "empty name is not found");
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+struct wlog {
+    size_t used;
+    char buf[256];
+};
+
+static void out(void *ctx, const char *p, size_t n) {
+    struct wlog *wlog = ctx;
+    if (n > sizeof wlog->buf - wlog->used) {
+        n = sizeof wlog->buf - wlog->used;
+    }
+    memcpy(wlog->buf + wlog->used, p, n);
+    wlog->used += n;
+}
+
+static int is(const struct wlog *wlog, const char *s) {
+    return wlog->used == strlen(s) && memcmp(wlog->buf, s, wlog->used) == 0;
+}
+
+int main(void) {
+    static const char set[] = "%p1%Pa%p2%PZ%ga%gZ%+%d";
+    static const char get[] = "[%ga%d,%gZ%d,%gq%d]";
+    unibi_var_t param[9] = {{0}};
+    unibi_fmt_ctx *fc;
+    unibi_prog *prog;
+    struct wlog wlog;
+
+    plan(7);
+
+    fc = unibi_fmt_ctx_create();
+    prog = unibi_compile(get);
+    if (!fc || !prog) {
+        bail_out(strerror(errno));
+    }
+
+    param[0] = unibi_var_from_num(30);
+    param[1] = unibi_var_from_num(12);
+    wlog.used = 0;
+    unibi_fmt_ctx_format(fc, set, param, out, &wlog, NULL, NULL);
+    ok(is(&wlog, "42"), "variables within one call");
+
+    wlog.used = 0;
+    unibi_fmt_ctx_format(fc, get, param, out, &wlog, NULL, NULL);
+    ok(is(&wlog, "[0,12,0]"), "static variables are kept, dynamic ones reset");
+
+    wlog.used = 0;
+    unibi_fmt_ctx_format(fc, set, param, out, &wlog, NULL, NULL);
+    unibi_fmt_ctx_exec(fc, prog, param, out, &wlog, NULL, NULL);
+    ok(is(&wlog, "42[0,12,0]"), "same for compiled programs");
+
+    wlog.used = 0;
+    unibi_fmt_ctx_format(fc, "%{7}%Pq%gq%d", param, out, &wlog, NULL, NULL);
+    unibi_fmt_ctx_format(fc, "%{8}%Pq%gq%d", param, out, &wlog, NULL, NULL);
+    ok(is(&wlog, "78"), "reassigned variable");
+
+    {
+        unibi_fmt_ctx *fc2 = unibi_fmt_ctx_create();
+        if (!fc2) {
+            bail_out(strerror(errno));
+        }
+        wlog.used = 0;
+        unibi_fmt_ctx_format(fc2, get, param, out, &wlog, NULL, NULL);
+        ok(is(&wlog, "[0,0,0]"), "a new context starts with zero variables");
+        unibi_fmt_ctx_destroy(fc2);
+    }
+
+    {
+        char buf[16];
+        const size_t n = unibi_run(get, param, buf, sizeof buf);
+        ok(n == 7 && memcmp(buf, "[0,0,0]", n) == 0, "unibi_run starts with zero variables");
+    }
+
+    {
+        unibi_var_t var_dyn[26] = {{0}}, var_static[26] = {{0}};
+        var_dyn[0] = unibi_var_from_num(3);
+        var_static[25] = unibi_var_from_num(4);
+        wlog.used = 0;
+        unibi_format(var_dyn, var_static, get, param, out, &wlog, NULL, NULL);
+        ok(is(&wlog, "[3,4,0]"), "unibi_format uses the caller's variables");
+    }
+
+    unibi_prog_destroy(prog);
+    unibi_fmt_ctx_destroy(fc);
+
+    return 0;
+}
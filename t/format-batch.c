@@ -0,0 +1,110 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+#define NOPS 300
+
+static unibi_batch_op ops[NOPS];
+
+/* cup + setaf + text triples, with the odd absent or plain capability */
+static void make_ops(void) {
+    static const char text[] = "some text";
+    size_t i;
+
+    memset(ops, 0, sizeof ops);
+    for (i = 0; i < NOPS; i++) {
+        unibi_batch_op *const op = &ops[i];
+        const int k = (int)(i / 3);
+        switch (i % 3) {
+            case 0:
+                op->cap = k % 10 == 9 ? unibi_clear_screen : unibi_cursor_address;
+                op->param[0] = unibi_var_from_num(k % 7);
+                op->param[1] = unibi_var_from_num(k * 5 % 80);
+                break;
+            case 1:
+                op->cap = k % 10 == 8 ? unibi_enter_secure_mode : unibi_set_a_foreground;
+                op->param[0] = unibi_var_from_num(k * 37 % 256);
+                break;
+            case 2:
+                op->text = text;
+                op->len = (size_t)(k % (int)sizeof text);
+                break;
+        }
+    }
+}
+
+/* the batch gives the same bytes as running each operation on its own and
+ * leaves ops alone */
+static int matches_run(unibi_term *ut) {
+    static char expect[NOPS * 32];
+    unibi_buf b;
+    size_t i, n = 0;
+    int r;
+
+    for (i = 0; i < NOPS; i++) {
+        if (ops[i].text) {
+            memcpy(expect + n, ops[i].text, ops[i].len);
+            n += ops[i].len;
+        } else {
+            unibi_var_t param[9];
+            memcpy(param, ops[i].param, sizeof param);
+            n += unibi_run_str(ut, ops[i].cap, param, expect + n, sizeof expect - n);
+        }
+    }
+
+    unibi_buf_init(&b);
+    r = unibi_format_batch(ut, ops, NOPS, &b) == 0 && b.len == n && memcmp(b.data, expect, n) == 0;
+    unibi_buf_free(&b);
+    for (i = 0; i < NOPS; i += 3) {
+        r = r && unibi_num_from_var(ops[i].param[0]) == (int)(i / 3) % 7;
+    }
+    return r;
+}
+
+int main(void) {
+    unibi_term *ut;
+    unibi_batch_op op;
+    unibi_buf b;
+
+    plan(8);
+
+    if (!(ut = unibi_from_builtin("xterm-256color"))) {
+        bail_out(strerror(errno));
+    }
+    make_ops();
+
+    ok(matches_run(ut), "batch matches separate calls");
+    ok(unibi_set_memo_size(ut, 64) == 0 && matches_run(ut), "batch matches with a cache");
+    ok(matches_run(ut), "batch matches with a warm cache");
+
+    unibi_buf_init(&b);
+    ok(unibi_format_batch(ut, ops, 0, &b) == 0 && b.len == 0, "empty batch");
+
+    memset(&op, 0, sizeof op);
+    op.text = "abc";
+    op.len = 3;
+    ok(
+        unibi_format_batch(ut, &op, 1, &b) == 0 &&
+        unibi_format_batch(ut, &op, 1, &b) == 0 &&
+        b.len == 6 && memcmp(b.data, "abcabc", 6) == 0,
+        "batches append"
+    );
+    unibi_buf_free(&b);
+
+    unibi_buf_init(&b);
+    op.len = 0;
+    unibi_set_str(ut, unibi_bell, "");
+    ok(unibi_format_batch(ut, &op, 1, &b) == 0 && b.len == 0, "empty text into a fresh buffer");
+    memset(&op, 0, sizeof op);
+    op.cap = unibi_bell;
+    ok(unibi_format_batch(ut, &op, 1, &b) == 0 && b.len == 0, "empty capability into a fresh buffer");
+    unibi_buf_free(&b);
+
+    unibi_set_str(ut, unibi_cursor_address, "%p1%d;%p2%d%p1%Pa");
+    ok(matches_run(ut), "batch with a string that can't be cached");
+
+    unibi_destroy(ut);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static const char *const fmts[] = {
+    "\033[%i%p1%d;%p2%dH",
+    "\033[%?%p1%{8}%<%t3%p1%d%e%p1%{16}%<%t9%p1%{8}%-%d%e38;5;%p1%d%;m",
+    "%p1%05d|%p2%x|%p1%:-4d|%p2%#o|%p1%c",
+    "%p3%s",
+    "%p1%600d",
+    "\033(B\033[m",
+    "",
+};
+
+/* appending each format to one buffer gives the same bytes as unibi_run */
+static int matches_run(int compiled) {
+    static char expect[8192];
+    unibi_buf b;
+    size_t i, n = 0;
+    int r = 1;
+
+    unibi_buf_init(&b);
+    for (i = 0; i < sizeof fmts / sizeof fmts[0]; i++) {
+        unibi_var_t pa[9] = {{0}}, pb[9] = {{0}};
+        pa[0] = pb[0] = unibi_var_from_num((int)i * 37);
+        pa[1] = pb[1] = unibi_var_from_num(200 - (int)i);
+        pa[2] = pb[2] = unibi_var_from_str((char *)"a string argument");
+        n += unibi_run(fmts[i], pa, expect + n, sizeof expect - n);
+        if (compiled) {
+            unibi_prog *prog = unibi_compile(fmts[i]);
+            if (!prog || unibi_exec_buf(&b, prog, pb) != 0) {
+                r = 0;
+            }
+            unibi_prog_destroy(prog);
+        } else if (unibi_format_buf(&b, fmts[i], pb) != 0) {
+            r = 0;
+        }
+    }
+    r = r && b.len == n && memcmp(b.data, expect, n) == 0 && b.size >= b.len;
+    unibi_buf_free(&b);
+    return r;
+}
+
+int main(void) {
+    unibi_var_t param[9] = {{0}};
+    unibi_buf b;
+    size_t i;
+
+    plan(7);
+
+    ok(matches_run(0), "unibi_format_buf output equals unibi_run");
+    ok(matches_run(1), "unibi_exec_buf output equals unibi_run");
+
+    unibi_buf_init(&b);
+    ok(b.data == NULL && b.len == 0 && b.size == 0, "initialized empty");
+
+    for (i = 0; i < 1000; i++) {
+        param[0] = unibi_var_from_num((int)i);
+        if (unibi_format_buf(&b, "%p1%d,", param) != 0) {
+            break;
+        }
+    }
+    ok(i == 1000 && b.len == 3890 && memcmp(b.data + b.len - 4, "999,", 4) == 0, "grows as needed");
+
+    b.len = 0;
+    param[0] = unibi_var_from_num(7);
+    ok(unibi_format_buf(&b, "x%p1%dy", param) == 0 && b.len == 3 && memcmp(b.data, "x7y", 3) == 0, "reused after resetting len");
+    unibi_buf_free(&b);
+
+    unibi_buf_init(&b);
+    param[0] = unibi_var_from_str((char *)"");
+    ok(
+        unibi_format_buf(&b, "%s", param) == 0 &&
+        unibi_format_buf(&b, "%p1%s", param) == 0 &&
+        unibi_format_buf(&b, "%p1%.1s", param) == 0 &&
+        unibi_format_buf(&b, "", param) == 0 &&
+        b.len == 0,
+        "empty output into a fresh buffer"
+    );
+    ok(unibi_format_buf(&b, "%p1%sz", param) == 0 && b.len == 1 && b.data[0] == 'z', "output after empty output");
+    unibi_buf_free(&b);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <unibilium.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+/* unibi_run("%p1<spec>") must agree with printf("%<spec>") */
+static int agrees(const char *spec, const int *values, size_t nvalues) {
+    char fmt[32], cfmt[32], got[1024], want[1024];
+    size_t i;
+
+    snprintf(fmt, sizeof fmt, "%%p1%%%s", spec);
+    snprintf(cfmt, sizeof cfmt, "%%%s", spec + (*spec == ':'));
+    for (i = 0; i < nvalues; i++) {
+        unibi_var_t param[9] = {{0}};
+        size_t n;
+        int k;
+        param[0] = unibi_var_from_num(values[i]);
+        n = unibi_run(fmt, param, got, sizeof got);
+        k = snprintf(want, sizeof want, cfmt, values[i]);
+        if (k > 511) {
+            k = 511;
+        }
+        if (n != (size_t)k || memcmp(got, want, n) != 0) {
+            diag("%s with %d: got \"%.*s\", expected \"%s\"", fmt, values[i], (int)n, got, want);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    static const char *const specs[] = {
+        "d", "1d", "2d", "3d", "02d", "05d", "12d", "012d",
+        "x", "02x", "4x", "08x", "X", "02X", "06X",
+        ":-3d", ":+d", ".3d", "#x", "o",
+    };
+    int values[1100];
+    size_t i, n = 0;
+
+    plan((int)(sizeof specs / sizeof specs[0]) + 2);
+
+    for (i = 0; i < 1000; i++) {
+        values[n++] = (int)i;
+    }
+    values[n++] = -1;
+    values[n++] = -9;
+    values[n++] = -10;
+    values[n++] = -12345;
+    values[n++] = 65535;
+    values[n++] = 16777215;
+    values[n++] = 1000000000;
+    values[n++] = INT_MAX;
+    values[n++] = INT_MIN;
+    values[n++] = INT_MIN + 1;
+
+    for (i = 0; i < sizeof specs / sizeof specs[0]; i++) {
+        ok(agrees(specs[i], values, n), "%s agrees with printf", specs[i]);
+    }
+    ok(agrees("600d", values + 995, 10), "width beyond the buffer");
+    ok(agrees(":-05d", values, n), "left-justified zero padding");
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "test-simple.c.inc"
+
+static size_t gather(const unibi_iovbuf *v, char *p) {
+    size_t i, n = 0;
+    for (i = 0; i < v->iovcnt; i++) {
+        memcpy(p + n, v->iov[i].iov_base, v->iov[i].iov_len);
+        n += v->iov[i].iov_len;
+    }
+    return n;
+}
+
+int main(void) {
+    static const char sgr0[] = "\033(B\033[m";
+    static const char cup[] = "\033[%i%p1%d;%p2%dH";
+    static const char sgr[] = "%?%p9%t\033(0%e\033(B%;\033[0%?%p6%t;1%;%?%p2%t;4%;%?%p1%p3%|%t;7%;%?%p4%t;5%;%?%p7%t;8%;m";
+    struct iovec iov[16];
+    char scratch[32], got[256], want[256];
+    unibi_var_t param[9] = {{0}};
+    unibi_iovbuf v;
+    unibi_prog *prog;
+    size_t n;
+
+    plan(9);
+
+    v.iov = iov;
+    v.iovmax = sizeof iov / sizeof iov[0];
+    v.scratch = scratch;
+    v.scratch_size = sizeof scratch;
+    v.iovcnt = v.scratch_used = 0;
+
+    ok(unibi_format_iov(&v, sgr0, param) == 0 && v.iovcnt == 1 && v.iov[0].iov_base == (void *)sgr0 && v.scratch_used == 0, "plain string is referenced, not copied");
+
+    param[0] = unibi_var_from_num(4);
+    param[1] = unibi_var_from_num(79);
+    n = unibi_run(cup, param, want + sizeof sgr0 - 1, sizeof want - sizeof sgr0 + 1);
+    param[0] = unibi_var_from_num(4);
+    param[1] = unibi_var_from_num(79);
+    ok(unibi_format_iov(&v, cup, param) == 0, "cup");
+    ok(v.scratch_used == 3, "only the digits are in the scratch area");
+    memcpy(want, sgr0, sizeof sgr0 - 1);
+    n += sizeof sgr0 - 1;
+    ok(gather(&v, got) == n && memcmp(got, want, n) == 0, "gathered output");
+
+    v.iovcnt = v.scratch_used = 0;
+    param[0] = unibi_var_from_num(1);
+    param[1] = unibi_var_from_num(0);
+    param[5] = unibi_var_from_num(1);
+    n = unibi_run(sgr, param, want, sizeof want);
+    prog = unibi_compile(sgr);
+    if (!prog) {
+        bail_out(strerror(errno));
+    }
+    ok(unibi_exec_iov(&v, prog, param) == 0 && gather(&v, got) == n && memcmp(got, want, n) == 0 && v.scratch_used == 0, "compiled program");
+    unibi_prog_destroy(prog);
+
+    v.iovcnt = v.scratch_used = 0;
+    v.iovmax = 2;
+    errno = 0;
+    ok(unibi_format_iov(&v, cup, param) == -1 && errno == ENOBUFS, "out of iovec entries");
+    ok(v.iovcnt == 0 && v.scratch_used == 0, "state restored");
+
+    v.iovmax = sizeof iov / sizeof iov[0];
+    v.scratch_size = 2;
+    param[0] = unibi_var_from_num(123);
+    errno = 0;
+    ok(unibi_format_iov(&v, "%p1%d", param) == -1 && errno == ENOBUFS, "out of scratch space");
+
+    v.scratch_size = sizeof scratch;
+    param[0] = unibi_var_from_num(65);
+    ok(unibi_format_iov(&v, "%p1%c%p1%c", param) == 0 && v.iovcnt == 1 && v.iov[0].iov_len == 2, "adjacent scratch output is merged");
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+int main(void) {
+    unibi_term *a, *b;
+    uint64_t h;
+
+    plan(11);
+
+    a = unibi_dummy();
+    b = unibi_dummy();
+
+    h = unibi_hash(a);
+    ok(h == UINT64_C(0x5419b40c886bb6e0), "dummy hash is stable");
+    ok(unibi_hash(a) == h, "hash is repeatable");
+    ok(unibi_hash(b) == h, "equal objects have equal hashes");
+    ok(unibi_equal(a, b), "dummies are equal");
+
+    unibi_set_str(b, unibi_cursor_up, "\033[A");
+    ok(unibi_hash(b) != h, "hash changes with a string");
+    ok(!unibi_equal(a, b), "no longer equal");
+
+    unibi_set_str(a, unibi_cursor_up, "\033[A");
+    ok(unibi_equal(a, b), "equal again");
+
+    unibi_set_str(a, unibi_cursor_up, NULL);
+    unibi_set_str(a, unibi_cursor_up, "\033[A");
+    ok(unibi_equal(a, b), "setting the same value keeps equality");
+
+    unibi_add_ext_str(a, "Ss", "");
+    ok(!unibi_equal(a, b), "ext caps are compared");
+    unibi_add_ext_str(b, "Ss", "");
+    ok(unibi_equal(a, b) && unibi_hash(a) == unibi_hash(b), "ext caps are compared by value");
+
+    unibi_set_num(b, unibi_columns, 80);
+    ok(!unibi_equal(a, b), "numbers are compared");
+
+    unibi_destroy(a);
+    unibi_destroy(b);
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "test-simple.c.inc"
+
+static uint32_t buf[4096];
+
+static int fails_with(const char *p, size_t n, int e) {
+    unibi_term *ut;
+    errno = 0;
+    if ((ut = unibi_from_image(p, n))) {
+        unibi_destroy(ut);
+        return 0;
+    }
+    return errno == e;
+}
+
+int main(void) {
+    unibi_term *dt, *ut;
+    char *const p = (char *)buf;
+    const size_t nstrs = unibi_string_end_ - unibi_string_begin_ - 1;
+    const char *s;
+    size_t n, i;
+
+    plan(14);
+
+    dt = unibi_from_builtin("xterm-256color");
+    if (!dt) {
+        bail_out(strerror(errno));
+    }
+    unibi_set_num(dt, unibi_max_pairs, 65536);
+    unibi_add_ext_str(dt, "Xn", NULL);
+    unibi_add_ext_num(dt, "Xm", 1234567);
+
+    n = unibi_dump_image(dt, NULL, 0);
+    ok(n != (size_t)-1 && n % 4 == 0 && errno == EFAULT, "size query");
+    ok(n <= sizeof buf && unibi_dump_image(dt, p, sizeof buf) == n, "image written");
+
+    ut = unibi_from_image(p, n);
+    ok(ut != NULL, "image loaded");
+    if (!ut) {
+        bail_out(strerror(errno));
+    }
+    ok(unibi_equal(dt, ut), "round trip");
+    ok(unibi_get_num(ut, unibi_max_pairs) == 65536, "wide number");
+    s = unibi_get_str(ut, unibi_cursor_address);
+    ok(s > p && s < p + n, "strings point into the image");
+    ok(unibi_get_str_len(ut, unibi_cursor_address) == strlen(s), "string lengths are loaded");
+    ok(
+        unibi_get_ext_str(ut, unibi_count_ext_str(ut) - 1) == NULL &&
+        strcmp(unibi_get_ext_str_name(ut, unibi_count_ext_str(ut) - 1), "Xn") == 0,
+        "absent extended string"
+    );
+    unibi_destroy(ut);
+
+    ok(fails_with(p, n - 4, EFAULT), "truncated");
+    ok(fails_with(p + 4, n - 4, EINVAL), "shifted");
+    memmove(p + 1, p, n);
+    ok(fails_with(p + 1, n, EINVAL), "misaligned");
+    memmove(p, p + 1, n);
+    p[0] = 'U';
+    ok(fails_with(p, n, EINVAL), "bad magic");
+    p[0] = 'u';
+    /* the str_info array follows the string offsets */
+    for (i = 0; i < n / 4 && buf[i] != (uint32_t)(s - p); i++) {
+    }
+    buf[i + nstrs] += 2;
+    ok(fails_with(p, n, EINVAL), "string length past the terminator");
+    buf[i + nstrs] -= 2;
+    memset(p + n - 4, 'x', 4);
+    ok(fails_with(p, n, EINVAL), "unterminated string pool");
+
+    unibi_destroy(dt);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <unibilium.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "test-simple.c.inc"
+
+static char dir[] = "/tmp/unibi-install-XXXXXX";
+
+static int same_file(const char *a, const char *b) {
+    struct stat sa, sb;
+    return stat(a, &sa) == 0 && stat(b, &sb) == 0 && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+static unibi_term *read_back(const char *rel) {
+    char path[256];
+    sprintf(path, "%s/%s", dir, rel);
+    return unibi_from_file(path);
+}
+
+static void cleanup(void) {
+    const char *const files[] = {"f/foo", "f/foo-1", "62/bar", "62", "f", NULL};
+    char path[256];
+    size_t i;
+    for (i = 0; files[i]; i++) {
+        sprintf(path, "%s/%s", dir, files[i]);
+        if (unlink(path) < 0) {
+            rmdir(path);
+        }
+    }
+    rmdir(dir);
+}
+
+int main(void) {
+    const char *aliases[] = {"foo", "foo-1", NULL};
+    const char *bad[] = {"../evil", NULL};
+    char a[256], b[256];
+    unibi_term *ut, *rt;
+
+    plan(9);
+
+    if (!mkdtemp(dir)) {
+        bail_out(strerror(errno));
+    }
+
+    ut = unibi_dummy();
+    unibi_set_name(ut, "test terminal");
+    unibi_set_aliases(ut, aliases);
+    unibi_set_num(ut, unibi_columns, 80);
+
+    ok(unibi_install(dir, ut) == 0, "install succeeded");
+
+    rt = read_back("f/foo");
+    ok(rt && unibi_equal(ut, rt), "primary name reads back");
+    if (rt) {
+        unibi_destroy(rt);
+    }
+
+    sprintf(a, "%s/f/foo", dir);
+    sprintf(b, "%s/f/foo-1", dir);
+    ok(same_file(a, b), "alias is a hard link");
+
+    unibi_set_num(ut, unibi_columns, 132);
+    ok(unibi_install(dir, ut) == 0, "reinstall succeeded");
+    rt = read_back("f/foo-1");
+    ok(rt && unibi_get_num(rt, unibi_columns) == 132, "reinstall replaced the entry");
+    if (rt) {
+        unibi_destroy(rt);
+    }
+    ok(same_file(a, b), "alias is still a hard link");
+
+    sprintf(a, "%s/62", dir);
+    mkdir(a, 0755);
+    aliases[0] = "bar";
+    aliases[1] = NULL;
+    unibi_set_aliases(ut, aliases);
+    ok(unibi_install(dir, ut) == 0, "install into hex layout succeeded");
+    rt = read_back("62/bar");
+    ok(rt != NULL, "hex layout is used when present");
+    if (rt) {
+        unibi_destroy(rt);
+    }
+
+    unibi_set_aliases(ut, bad);
+    ok(unibi_install(dir, ut) < 0 && errno == EINVAL, "names with slashes are rejected");
+
+    unibi_destroy(ut);
+    cleanup();
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static unibi_param_bound bounds[9];
+
+static void set_bounds(int min, int max, size_t max_len) {
+    size_t i;
+    for (i = 0; i < 9; i++) {
+        bounds[i].min = min;
+        bounds[i].max = max;
+        bounds[i].max_len = max_len;
+    }
+}
+
+/* no choice of parameters at the ends or in the middle of their ranges gets
+ * past the bound */
+static int holds(const char *fmt) {
+    const size_t bound = unibi_max_output_len(fmt, bounds);
+    char buf[1024];
+    int k;
+
+    for (k = 0; k < 3 * 3 * 3; k++) {
+        unibi_var_t param[9];
+        int i, c = k;
+        for (i = 0; i < 9; i++) {
+            const int which = i < 3 ? c % 3 : (k + i) % 3;
+            if (i < 3) {
+                c /= 3;
+            }
+            param[i] = unibi_var_from_num(
+                which == 0 ? bounds[i].min :
+                which == 1 ? bounds[i].max :
+                bounds[i].min + (bounds[i].max - bounds[i].min) / 2
+            );
+        }
+        if (unibi_run(fmt, param, buf, sizeof buf) > bound) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int all_hold(const unibi_term *ut) {
+    int i;
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        const char *s = unibi_get_str(ut, i);
+        if (s && !holds(s)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    const size_t nbuiltin = unibi_count_builtin();
+    size_t i;
+
+    plan(12 + nbuiltin);
+
+    set_bounds(0, 255, 0);
+    ok(unibi_max_output_len("\033[H\033[2J$<50>", bounds) == 7, "literal text, no padding");
+    ok(unibi_max_output_len("\033[%i%p1%d;%p2%dH", bounds) == 10, "cup with increment");
+    ok(
+        unibi_max_output_len("\033[%?%p1%{8}%<%t3%p1%d%e%p1%{16}%<%t9%p1%{8}%-%d%e38;5;%p1%d%;m", bounds) == 11,
+        "longest branch of setaf"
+    );
+    ok(unibi_max_output_len("%p1%{2}%*%d", bounds) == 3, "arithmetic on ranges");
+    ok(unibi_max_output_len("%p1%:-8d|%p1%#x|%p1%.4o", bounds) == 8 + 1 + 4 + 1 + 4, "widths, prefixes and precision");
+    ok(unibi_max_output_len("%p1%c%p1%c", bounds) == 2, "characters");
+    ok(unibi_max_output_len("%{1}%Pa%?%ga%t%p1%d%e%p1%1000d%;", bounds) == 3, "known condition");
+    ok(unibi_max_output_len("%p1%1000d", bounds) == 511, "output codes are limited");
+
+    set_bounds(-5, 5, 12);
+    ok(unibi_max_output_len("%p1%s%p1%l%d", bounds) == 12 + 2, "string parameters");
+    ok(unibi_max_output_len("%p1%d", bounds) == 11, "string parameters have numeric value INT_MIN");
+    ok(unibi_max_output_len("%p1%p2%+%d", NULL) == 11, "no bounds");
+    ok(unibi_max_output_len("%p1%s", NULL) == 0, "no string parameters without bounds");
+
+    for (i = 0; i < nbuiltin; i++) {
+        const char *name = unibi_builtin_name(i);
+        unibi_term *ut = unibi_from_builtin(name);
+        if (!ut) {
+            bail_out(strerror(errno));
+        }
+        set_bounds(0, 300, 0);
+        ok(all_hold(ut), "%s: bounds hold", name);
+        unibi_destroy(ut);
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static int same_params(const unibi_var_t *a, const unibi_var_t *b) {
+    int i;
+    for (i = 0; i < 9; i++) {
+        if (
+            unibi_num_from_var(a[i]) != unibi_num_from_var(b[i]) ||
+            strcmp(unibi_str_from_var(a[i]), unibi_str_from_var(b[i])) != 0
+        ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* repeated calls through the cache give the same output and leave the same
+ * parameters behind as calls without it */
+static int agrees(unibi_term *cached, unibi_term *plain, enum unibi_string cap, int rounds) {
+    char a[256], b[256];
+    int r, k;
+
+    for (r = 0; r < rounds; r++) {
+        for (k = 0; k < 40; k++) {
+            unibi_var_t pa[9], pb[9];
+            size_t na, nb, i;
+            for (i = 0; i < 9; i++) {
+                pa[i] = pb[i] = unibi_var_from_num((k * 7 + (int)i * 13) % (k % 3 ? 24 : 300));
+            }
+            na = unibi_run_str(cached, cap, pa, a, sizeof a);
+            nb = unibi_run_str(plain, cap, pb, b, sizeof b);
+            if (na != nb || memcmp(a, b, na) != 0 || !same_params(pa, pb)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    static const enum unibi_string caps[] = {
+        unibi_cursor_address,
+        unibi_set_a_foreground,
+        unibi_set_a_background,
+        unibi_change_scroll_region,
+        unibi_set_attributes,
+        unibi_parm_down_cursor,
+    };
+    unibi_term *ut, *ref;
+    unibi_var_t param[9] = {{0}};
+    char buf[64];
+    size_t i;
+
+    plan(15);
+
+    if (!(ut = unibi_from_builtin("xterm-256color")) || !(ref = unibi_from_builtin("xterm-256color"))) {
+        bail_out(strerror(errno));
+    }
+
+    ok(unibi_set_memo_size(ut, 16) == 0, "cache enabled");
+    for (i = 0; i < sizeof caps / sizeof caps[0]; i++) {
+        ok(agrees(ut, ref, caps[i], 3), "%s: cached output matches", unibi_name_str(caps[i]));
+    }
+
+    unibi_set_str(ut, unibi_column_address, "%p1%Pa%ga%d");
+    unibi_set_str(ref, unibi_column_address, "%p1%Pa%ga%d");
+    ok(agrees(ut, ref, unibi_column_address, 2), "string using variables");
+
+    unibi_set_str(ut, unibi_cursor_address, "[%p1%d,%p2%d]");
+    param[0] = unibi_var_from_num(3);
+    param[1] = unibi_var_from_num(4);
+    ok(
+        unibi_run_str(ut, unibi_cursor_address, param, buf, sizeof buf) == 5 && memcmp(buf, "[3,4]", 5) == 0,
+        "cache flushed by set"
+    );
+    ok(
+        unibi_run_str(ut, unibi_cursor_address, param, buf, sizeof buf) == 5 &&
+        unibi_num_from_var(param[0]) == 3 && unibi_num_from_var(param[1]) == 4,
+        "changed string no longer increments"
+    );
+
+    ok(unibi_set_memo_size(ut, 1) == 0, "cache resized");
+    ok(agrees(ut, ref, unibi_set_a_foreground, 2), "cache of one entry");
+
+    errno = 0;
+    ok(unibi_set_memo_size(ut, (size_t)-1) == -1 && errno == EINVAL, "huge cache rejected");
+    ok(agrees(ut, ref, unibi_set_a_foreground, 1), "old cache kept");
+
+    ok(unibi_set_memo_size(ut, 0) == 0, "cache disabled");
+
+    unibi_destroy(ref);
+    unibi_destroy(ut);
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static char buf_a[4096], buf_b[4096];
+
+static int same_dump(const unibi_term *a, const unibi_term *b) {
+    const size_t n = unibi_dump(a, buf_a, sizeof buf_a);
+    return
+        n <= sizeof buf_a &&
+        unibi_dump(b, buf_b, sizeof buf_b) == n &&
+        memcmp(buf_a, buf_b, n) == 0;
+}
+
+static void count_diff(void *ctx, enum unibi_diff_op op, enum unibi_cap_type type, int cap, size_t ia, size_t ib) {
+    (void)op;
+    (void)type;
+    (void)cap;
+    (void)ia;
+    (void)ib;
+    ++*(size_t *)ctx;
+}
+
+int main(void) {
+    unibi_term *base, *delta, *ov, *merged, *top, *cursor;
+    size_t ndiff;
+
+    plan(18);
+
+    base = unibi_dummy();
+    delta = unibi_dummy();
+    merged = unibi_dummy();
+    if (!base || !delta || !merged) {
+        bail_out(strerror(errno));
+    }
+
+    unibi_set_name(base, "base terminal");
+    unibi_set_bool(base, unibi_auto_right_margin, 1);
+    unibi_set_num(base, unibi_columns, 80);
+    unibi_set_num(base, unibi_lines, 24);
+    unibi_set_str(base, unibi_bell, "\007");
+    unibi_set_str(base, unibi_clear_screen, "\033[H\033[2J");
+    unibi_add_ext_bool(base, "AX", 1);
+    unibi_add_ext_num(base, "RGB", 8);
+    unibi_add_ext_str(base, "Ss", "\033[%p1%d q");
+
+    unibi_set_bool(delta, unibi_back_color_erase, 1);
+    unibi_set_num(delta, unibi_columns, 132);
+    unibi_set_str(delta, unibi_bell, "");
+    unibi_add_ext_bool(delta, "RGB", 1);
+    unibi_add_ext_str(delta, "Ss", "\033[2 q");
+
+    ov = unibi_overlay(base, delta);
+    ok(ov != NULL, "overlay created");
+    if (!ov) {
+        bail_out(strerror(errno));
+    }
+
+    ok(strcmp(unibi_get_name(ov), "base terminal") == 0, "name from base");
+    ok(unibi_get_bool(ov, unibi_auto_right_margin) && unibi_get_bool(ov, unibi_back_color_erase), "booleans from both");
+    ok(unibi_get_num(ov, unibi_columns) == 132 && unibi_get_num(ov, unibi_lines) == 24, "delta number wins");
+    ok(strcmp(unibi_get_str(ov, unibi_bell), "") == 0, "empty string disables base string");
+    ok(strcmp(unibi_get_str(ov, unibi_clear_screen), "\033[H\033[2J") == 0, "string from base");
+
+    ok(
+        unibi_count_ext_bool(ov) == 2 &&
+        strcmp(unibi_get_ext_bool_name(ov, 0), "RGB") == 0 &&
+        strcmp(unibi_get_ext_bool_name(ov, 1), "AX") == 0 &&
+        unibi_get_ext_bool(ov, 1) == 1,
+        "extended booleans, delta first"
+    );
+    ok(unibi_count_ext_num(ov) == 0, "extended number hidden by name of another type");
+    ok(
+        unibi_count_ext_str(ov) == 1 &&
+        strcmp(unibi_get_ext_str_name(ov, 0), "Ss") == 0 &&
+        strcmp(unibi_get_ext_str(ov, 0), "\033[2 q") == 0,
+        "extended string replaced"
+    );
+
+    unibi_set_name(merged, "base terminal");
+    unibi_set_bool(merged, unibi_auto_right_margin, 1);
+    unibi_set_bool(merged, unibi_back_color_erase, 1);
+    unibi_set_num(merged, unibi_columns, 132);
+    unibi_set_num(merged, unibi_lines, 24);
+    unibi_set_str(merged, unibi_bell, "");
+    unibi_set_str(merged, unibi_clear_screen, "\033[H\033[2J");
+    unibi_add_ext_bool(merged, "RGB", 1);
+    unibi_add_ext_bool(merged, "AX", 1);
+    unibi_add_ext_str(merged, "Ss", "\033[2 q");
+
+    ok(unibi_equal(ov, merged) && unibi_equal(merged, ov), "equal to merged copy");
+    ok(unibi_hash(ov) == unibi_hash(merged), "same hash as merged copy");
+    ok(same_dump(ov, merged), "same dump as merged copy");
+    ndiff = 0;
+    ok(unibi_diff(ov, merged, count_diff, &ndiff) == 0 && ndiff == 0, "no diff to merged copy");
+    ndiff = 0;
+    ok(unibi_diff(base, ov, count_diff, &ndiff) == 0 && ndiff == 6, "diff to base");
+
+    cursor = unibi_dummy();
+    if (!cursor) {
+        bail_out(strerror(errno));
+    }
+    unibi_add_ext_str(cursor, "Se", "\033[0 q");
+    top = unibi_overlay(ov, cursor);
+    ok(top != NULL, "overlay of an overlay");
+    if (!top) {
+        bail_out(strerror(errno));
+    }
+    ok(
+        unibi_count_ext_str(top) == 2 &&
+        strcmp(unibi_get_ext_str_name(top, 1), "Ss") == 0 &&
+        unibi_get_num(top, unibi_columns) == 132,
+        "nested lookup"
+    );
+    unibi_add_ext_str(merged, "Se", "\033[0 q");
+    ok(!unibi_equal(top, merged), "order of extended capabilities matters");
+
+    unibi_destroy(top);
+    unibi_destroy(ov);
+    ok(unibi_get_num(base, unibi_columns) == 80 && unibi_count_ext_num(base) == 1, "base untouched");
+
+    unibi_destroy(cursor);
+    unibi_destroy(merged);
+    unibi_destroy(delta);
+    unibi_destroy(base);
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <unibilium.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static const char *sig(enum unibi_string s) {
+    static char buf[10];
+    size_t i, n = unibi_count_params_str(s);
+    for (i = 0; i < n && i < sizeof buf - 1; i++) {
+        switch (unibi_param_type_str(s, i)) {
+            case unibi_param_num: buf[i] = 'n'; break;
+            case unibi_param_str: buf[i] = 's'; break;
+            case unibi_param_none: buf[i] = '-'; break;
+        }
+    }
+    buf[i] = '\0';
+    return buf;
+}
+
+#define is_sig(S, E) ok(strcmp(sig(unibi_ ## S), E) == 0, "%s = \"%s\"", #S, E)
+
+int main(void) {
+    plan(12);
+
+    is_sig(bell, "");
+    is_sig(clr_eol, "");
+    is_sig(cursor_address, "nn");
+    is_sig(parm_up_cursor, "n");
+    is_sig(set_a_foreground, "n");
+    is_sig(set_attributes, "nnnnnnnnn");
+    is_sig(initialize_pair, "nnnnnnn");
+    is_sig(dial_phone, "s");
+    is_sig(pkey_key, "ns");
+    is_sig(pkey_plab, "nss");
+
+    ok(unibi_param_type_str(unibi_cursor_address, 2) == unibi_param_none, "cursor_address has no third parameter");
+    ok(unibi_param_type_str(unibi_bell, 0) == unibi_param_none, "bell has no parameters");
+
+    return 0;
+}
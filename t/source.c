@@ -0,0 +1,111 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static const char src[] =
+    "# a comment\n"
+    "derived|alias2|derived terminal,\n"
+    "\tbce, cols#132, lines@,\n"
+    "# a comment inside the entry\n"
+    "\tbel=^G, clear=\\E[H\\E[2J, cr=\\r, cuf1=\\s,\n"
+    "\tkbs=^?, sgr0=\\E[m\\017, dsl=\\054\\:\\0,\n"
+    "\tSs=\\E[%p1%d q, Tc, AX@, U8#0x1,\n"
+    "\tuse=base,\n"
+    "base|base terminal,\n"
+    "\tam, bce@, cols#80, lines#24, it#010,\n"
+    "\tbel=\\E[bell, flash=\\E[?5h\\E[?5l,\n"
+    "\tAX, Se=\\E[2 q, U8#0,\n";
+
+static const unibi_term *resolve_none(void *ctx, const char *name) {
+    (void)ctx;
+    (void)name;
+    return NULL;
+}
+
+static const unibi_term *resolve_dummy(void *ctx, const char *name) {
+    return strcmp(name, "elsewhere") == 0 ? ctx : NULL;
+}
+
+static int is_error(const char *text, const unibi_term *(*resolve)(void *, const char *), void *ctx, int e) {
+    unibi_term *ut;
+    errno = 0;
+    ut = unibi_from_source(text, strlen(text), resolve, ctx);
+    if (ut) {
+        unibi_destroy(ut);
+        return 0;
+    }
+    return errno == e;
+}
+
+int main(void) {
+    unibi_term *ut, *dt;
+    const char **aliases;
+
+    plan(24);
+
+    ut = unibi_from_source(src, sizeof src - 1, resolve_none, NULL);
+    ok(ut != NULL, "source parsed");
+    if (!ut) {
+        bail_out(strerror(errno));
+    }
+
+    ok(strcmp(unibi_get_name(ut), "derived terminal") == 0, "name");
+    aliases = unibi_get_aliases(ut);
+    ok(
+        aliases[0] && strcmp(aliases[0], "derived") == 0 &&
+        aliases[1] && strcmp(aliases[1], "alias2") == 0 &&
+        !aliases[2],
+        "aliases"
+    );
+
+    ok(unibi_get_bool(ut, unibi_back_color_erase), "own boolean overrides cancellation in use");
+    ok(unibi_get_bool(ut, unibi_auto_right_margin), "boolean inherited");
+    ok(unibi_get_num(ut, unibi_columns) == 132, "own number overrides use");
+    ok(unibi_get_num(ut, unibi_lines) == -1, "cancelled number is not inherited");
+    ok(unibi_get_num(ut, unibi_init_tabs) == 8, "octal number inherited");
+
+    ok(strcmp(unibi_get_str(ut, unibi_bell), "\007") == 0, "^G and override");
+    ok(strcmp(unibi_get_str(ut, unibi_clear_screen), "\033[H\033[2J") == 0, "\\E");
+    ok(strcmp(unibi_get_str(ut, unibi_carriage_return), "\r") == 0, "\\r");
+    ok(strcmp(unibi_get_str(ut, unibi_cursor_right), " ") == 0, "\\s");
+    ok(strcmp(unibi_get_str(ut, unibi_key_backspace), "\177") == 0, "^?");
+    ok(strcmp(unibi_get_str(ut, unibi_exit_attribute_mode), "\033[m\017") == 0, "octal escape");
+    ok(strcmp(unibi_get_str(ut, unibi_dis_status_line), ",:\200") == 0, "\\054, \\: and \\0");
+    ok(strcmp(unibi_get_str(ut, unibi_flash_screen), "\033[?5h\033[?5l") == 0, "string inherited");
+
+    ok(
+        unibi_count_ext_bool(ut) == 1 && strcmp(unibi_get_ext_bool_name(ut, 0), "Tc") == 0,
+        "extended boolean, cancelled one not inherited"
+    );
+    ok(
+        unibi_count_ext_num(ut) == 1 && unibi_get_ext_num(ut, 0) == 1,
+        "extended number overrides use"
+    );
+    ok(
+        unibi_count_ext_str(ut) == 2 &&
+        strcmp(unibi_get_ext_str(ut, 0), "\033[%p1%d q") == 0 &&
+        strcmp(unibi_get_ext_str_name(ut, 1), "Se") == 0,
+        "extended strings, own first"
+    );
+    unibi_destroy(ut);
+
+    dt = unibi_dummy();
+    unibi_set_num(dt, unibi_columns, 100);
+    {
+        static const char t[] = "x|x term,\n\tuse=elsewhere,\n";
+        ut = unibi_from_source(t, sizeof t - 1, resolve_dummy, dt);
+        ok(ut && unibi_get_num(ut, unibi_columns) == 100, "resolver is used");
+        if (ut) {
+            unibi_destroy(ut);
+        }
+    }
+    unibi_destroy(dt);
+
+    ok(is_error("a|a,\n\tuse=b,\nb|b,\n\tuse=a,\n", resolve_none, NULL, ELOOP), "use loop");
+    ok(is_error("a|a,\n\tuse=nowhere,\n", resolve_none, NULL, ENOENT), "missing use");
+    ok(is_error("a|a,\n\tcols=80,\n", resolve_none, NULL, EINVAL), "type mismatch");
+    ok(is_error("# nothing here\n", resolve_none, NULL, EINVAL), "no entries");
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+/* lengths and plain output agree with strlen and unibi_run for every string */
+static int agrees(unibi_term *ut) {
+    char a[4096], b[4096];
+    int i;
+
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        const char *s = unibi_get_str(ut, i);
+        unibi_var_t param[9] = {{0}};
+        size_t na, nb;
+
+        if (!s) {
+            if (unibi_get_str_len(ut, i) != (size_t)-1 || unibi_run_str(ut, i, NULL, a, sizeof a) != 0) {
+                return 0;
+            }
+            continue;
+        }
+        if (unibi_get_str_len(ut, i) != strlen(s)) {
+            return 0;
+        }
+        na = unibi_run_str(ut, i, NULL, a, sizeof a);
+        nb = unibi_run(s, param, b, sizeof b);
+        if (na != nb || memcmp(a, b, na < sizeof a ? na : sizeof a) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    const size_t nbuiltin = unibi_count_builtin();
+    unibi_term *ut, *delta, *ov;
+    unibi_var_t param[9] = {{0}};
+    const unibi_prog *prog;
+    char buf[16];
+    size_t i;
+
+    plan(19 + nbuiltin);
+
+    for (i = 0; i < nbuiltin; i++) {
+        const char *name = unibi_builtin_name(i);
+        if (!(ut = unibi_from_builtin(name))) {
+            bail_out(strerror(errno));
+        }
+        ok(agrees(ut) && unibi_compile_strs(ut) == 0 && agrees(ut), "%s: lengths and output match", name);
+        unibi_destroy(ut);
+    }
+
+    ut = unibi_dummy();
+    if (!ut) {
+        bail_out(strerror(errno));
+    }
+    ok(unibi_get_str_len(ut, unibi_bell) == (size_t)-1, "absent string has no length");
+    ok(unibi_run_str(ut, unibi_bell, NULL, buf, sizeof buf) == 0, "absent string outputs nothing");
+
+    unibi_set_str(ut, unibi_bell, "\007");
+    unibi_set_str(ut, unibi_clear_screen, "\033[H\033[2J");
+    unibi_set_str(ut, unibi_flash_screen, "\033[?5h$<100/>\033[?5l");
+    unibi_set_str(ut, unibi_column_address, "\033[%i%p1%dG");
+    unibi_set_str(ut, unibi_carriage_return, "$10");
+    ok(unibi_get_str_len(ut, unibi_clear_screen) == 7, "length after set");
+
+    ok(
+        unibi_run_str(ut, unibi_clear_screen, NULL, buf, 3) == 7 && memcmp(buf, "\033[H", 3) == 0,
+        "plain string truncated to the buffer"
+    );
+    ok(
+        unibi_run_str(ut, unibi_flash_screen, NULL, buf, sizeof buf) == 10 &&
+        memcmp(buf, "\033[?5h\033[?5l", 10) == 0,
+        "padding is interpreted"
+    );
+    ok(
+        unibi_run_str(ut, unibi_carriage_return, NULL, buf, sizeof buf) == 3 && memcmp(buf, "$10", 3) == 0,
+        "lone dollar sign is plain"
+    );
+    param[0] = unibi_var_from_num(41);
+    ok(
+        unibi_run_str(ut, unibi_column_address, param, buf, sizeof buf) == 5 && memcmp(buf, "\033[42G", 5) == 0,
+        "parameters are interpreted"
+    );
+
+    unibi_set_str(ut, unibi_clear_screen, "\033[H");
+    ok(unibi_get_str_len(ut, unibi_clear_screen) == 3, "length updated by a second set");
+
+    ok(unibi_get_str_prog(ut, unibi_column_address) == NULL, "no programs until compiled");
+    ok(unibi_compile_strs(ut) == 0, "programs compiled");
+    ok(unibi_get_str_prog(ut, unibi_cursor_address) == NULL, "absent string has no program");
+    prog = unibi_get_str_prog(ut, unibi_column_address);
+    ok(prog != NULL && unibi_get_str_prog(ut, unibi_column_address) == prog, "program is kept");
+    unibi_set_str(ut, unibi_column_address, "%p1%d|");
+    param[0] = unibi_var_from_num(41);
+    ok(
+        unibi_get_str_prog(ut, unibi_column_address) != NULL &&
+        unibi_run_str(ut, unibi_column_address, param, buf, sizeof buf) == 3 && memcmp(buf, "41|", 3) == 0,
+        "program replaced by set"
+    );
+    unibi_set_str(ut, unibi_column_address, NULL);
+    ok(unibi_get_str_prog(ut, unibi_column_address) == NULL, "program dropped by unset");
+
+    delta = unibi_dummy();
+    if (!delta) {
+        bail_out(strerror(errno));
+    }
+    unibi_set_str(delta, unibi_bell, "%p1%c");
+    ov = unibi_overlay(ut, delta);
+    if (!ov) {
+        bail_out(strerror(errno));
+    }
+    ok(unibi_get_str_len(ov, unibi_clear_screen) == 3, "overlay length from the base");
+    param[0] = unibi_var_from_num('x');
+    ok(
+        unibi_run_str(ov, unibi_bell, param, buf, sizeof buf) == 1 && buf[0] == 'x',
+        "overlay string from the delta"
+    );
+    ok(
+        unibi_get_str_prog(ov, unibi_clear_screen) == unibi_get_str_prog(ut, unibi_clear_screen) &&
+        unibi_get_str_prog(ov, unibi_bell) == NULL,
+        "overlay uses the programs of the base"
+    );
+    ok(
+        unibi_compile_strs(ov) == 0 &&
+        unibi_get_str_prog(ov, unibi_bell) != NULL &&
+        unibi_get_str_prog(delta, unibi_bell) == NULL,
+        "overlay compiles into itself"
+    );
+    param[0] = unibi_var_from_num('y');
+    ok(
+        unibi_run_str(ov, unibi_bell, param, buf, sizeof buf) == 1 && buf[0] == 'y',
+        "overlay runs its own program"
+    );
+
+    unibi_destroy(ov);
+    unibi_destroy(delta);
+    unibi_destroy(ut);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+static const char db[] =
+    "# a comment\n"
+    "\n"
+    "dt|derived|derived terminal:\\\n"
+    "\t:ut:co#132:li@:..cl=disabled:\\\n"
+    "\t:cl=50\\E[H\\E[J:ce=3.5*\\E[K:cr=^M:\\\n"
+    "\t:cm=\\E[%i%d;%dH:CM=\\E=%r%+ %+ :\\\n"
+    "\t:cv=%>2^A%d:ch=%B%.:LE=%D%d\\:%%:\\\n"
+    "\t:Qz=\\E]zz:Qy:Qx@:tc=base:\n"
+    "base|base terminal:\\\n"
+    ":am:bs:ut@:co#80:li#24:it#010:\\\n"
+    ":bl=^G:vb=\\E[?5h\\E[?5l:Qx:\n"
+    "l1|loop 1:tc=l2:\n"
+    "l2|loop 2:tc=l1:\n"
+    "m|missing:tc=nowhere:\n";
+
+static int is_error(const unibi_termcap *tc, const char *name, int e) {
+    unibi_term *ut;
+    errno = 0;
+    ut = unibi_termcap_get(tc, name);
+    if (ut) {
+        unibi_destroy(ut);
+        return 0;
+    }
+    return errno == e;
+}
+
+static int goes_to(const char *cap, int col, int row, const char *expected) {
+    char buf[64];
+    const size_t n = unibi_tgoto(cap, col, row, buf, sizeof buf);
+    return n == strlen(expected) && memcmp(buf, expected, n) == 0;
+}
+
+int main(void) {
+    unibi_termcap *tc;
+    unibi_term *ut;
+    const char **aliases;
+
+    plan(30);
+
+    ok(unibi_find_termcap("co", unibi_cap_num) == unibi_columns, "find termcap number");
+    ok(unibi_find_termcap("co", unibi_cap_str) == -1, "termcap code of the wrong type");
+    ok(unibi_find_termcap("ML", unibi_cap_str) == unibi_set_left_margin, "shared code goes to the first capability");
+    ok(strcmp(unibi_termcap_name_str(unibi_cursor_address), "cm") == 0, "termcap name");
+
+    tc = unibi_termcap_from_mem(db, sizeof db - 1);
+    ok(tc != NULL, "database indexed");
+    if (!tc) {
+        bail_out(strerror(errno));
+    }
+
+    ut = unibi_termcap_get(tc, "derived");
+    ok(ut != NULL, "entry found by alias");
+    if (!ut) {
+        bail_out(strerror(errno));
+    }
+
+    ok(strcmp(unibi_get_name(ut), "derived terminal") == 0, "name");
+    aliases = unibi_get_aliases(ut);
+    ok(
+        aliases[0] && strcmp(aliases[0], "dt") == 0 &&
+        aliases[1] && strcmp(aliases[1], "derived") == 0 &&
+        !aliases[2],
+        "aliases"
+    );
+
+    ok(unibi_get_bool(ut, unibi_back_color_erase), "own boolean overrides cancellation in tc");
+    ok(unibi_get_bool(ut, unibi_auto_right_margin), "boolean inherited");
+    ok(unibi_get_num(ut, unibi_columns) == 132, "own number overrides tc");
+    ok(unibi_get_num(ut, unibi_lines) == -1, "cancelled number is not inherited");
+    ok(unibi_get_num(ut, unibi_init_tabs) == 8, "octal number inherited");
+
+    ok(strcmp(unibi_get_str(ut, unibi_clear_screen), "\033[H\033[J$<50>") == 0, "padding and commented out field");
+    ok(strcmp(unibi_get_str(ut, unibi_clr_eol), "\033[K$<3.5*>") == 0, "fractional padding");
+    ok(strcmp(unibi_get_str(ut, unibi_carriage_return), "\r") == 0, "^M");
+    ok(strcmp(unibi_get_str(ut, unibi_flash_screen), "\033[?5h\033[?5l") == 0, "string inherited");
+    ok(strcmp(unibi_get_str(ut, unibi_cursor_left), "\b") == 0, "bs implies cub1");
+
+    ok(goes_to(unibi_get_str(ut, unibi_cursor_address), 4, 9, "\033[10;5H"), "tgoto with increment");
+    ok(goes_to(unibi_get_str(ut, unibi_cursor_mem_address), 4, 9, "\033=$)"), "tgoto with reversed parameters and offsets");
+    ok(
+        goes_to(unibi_get_str(ut, unibi_row_address), 0, 60, "61") &&
+        goes_to(unibi_get_str(ut, unibi_row_address), 0, 40, "40"),
+        "conditional offset"
+    );
+    ok(
+        strcmp(unibi_get_str(ut, unibi_row_address), "%p1%Pa%?%ga%{50}%>%t%ga%{1}%+%e%ga%;%d") == 0,
+        "conditional offset leaves one value on the stack"
+    );
+    ok(goes_to(unibi_get_str(ut, unibi_column_address), 0, 12, "\022"), "BCD");
+    ok(goes_to(unibi_get_str(ut, unibi_parm_left_cursor), 0, 20, "12:%"), "reverse coding, escaped colon and percent");
+
+    ok(
+        unibi_count_ext_bool(ut) == 1 && strcmp(unibi_get_ext_bool_name(ut, 0), "Qy") == 0,
+        "unknown boolean, cancelled one not inherited"
+    );
+    ok(
+        unibi_count_ext_str(ut) == 1 && strcmp(unibi_get_ext_str(ut, 0), "\033]zz") == 0,
+        "unknown string"
+    );
+    unibi_destroy(ut);
+
+    ok(is_error(tc, "l1", ELOOP), "tc loop");
+    ok(is_error(tc, "missing", ENOENT), "missing tc");
+    ok(is_error(tc, "nothing", ENOENT), "unknown entry");
+    unibi_termcap_destroy(tc);
+
+    errno = 0;
+    ok(!unibi_termcap_from_mem("# nothing here\n", 15) && errno == EINVAL, "no entries");
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <unibilium.h>
+#include <errno.h>
+#include <string.h>
+#include "test-simple.c.inc"
+
+struct sink {
+    char buf[4096];
+    size_t used;
+    int fail;
+};
+
+static int collect(void *ctx, const char *p, size_t n) {
+    struct sink *s = ctx;
+    if (s->fail || s->used + n > sizeof s->buf) {
+        return -1;
+    }
+    memcpy(s->buf + s->used, p, n);
+    s->used += n;
+    return 0;
+}
+
+static const char expected[] =
+    "t1|t2|test terminal,\n"
+    "\tam,\n"
+    "\tTc,\n"
+    "\tcols#80,\n"
+    "\tU8#1,\n"
+    "\tbel=^G,\n"
+    "\tcuf1=\\s,\n"
+    "\tsgr0=\\E[m^O\\,\\^\\\\\\n\\200,\n"
+    "\tkbs=^?,\n"
+    "\tSs=\\E[%p1%d q,\n";
+
+int main(void) {
+    const char *aliases[] = {"t1", "t2", NULL};
+    struct sink s;
+    unibi_term *ut, *rt;
+    size_t r;
+
+    plan(7);
+
+    ut = unibi_dummy();
+    unibi_set_name(ut, "test terminal");
+    unibi_set_aliases(ut, aliases);
+    unibi_set_bool(ut, unibi_auto_right_margin, 1);
+    unibi_set_num(ut, unibi_columns, 80);
+    unibi_set_str(ut, unibi_bell, "\007");
+    unibi_set_str(ut, unibi_cursor_right, " ");
+    unibi_set_str(ut, unibi_key_backspace, "\177");
+    unibi_set_str(ut, unibi_exit_attribute_mode, "\033[m\017,^\\\n\200");
+    unibi_add_ext_bool(ut, "Tc", 1);
+    unibi_add_ext_bool(ut, "XX", 0);
+    unibi_add_ext_num(ut, "U8", 1);
+    unibi_add_ext_num(ut, "XN", -1);
+    unibi_add_ext_str(ut, "Ss", "\033[%p1%d q");
+    unibi_add_ext_str(ut, "XS", NULL);
+
+    s.used = 0;
+    s.fail = 0;
+    r = unibi_to_source(ut, collect, &s);
+    ok(r == sizeof expected - 1 && s.used == r, "size");
+    ok(memcmp(s.buf, expected, sizeof expected - 1) == 0, "contents");
+
+    rt = unibi_from_source(s.buf, s.used, NULL, NULL);
+    ok(rt != NULL, "output can be parsed");
+    unibi_del_ext_bool(ut, 1);
+    unibi_del_ext_num(ut, 1);
+    unibi_del_ext_str(ut, 1);
+    ok(rt && unibi_equal(ut, rt), "round trip (without the unset extended capabilities)");
+    if (rt) {
+        unibi_destroy(rt);
+    }
+
+    s.used = 0;
+    ok(unibi_to_source(ut, collect, &s) == s.used, "second run");
+
+    s.used = 0;
+    ok(
+        unibi_escape_str(" \033,x ", collect, &s) == 9 && memcmp(s.buf, "\\s\\E\\,x\\s", 9) == 0,
+        "single string"
+    );
+
+    s.fail = 1;
+    ok(unibi_to_source(ut, collect, &s) == (size_t)-1, "write errors are reported");
+
+    unibi_destroy(ut);
+
+    return 0;
+}
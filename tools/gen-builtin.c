@@ -0,0 +1,301 @@
+/* Generate unibuiltin-data.c.inc, the built-in terminal database for
+ * unibuiltin.c, from the compiled terminfo entries in one directory. */
+
+/*
+
+This file (it has no associated documentation) is under the MIT license:
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+#include <unibilium.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+
+static void print_str(const char *s) {
+    if (!s) {
+        fputs("NULL", stdout);
+        return;
+    }
+    putchar('"');
+    for (unsigned char c; (c = *s); s++) {
+        if (isprint(c) && c != '\\' && c != '"' && c != '?') {
+            putchar(c);
+        } else {
+            printf("\\%03o", (unsigned)c);
+        }
+    }
+    putchar('"');
+}
+
+struct name {
+    const char *name;
+    size_t entry;
+};
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(((const struct name *)a)->name, ((const struct name *)b)->name);
+}
+
+/* starts the array declaration before the first item, separates the others */
+static void begin_item(size_t *n, const char *type, size_t k, const char *what) {
+    if ((*n)++) {
+        puts(",");
+    } else {
+        printf("static %s b%zu_%s[] = {\n", type, k, what);
+    }
+}
+
+static void print_entry(size_t k, const unibi_term *ut) {
+    size_t i, n;
+
+    if (!strstr(unibi_get_name(ut), "*/")) {
+        printf("/* %s */\n\n", unibi_get_name(ut));
+    }
+
+    printf("static const char *b%zu_aliases[] = { ", k);
+    for (const char **a = unibi_get_aliases(ut); *a; a++) {
+        print_str(*a);
+        fputs(", ", stdout);
+    }
+    puts("NULL };");
+
+    n = 0;
+    for (i = unibi_boolean_begin_ + 1; i < unibi_boolean_end_; i++) {
+        if (unibi_get_bool(ut, i)) {
+            begin_item(&n, "const enum unibi_boolean", k, "bools");
+            printf("    unibi_%s", unibi_name_bool(i));
+        }
+    }
+    if (n) {
+        puts("\n};");
+    }
+    n = 0;
+    for (i = unibi_numeric_begin_ + 1; i < unibi_numeric_end_; i++) {
+        const int v = unibi_get_num(ut, i);
+        if (v >= 0) {
+            begin_item(&n, "const struct builtin_num", k, "nums");
+            printf("    { unibi_%s, %d }", unibi_name_num(i), v);
+        }
+    }
+    if (n) {
+        puts("\n};");
+    }
+    n = 0;
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        const char *const s = unibi_get_str(ut, i);
+        if (s) {
+            begin_item(&n, "const struct builtin_str", k, "strs");
+            printf("    { unibi_%s, ", unibi_name_str(i));
+            print_str(s);
+            fputs(" }", stdout);
+        }
+    }
+    if (n) {
+        puts("\n};");
+    }
+
+    if ((n = unibi_count_ext_bool(ut))) {
+        printf("static const struct builtin_ext_num b%zu_ext_bools[] = {\n", k);
+        for (i = 0; i < n; i++) {
+            fputs("    { ", stdout);
+            print_str(unibi_get_ext_bool_name(ut, i));
+            printf(", %d }%s\n", unibi_get_ext_bool(ut, i), i + 1 < n ? "," : "");
+        }
+        puts("};");
+    }
+    if ((n = unibi_count_ext_num(ut))) {
+        printf("static const struct builtin_ext_num b%zu_ext_nums[] = {\n", k);
+        for (i = 0; i < n; i++) {
+            fputs("    { ", stdout);
+            print_str(unibi_get_ext_num_name(ut, i));
+            printf(", %d }%s\n", unibi_get_ext_num(ut, i), i + 1 < n ? "," : "");
+        }
+        puts("};");
+    }
+    if ((n = unibi_count_ext_str(ut))) {
+        printf("static const struct builtin_ext_str b%zu_ext_strs[] = {\n", k);
+        for (i = 0; i < n; i++) {
+            fputs("    { ", stdout);
+            print_str(unibi_get_ext_str_name(ut, i));
+            fputs(", ", stdout);
+            print_str(unibi_get_ext_str(ut, i));
+            printf(" }%s\n", i + 1 < n ? "," : "");
+        }
+        puts("};");
+    }
+    puts("");
+}
+
+static size_t count_std(const unibi_term *ut, enum unibi_cap_type type) {
+    size_t i, n = 0;
+    switch (type) {
+        case unibi_cap_bool:
+            for (i = unibi_boolean_begin_ + 1; i < unibi_boolean_end_; i++) {
+                n += unibi_get_bool(ut, i) != 0;
+            }
+            break;
+        case unibi_cap_num:
+            for (i = unibi_numeric_begin_ + 1; i < unibi_numeric_end_; i++) {
+                n += unibi_get_num(ut, i) >= 0;
+            }
+            break;
+        case unibi_cap_str:
+            for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+                n += unibi_get_str(ut, i) != NULL;
+            }
+            break;
+    }
+    return n;
+}
+
+static void print_field(size_t k, const char *what, size_t n) {
+    if (n) {
+        printf("b%zu_%s, %zu", k, what, n);
+    } else {
+        fputs("NULL, 0", stdout);
+    }
+}
+
+/* Load term from dir only, never from the host's terminfo directories or
+ * the built-in database; tic uses either a letter or a hex subdirectory. */
+static unibi_term *load(const char *dir, const char *term) {
+    const size_t n = strlen(dir) + strlen(term) + 5;
+    char *path = malloc(n);
+    unibi_term *ut;
+
+    if (!path) {
+        return NULL;
+    }
+    snprintf(path, n, "%s/%c/%s", dir, term[0], term);
+    if (!(ut = unibi_from_file(path)) && errno == ENOENT) {
+        snprintf(path, n, "%s/%02x/%s", dir, (unsigned char)term[0], term);
+        ut = unibi_from_file(path);
+    }
+    free(path);
+    return ut;
+}
+
+int main(int argc, char **argv) {
+    unibi_term **terms;
+    struct name *names;
+    const char *dir, *source;
+    size_t nterms, nnames = 0;
+
+    if (argc < 6 || strcmp(argv[1], "-d") != 0 || strcmp(argv[3], "-s") != 0) {
+        fprintf(stderr, "Usage: %s -d TERMINFO_DIR -s SOURCE TERM...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    dir = argv[2];
+    source = argv[4];
+    argv += 4;
+    nterms = argc - 5;
+    if (!(terms = calloc(nterms, sizeof *terms))) {
+        perror("calloc()");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t k = 0; k < nterms; k++) {
+        if (!(terms[k] = load(dir, argv[k + 1]))) {
+            fprintf(stderr, "%s/%s: %s\n", dir, argv[k + 1], strerror(errno));
+            return EXIT_FAILURE;
+        }
+        nnames++;
+        for (const char **a = unibi_get_aliases(terms[k]); *a; a++) {
+            nnames++;
+        }
+    }
+
+    /* entries are found by their aliases (or their name if they have none),
+     * like the files in a terminfo directory; the first entry wins if several
+     * share a name */
+    if (!(names = malloc(nnames * sizeof *names))) {
+        perror("malloc()");
+        return EXIT_FAILURE;
+    }
+    nnames = 0;
+    for (size_t k = 0; k < nterms; k++) {
+        const char **a = unibi_get_aliases(terms[k]);
+        const char *single[] = { unibi_get_name(terms[k]), NULL };
+        if (!*a) {
+            a = single;
+        }
+        for (; *a; a++) {
+            size_t i;
+            for (i = 0; i < nnames && strcmp(names[i].name, *a) != 0; i++) {
+            }
+            if (i == nnames) {
+                names[nnames].name = *a;
+                names[nnames].entry = k;
+                nnames++;
+            }
+        }
+    }
+    qsort(names, nnames, sizeof *names, cmp_name);
+
+    puts("/* Generated by tools/gen-builtin; do not edit. */");
+    printf("/* Source: %s */\n", source);
+    puts("");
+
+    for (size_t k = 0; k < nterms; k++) {
+        print_entry(k, terms[k]);
+    }
+
+    puts("static const struct builtin_entry builtin_entries[] = {");
+    for (size_t k = 0; k < nterms; k++) {
+        const unibi_term *const ut = terms[k];
+        fputs("    {\n        ", stdout);
+        print_str(unibi_get_name(ut));
+        printf(", b%zu_aliases,\n        ", k);
+        print_field(k, "bools", count_std(ut, unibi_cap_bool));
+        fputs(", ", stdout);
+        print_field(k, "nums", count_std(ut, unibi_cap_num));
+        fputs(", ", stdout);
+        print_field(k, "strs", count_std(ut, unibi_cap_str));
+        fputs(",\n        ", stdout);
+        print_field(k, "ext_bools", unibi_count_ext_bool(ut));
+        fputs(", ", stdout);
+        print_field(k, "ext_nums", unibi_count_ext_num(ut));
+        fputs(", ", stdout);
+        print_field(k, "ext_strs", unibi_count_ext_str(ut));
+        printf("\n    }%s\n", k + 1 < nterms ? "," : "");
+    }
+    puts("};");
+    puts("");
+
+    puts("/* sorted by name for bsearch() */");
+    puts("static const struct builtin_name builtin_names[] = {");
+    for (size_t i = 0; i < nnames; i++) {
+        fputs("    { ", stdout);
+        print_str(names[i].name);
+        printf(", %zu }%s\n", names[i].entry, i + 1 < nnames ? "," : "");
+    }
+    puts("};");
+
+    for (size_t k = 0; k < nterms; k++) {
+        unibi_destroy(terms[k]);
+    }
+    free(terms);
+    free(names);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/* Generate uninames-hash.c.inc, the short name and termcap code lookup tables
+ * for uninames.c. */
+
+/*
+
+This file (it has no associated documentation) is under the MIT license:
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include <unibilium.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* must match cap_hash() in uninames.c */
+enum { SIZE = 1024 };
+
+static unsigned long cap_hash(const char *s) {
+    unsigned long h = 2166136261UL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h = (h * 16777619UL) & 0xffffffffUL;
+    }
+    return h;
+}
+
+static unsigned short names[SIZE], codes[SIZE];
+
+static void insert(unsigned short *table, const char *name, enum unibi_cap_type type, unsigned idx) {
+    unsigned long h = cap_hash(name) % SIZE;
+    while (table[h]) {
+        h = (h + 1) % SIZE;
+    }
+    table[h] = (unsigned short)((unsigned)type << 10 | (idx + 1));
+}
+
+static void print_table(const char *name, const unsigned short *table) {
+    size_t i;
+    printf("static const unsigned short %s[CAP_HASH_SIZE] = {\n", name);
+    for (i = 0; i < SIZE; i++) {
+        printf("%s0x%04x%s", i % 10 ? " " : "    ", table[i], i + 1 == SIZE ? "\n" : i % 10 == 9 ? ",\n" : ",");
+    }
+    puts("};");
+}
+
+int main(void) {
+    size_t i, n = 0;
+
+    for (i = unibi_boolean_begin_ + 1; i < unibi_boolean_end_; i++, n++) {
+        insert(names, unibi_short_name_bool(i), unibi_cap_bool, i - unibi_boolean_begin_ - 1);
+        insert(codes, unibi_termcap_name_bool(i), unibi_cap_bool, i - unibi_boolean_begin_ - 1);
+    }
+    for (i = unibi_numeric_begin_ + 1; i < unibi_numeric_end_; i++, n++) {
+        insert(names, unibi_short_name_num(i), unibi_cap_num, i - unibi_numeric_begin_ - 1);
+        insert(codes, unibi_termcap_name_num(i), unibi_cap_num, i - unibi_numeric_begin_ - 1);
+    }
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++, n++) {
+        insert(names, unibi_short_name_str(i), unibi_cap_str, i - unibi_string_begin_ - 1);
+        insert(codes, unibi_termcap_name_str(i), unibi_cap_str, i - unibi_string_begin_ - 1);
+    }
+    if (n * 2 > SIZE) {
+        fprintf(stderr, "too many names (%zu) for a table of %d slots\n", n, SIZE);
+        return EXIT_FAILURE;
+    }
+
+    puts("/* Generated by tools/gen-cap-hash; do not edit. */");
+    puts("");
+    puts("/* Short capability names and termcap codes, hashed with cap_hash() and");
+    puts(" * linear probing. Each slot holds (type << 10 | (index + 1)), or 0 if it");
+    puts(" * is empty. */");
+    puts("");
+    printf("enum { CAP_HASH_SIZE = %d };\n", SIZE);
+    puts("");
+    print_table("cap_hash_table", names);
+    puts("");
+    print_table("termcap_hash_table", codes);
+
+    return 0;
+}
@@ -49,6 +49,18 @@ static void print_str_esc(const char *s, int twice) {
     }
 }
 
+static int print_bytes(void *ctx, const char *p, size_t n) {
+    size_t *pos = ctx;
+    for (size_t i = 0; i < n; i++, ++*pos) {
+        if (*pos) {
+            printf(",");
+        }
+        printf("%s", *pos % 20 ? " " : "\n    ");
+        printf("%d", (int)p[i]);
+    }
+    return 0;
+}
+
 int main(int argc, char **argv) {
     unibi_term *ut;
     if (argc < 2) {
@@ -68,13 +80,6 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
-    char buf[4096];
-    size_t r = unibi_dump(ut, buf, sizeof buf);
-    if (r > sizeof buf) {
-        perror("unibi_dump()");
-        return EXIT_FAILURE;
-    }
-
     unsigned test_counter = 0;
 
     say("#include <unibilium.h>");
@@ -83,12 +88,10 @@ int main(int argc, char **argv) {
     say("#include \"test-simple.c.inc\"");
     say("");
     say_("static const char terminfo[] = {");
-    for (size_t i = 0; i < r; i++) {
-        if (i) {
-            printf(",");
-        }
-        printf("%s", i % 20 ? " " : "\n    ");
-        printf("%d", (int)buf[i]);
+    size_t pos = 0;
+    if (unibi_dump_to(ut, print_bytes, &pos) == (size_t)-1) {
+        perror("unibi_dump_to()");
+        return EXIT_FAILURE;
     }
     say("\n};");
     say("");
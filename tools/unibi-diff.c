@@ -0,0 +1,166 @@
+/* Compare two terminal descriptions, like "infocmp -d". */
+
+/*
+
+This file (it has no associated documentation) is under the MIT license:
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include "unibilium.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static int put_stdout(void *ctx, const char *p, size_t n) {
+    (void)ctx;
+    return fwrite(p, 1, n, stdout) == n ? 0 : -1;
+}
+
+static void print_str_esc(const char *s) {
+    if (!s) {
+        printf("NULL");
+        return;
+    }
+
+    putchar('\'');
+    unibi_escape_str(s, put_stdout, NULL);
+    putchar('\'');
+}
+
+static unibi_term *get_term(const char *s) {
+    unibi_term *ut;
+    if (strchr(s, '/')) {
+        ut = unibi_from_file(s);
+        if (!ut) {
+            fprintf(stderr, "unibi_from_file(): %s: %s\n", s, strerror(errno));
+        }
+    } else {
+        ut = unibi_from_term(s);
+        if (!ut) {
+            fprintf(stderr, "unibi_from_term(): %s: %s\n", s, strerror(errno));
+        }
+    }
+    return ut;
+}
+
+typedef struct {
+    const unibi_term *a, *b;
+    enum unibi_cap_type section;
+    unsigned long count;
+} diff_ctx;
+
+static const char *const sections[] = { "booleans", "numbers", "strings" };
+
+static const char *cap_name(const unibi_term *ut, enum unibi_cap_type type, int cap, size_t i) {
+    switch (type) {
+        case unibi_cap_bool: return cap >= 0 ? unibi_short_name_bool(cap) : unibi_get_ext_bool_name(ut, i);
+        case unibi_cap_num:  return cap >= 0 ? unibi_short_name_num(cap)  : unibi_get_ext_num_name(ut, i);
+        case unibi_cap_str:  return cap >= 0 ? unibi_short_name_str(cap)  : unibi_get_ext_str_name(ut, i);
+    }
+    return "?";
+}
+
+static void print_bool(const unibi_term *ut, int cap, size_t i) {
+    int b = cap >= 0 ? unibi_get_bool(ut, cap) : i != (size_t)-1 && unibi_get_ext_bool(ut, i);
+    putchar(b ? 'T' : 'F');
+}
+
+static void print_num(const unibi_term *ut, int cap, size_t i) {
+    int n = cap >= 0 ? unibi_get_num(ut, cap) : i != (size_t)-1 ? unibi_get_ext_num(ut, i) : -1;
+    if (n == -1) {
+        printf("NULL");
+    } else {
+        printf("%d", n);
+    }
+}
+
+static void print_str(const unibi_term *ut, int cap, size_t i) {
+    print_str_esc(cap >= 0 ? unibi_get_str(ut, cap) : i != (size_t)-1 ? unibi_get_ext_str(ut, i) : NULL);
+}
+
+static void report(void *vctx, enum unibi_diff_op op, enum unibi_cap_type type, int cap, size_t ia, size_t ib) {
+    diff_ctx *ctx = vctx;
+
+    while (ctx->section < type) {
+        ctx->section++;
+        printf("    comparing %s.\n", sections[ctx->section]);
+    }
+    ctx->count++;
+
+    printf("\t%s: ", cap_name(op == unibi_diff_added ? ctx->b : ctx->a, type, cap, op == unibi_diff_added ? ib : ia));
+    switch (type) {
+        case unibi_cap_bool:
+            print_bool(ctx->a, cap, ia);
+            putchar(':');
+            print_bool(ctx->b, cap, ib);
+            break;
+        case unibi_cap_num:
+            print_num(ctx->a, cap, ia);
+            printf(", ");
+            print_num(ctx->b, cap, ib);
+            break;
+        case unibi_cap_str:
+            print_str(ctx->a, cap, ia);
+            printf(", ");
+            print_str(ctx->b, cap, ib);
+            break;
+    }
+    printf(".\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s TERM1 TERM2\n", argv[0]);
+        return 2;
+    }
+
+    unibi_term *const a = get_term(argv[1]);
+    if (!a) {
+        return 2;
+    }
+    unibi_term *const b = get_term(argv[2]);
+    if (!b) {
+        unibi_destroy(a);
+        return 2;
+    }
+
+    printf("comparing %s to %s.\n", argv[1], argv[2]);
+    printf("    comparing %s.\n", sections[unibi_cap_bool]);
+
+    diff_ctx ctx = { a, b, unibi_cap_bool, 0 };
+    if (unibi_diff(a, b, report, &ctx) < 0) {
+        perror("unibi_diff()");
+        unibi_destroy(a);
+        unibi_destroy(b);
+        return 2;
+    }
+    while (ctx.section < unibi_cap_str) {
+        ctx.section++;
+        printf("    comparing %s.\n", sections[ctx.section]);
+    }
+
+    unibi_destroy(a);
+    unibi_destroy(b);
+
+    return ctx.count ? 1 : 0;
+}
@@ -79,7 +79,35 @@ static unibi_term *get_term(const char *s) {
     return ut;
 }
 
+static int write_stdout(void *ctx, const char *p, size_t n) {
+    (void)ctx;
+    return fwrite(p, 1, n, stdout) == n ? 0 : -1;
+}
+
+/* "-s [FILE...]": print terminfo source instead */
+static int dump_source(int argc, char **argv) {
+    int status = 0;
+    int i = 0;
+    do {
+        unibi_term *const ut = get_term(i < argc ? argv[i] : NULL);
+        if (!ut) {
+            status = 1;
+            continue;
+        }
+        if (unibi_to_source(ut, write_stdout, NULL) == (size_t)-1) {
+            perror("unibi_to_source()");
+            status = 1;
+        }
+        unibi_destroy(ut);
+    } while (++i < argc);
+    return status;
+}
+
 int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        return dump_source(argc - 2, argv + 2);
+    }
+
     unibi_term *const ut = get_term(argc > 1 ? argv[1] : NULL);
     if (!ut) {
         return 1;
@@ -0,0 +1,136 @@
+/* Install compiled terminfo entries into a directory tree, like "tic -o". */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+
+This file (it has no associated documentation) is under the MIT license:
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+*/
+
+#include "unibilium.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static unibi_term *get_term(const char *s) {
+    unibi_term *ut;
+    if (strchr(s, '/')) {
+        ut = unibi_from_file(s);
+        if (!ut) {
+            fprintf(stderr, "unibi_from_file(): %s: %s\n", s, strerror(errno));
+        }
+    } else {
+        ut = unibi_from_term(s);
+        if (!ut) {
+            fprintf(stderr, "unibi_from_term(): %s: %s\n", s, strerror(errno));
+        }
+    }
+    return ut;
+}
+
+/* installs every jobs-th entry, starting at the first; returns the number of failures */
+static int install_some(const char *dir, char **entries, int count, int first, int jobs) {
+    int failed = 0;
+    for (int i = first; i < count; i += jobs) {
+        unibi_term *const ut = get_term(entries[i]);
+        if (!ut) {
+            failed++;
+            continue;
+        }
+        if (unibi_install(dir, ut) < 0) {
+            fprintf(stderr, "unibi_install(): %s: %s\n", entries[i], strerror(errno));
+            failed++;
+        }
+        unibi_destroy(ut);
+    }
+    return failed;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-j JOBS] DIR ENTRY...\n", prog);
+    fprintf(stderr, "ENTRY is a terminal name or, if it contains a '/', a compiled terminfo file.\n");
+}
+
+int main(int argc, char **argv) {
+    int jobs = 1, argi = 1;
+
+    if (argi + 1 < argc && strcmp(argv[argi], "-j") == 0) {
+        char *end;
+        long n = strtol(argv[argi + 1], &end, 10);
+        if (*end || n < 1 || n > 1024) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        jobs = n;
+        argi += 2;
+    }
+
+    if (argc - argi < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *const dir = argv[argi];
+    char **const entries = argv + argi + 1;
+    const int count = argc - argi - 1;
+
+    if (jobs > count) {
+        jobs = count;
+    }
+    if (jobs == 1) {
+        return install_some(dir, entries, count, 0, 1) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    /* one process per job, each taking a fixed share of the entries */
+    int failed = 0, started = 0;
+    fflush(NULL);
+    for (int k = 0; k < jobs; k++) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork()");
+            failed = 1;
+            break;
+        }
+        if (pid == 0) {
+            _exit(install_some(dir, entries, count, k, jobs) ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+        started++;
+    }
+
+    for (; started; started--) {
+        int status;
+        if (wait(&status) < 0) {
+            perror("wait()");
+            return EXIT_FAILURE;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            failed = 1;
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -84,39 +84,21 @@ int main(int argc, char **argv) {
                 fputs(fmt, stdout);
                 return 0;
             }
-            unibi_var_t vars[9] = {0};
-            switch (i) {
-#define REQ(N) do { if (argc - 2 < (N)) { fprintf(stderr, "%s: %s: missing argument\n", argv[0], argv[1]); return 4; } } while (0)
-
-                case unibi_dial_phone:
-                case unibi_quick_dial:
-                    REQ(1);
-                    vars[0] = unibi_var_from_str(argv[2]);
-                    break;
-
-                case unibi_pkey_key:
-                case unibi_pkey_local:
-                case unibi_pkey_xmit:
-                case unibi_plab_norm:
-                    REQ(2);
-                    vars[0] = unibi_var_from_num(atoi(argv[2]));
-                    vars[1] = unibi_var_from_str(argv[3]);
-                    break;
-
-                case unibi_pkey_plab:
-                    REQ(3);
-                    vars[0] = unibi_var_from_num(atoi(argv[2]));
-                    vars[1] = unibi_var_from_str(argv[3]);
-                    vars[2] = unibi_var_from_str(argv[4]);
-                    break;
-
-                default: {
-                    for (int k = 0; k + 2 < argc; ++k) {
-                        vars[k] = unibi_var_from_num(atoi(argv[k + 2]));
+            const size_t nparams = unibi_count_params_str(i);
+            if ((size_t)(argc - 2) < nparams) {
+                for (size_t k = 0; k < nparams; ++k) {
+                    if (unibi_param_type_str(i, k) == unibi_param_str) {
+                        fprintf(stderr, "%s: %s: missing argument\n", argv[0], argv[1]);
+                        return 4;
                     }
-                    break;
-
-#undef REQ
+                }
+            }
+            unibi_var_t vars[9] = {0};
+            for (int k = 0; k + 2 < argc && k < 9; ++k) {
+                if (unibi_param_type_str(i, k) == unibi_param_str) {
+                    vars[k] = unibi_var_from_str(argv[k + 2]);
+                } else {
+                    vars[k] = unibi_var_from_num(atoi(argv[k + 2]));
                 }
             }
             char buf[1024];
@@ -28,6 +28,22 @@ along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdint.h>
+#ifdef _MSC_VER
+# include <io.h>
+# include <BaseTsd.h>
+# define ssize_t SSIZE_T
+#else
+# include <unistd.h>
+#endif
+#ifndef _WIN32
+# include <sys/uio.h>
+#else
+struct iovec {
+    void *iov_base;
+    size_t iov_len;
+};
+#endif
 
 #define ASSERT_RETURN(COND, VAL) do { \
     assert(COND); \
@@ -79,6 +95,25 @@ along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
     static int DYNARR(W, ensure_slot)(DYNARR_T(W) *const d) { \
         return DYNARR(W, ensure_slots)(d, 1); \
     } \
+    static int DYNARR(W, resize)(DYNARR_T(W) *const d, const size_t k) { \
+        assert(k >= d->used); \
+        if (k == d->size) { \
+            return 1; \
+        } \
+        if (k == 0) { \
+            DYNARR(W, free)(d); \
+            return 1; \
+        } \
+        { \
+            T (*const p) = realloc(d->data, k * sizeof *p); \
+            if (!p) { \
+                return 0; \
+            } \
+            d->data = p; \
+            d->size = k; \
+        } \
+        return 1; \
+    } \
     static void DYNARR(W, init)(DYNARR_T(W) *)
 
 static size_t next_alloc(size_t n) {
@@ -95,6 +130,24 @@ enum {
     MAGIC_32BIT = 01036
 };
 
+enum {
+    DUMP_EXT_LENS = 128
+};
+
+/* Sizing data for unibi_dump(), computed on the caller's stack. The lengths
+ * include the terminating '\0'. The standard string lengths are taken from
+ * str_info. The extended ones are only kept if there are few enough of them
+ * (ext_lens_ok); otherwise they are measured again while writing. */
+struct dump_info {
+    size_t req;
+    size_t namlen, boollen, numlen, numsize, strslen, tablsz;
+    size_t ext_count, ext_tablsz1, ext_tablsz2;
+    size_t tbl_off, ext_size;
+    unsigned short str_lens[unibi_string_end_ - unibi_string_begin_ - 1];
+    unsigned short ext_lens[DUMP_EXT_LENS];
+    int ext_lens_ok;
+};
+
 struct unibi_term {
     const char *name;
     const char **aliases;
@@ -109,8 +162,56 @@ struct unibi_term {
     DYNARR_T(str) ext_strs;
     DYNARR_T(str) ext_names;
     char *ext_alloc;
+
+    unsigned str_info[unibi_string_end_ - unibi_string_begin_ - 1];
+
+    unibi_prog **progs;
+    struct memo *memo;
+
+    struct overlay *ov;
+};
+
+/* An overlay view has no capabilities of its own: the getters consult delta
+ * first and fall back to base. vis[] lists, per type, the extended
+ * capabilities of base that aren't shadowed by an extended capability of the
+ * same name in delta. */
+struct overlay {
+    const unibi_term *base, *delta;
+    size_t *vis[3];
+    size_t nvis[3];
+};
+
+/* A bounded cache of formatted output, keyed by capability and the numeric
+ * values of the parameters. Entries are chained into buckets by hash and
+ * kept on a list in order of use; the least recently used one is recycled
+ * when the cache is full. incr[] records per capability whether its output
+ * depends on nothing but the parameter numbers (MEMO_NO if it doesn't) and if
+ * so, how often it applies %i. It is filled in when the cache is set up and
+ * when a string changes, so lookups only read it. */
+#define MEMO_OUT 48
+#define MEMO_MAX 65536
+#define MEMO_NIL SIZE_ERR
+#define MEMO_NO (-1)
+
+struct memo_entry {
+    unsigned short cap;
+    unsigned char len;
+    int key[9];
+    size_t chain;
+    size_t prev, next;
+    char out[MEMO_OUT];
+};
+
+struct memo {
+    size_t size, used, mask;
+    size_t head, tail;
+    size_t *bucket;
+    struct memo_entry *ent;
+    signed char incr[unibi_string_end_ - unibi_string_begin_ - 1];
 };
 
+static int memo_incr(const unibi_prog *);
+
 #define ASSERT_EXT_NAMES(X) assert((X)->ext_names.used == (X)->ext_bools.used + (X)->ext_nums.used + (X)->ext_strs.used)
 
 
@@ -150,6 +251,39 @@ static const char *off_of(const char *p, size_t n, short i) {
     return i < 0 || (size_t)i >= n ? NULL : p + i;
 }
 
+/* str_info[] holds the length of each standard string, shifted left by one,
+ * with STR_PLAIN set if the string contains no '%' or "$<" and can be output
+ * as is. Strings too long for that are marked STR_LONG. The loaders fill it
+ * in and unibi_set_str() keeps it current; entries of absent strings are
+ * never read. */
+#define STR_PLAIN 1u
+#define STR_LONG UINT_MAX
+
+static unsigned str_info_of(const char *s) {
+    const char *p = s;
+    unsigned plain = STR_PLAIN;
+    size_t n;
+
+    while (*(p += strcspn(p, "%$"))) {
+        if (*p == '%' || p[1] == '<') {
+            plain = 0;
+            break;
+        }
+        p++;
+    }
+    n = p - s + strlen(p);
+    return n < STR_LONG >> 1 ? (unsigned)n << 1 | plain : STR_LONG;
+}
+
+static void str_info_build(unibi_term *t) {
+    size_t i;
+    for (i = 0; i < COUNTOF(t->strs); i++) {
+        if (t->strs[i]) {
+            t->str_info[i] = str_info_of(t->strs[i]);
+        }
+    }
+}
+
 unibi_term *unibi_dummy(void) {
     unibi_term *t;
     void *mem;
@@ -175,6 +309,9 @@ unibi_term *unibi_dummy(void) {
     DYNARR(str, init)(&t->ext_strs);
     DYNARR(str, init)(&t->ext_names);
     t->ext_alloc = NULL;
+    t->progs = NULL;
+    t->memo = NULL;
+    t->ov = NULL;
 
     ASSERT_EXT_NAMES(t);
 
@@ -265,6 +402,9 @@ unibi_term *unibi_from_mem(const char *p, size_t n) {
     DYNARR(str, init)(&t->ext_strs);
     DYNARR(str, init)(&t->ext_names);
     t->ext_alloc = NULL;
+    t->progs = NULL;
+    t->memo = NULL;
+    t->ov = NULL;
 
     DEL_FAIL_IF(n < boollen, EFAULT, t);
     memset(t->bools, '\0', sizeof t->bools);
@@ -437,6 +577,8 @@ unibi_term *unibi_from_mem(const char *p, size_t n) {
 
     ASSERT_EXT_NAMES(t);
 
+    str_info_build(t);
+
     return t;
 }
 
@@ -445,6 +587,28 @@ unibi_term *unibi_from_mem(const char *p, size_t n) {
 #undef DEL_FAIL_IF
 
 void unibi_destroy(unibi_term *t) {
+    if (t->progs) {
+        size_t i;
+        for (i = 0; i < COUNTOF(t->strs); i++) {
+            unibi_prog_destroy(t->progs[i]);
+        }
+        free(t->progs);
+        t->progs = NULL;
+    }
+
+    if (t->memo) {
+        free(t->memo->bucket);
+        free(t->memo->ent);
+        free(t->memo);
+        t->memo = NULL;
+    }
+
+    if (t->ov) {
+        free(t->ov->vis[0]);
+        free(t->ov);
+        t->ov = NULL;
+    }
+
     DYNARR(bool, free)(&t->ext_bools);
     DYNARR(num, free)(&t->ext_nums);
     DYNARR(str, free)(&t->ext_strs);
@@ -458,6 +622,159 @@ void unibi_destroy(unibi_term *t) {
     free(t);
 }
 
+static size_t count_ext(const unibi_term *t, enum unibi_cap_type type) {
+    switch (type) {
+        case unibi_cap_bool: return unibi_count_ext_bool(t);
+        case unibi_cap_num:  return unibi_count_ext_num(t);
+        case unibi_cap_str:  return unibi_count_ext_str(t);
+    }
+    return 0;
+}
+
+static const char *ext_name(const unibi_term *t, enum unibi_cap_type type, size_t i) {
+    switch (type) {
+        case unibi_cap_bool: return unibi_get_ext_bool_name(t, i);
+        case unibi_cap_num:  return unibi_get_ext_num_name(t, i);
+        case unibi_cap_str:  return unibi_get_ext_str_name(t, i);
+    }
+    return NULL;
+}
+
+static int ext_shadowed(const unibi_term *t, const char *name) {
+    enum unibi_cap_type type;
+    for (type = unibi_cap_bool; type <= unibi_cap_str; type++) {
+        const size_t n = count_ext(t, type);
+        size_t i;
+        for (i = 0; i < n; i++) {
+            if (strcmp(ext_name(t, type, i), name) == 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+unibi_term *unibi_overlay(const unibi_term *base, const unibi_term *delta) {
+    unibi_term *t;
+    struct overlay *ov;
+    enum unibi_cap_type type;
+    size_t *vis;
+
+    if (!(t = unibi_dummy())) {
+        return NULL;
+    }
+    if (
+        !(ov = malloc(sizeof *ov)) ||
+        !(vis = malloc((
+            count_ext(base, unibi_cap_bool) +
+            count_ext(base, unibi_cap_num) +
+            count_ext(base, unibi_cap_str) + 1
+        ) * sizeof *vis))
+    ) {
+        free(ov);
+        unibi_destroy(t);
+        return NULL;
+    }
+
+    ov->base = base;
+    ov->delta = delta;
+    for (type = unibi_cap_bool; type <= unibi_cap_str; type++) {
+        const size_t n = count_ext(base, type);
+        size_t i;
+        ov->vis[type] = vis;
+        for (i = 0; i < n; i++) {
+            if (!ext_shadowed(delta, ext_name(base, type, i))) {
+                *vis++ = i;
+            }
+        }
+        ov->nvis[type] = vis - ov->vis[type];
+    }
+
+    t->name = unibi_get_name(base);
+    t->aliases = unibi_get_aliases(base);
+    t->ov = ov;
+    return t;
+}
+
+/* Map index *i of a view's extended capabilities of one type to the term
+ * that holds it, adjusting *i to that term's numbering. */
+static const unibi_term *ov_ext(const struct overlay *ov, enum unibi_cap_type type, size_t *i) {
+    const size_t n = count_ext(ov->delta, type);
+    if (*i < n) {
+        return ov->delta;
+    }
+    *i = ov->vis[type][*i - n];
+    return ov->base;
+}
+
+static int ov_ext_ok(const struct overlay *ov, enum unibi_cap_type type, size_t i) {
+    return i < count_ext(ov->delta, type) + ov->nvis[type];
+}
+
+static unibi_term *flatten(const unibi_term *t) {
+    unibi_term *f;
+    size_t i, n;
+    int k;
+
+    if (!(f = unibi_dummy())) {
+        return NULL;
+    }
+    f->name = unibi_get_name(t);
+    f->aliases = unibi_get_aliases(t);
+
+    for (k = unibi_boolean_begin_ + 1; k < unibi_boolean_end_; k++) {
+        unibi_set_bool(f, k, unibi_get_bool(t, k));
+    }
+    for (k = unibi_numeric_begin_ + 1; k < unibi_numeric_end_; k++) {
+        unibi_set_num(f, k, unibi_get_num(t, k));
+    }
+    for (k = unibi_string_begin_ + 1; k < unibi_string_end_; k++) {
+        unibi_set_str(f, k, unibi_get_str(t, k));
+    }
+
+    n = unibi_count_ext_bool(t);
+    for (i = 0; i < n; i++) {
+        if (unibi_add_ext_bool(f, unibi_get_ext_bool_name(t, i), unibi_get_ext_bool(t, i)) == SIZE_ERR) {
+            unibi_destroy(f);
+            return NULL;
+        }
+    }
+    n = unibi_count_ext_num(t);
+    for (i = 0; i < n; i++) {
+        if (unibi_add_ext_num(f, unibi_get_ext_num_name(t, i), unibi_get_ext_num(t, i)) == SIZE_ERR) {
+            unibi_destroy(f);
+            return NULL;
+        }
+    }
+    n = unibi_count_ext_str(t);
+    for (i = 0; i < n; i++) {
+        if (unibi_add_ext_str(f, unibi_get_ext_str_name(t, i), unibi_get_ext_str(t, i)) == SIZE_ERR) {
+            unibi_destroy(f);
+            return NULL;
+        }
+    }
+    return f;
+}
+
+/* The dumpers work on the arrays directly. For an overlay view they get a
+ * merged copy in *tmp, which the caller releases again with release(). */
+static const unibi_term *solid(const unibi_term *t, unibi_term **tmp) {
+    *tmp = NULL;
+    if (!t->ov) {
+        return t;
+    }
+    return *tmp = flatten(t);
+}
+
+static size_t release(unibi_term *tmp, size_t r) {
+    if (tmp) {
+        const int e = errno;
+        unibi_destroy(tmp);
+        errno = e;
+    }
+    return r;
+}
+
 static void put_ushort16(char *p, unsigned short n) {
     unsigned char *q = (unsigned char *)p;
     q[0] = n % 256;
@@ -502,17 +819,27 @@ static void put_int32(char *p, int n) {
     );
 }
 
-#define FAIL_INVAL_IF(c) if (c) { errno = EINVAL; return SIZE_ERR; } else (void)0
+#define FAIL_INVAL_IF(c) if (c) { errno = EINVAL; return NULL; } else (void)0
 
-size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
+/* Total size of an entry with layout di and a standard string table of
+ * tablsz bytes. */
+static size_t dump_req(const struct dump_info *di, size_t tablsz) {
+    size_t req = di->tbl_off + tablsz;
+    if (di->ext_count) {
+        req += req % 2 + di->ext_size;
+    }
+    return req;
+}
+
+/* Computes the layout of the compiled entry into *di, together with the
+ * string lengths, so the write pass doesn't have to measure anything again. */
+static const struct dump_info *dump_layout(const unibi_term *t, struct dump_info *di) {
     size_t req, i;
     size_t namlen, boollen, numlen, strslen, tablsz;
     size_t ext_count, ext_tablsz1, ext_tablsz2;
-    char *p;
 
     ASSERT_EXT_NAMES(t);
-
-    p = ptr;
+    assert(!t->ov);
 
     req = 2 + 5 * 2;
 
@@ -563,12 +890,17 @@ size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
     tablsz = 0;
     while (i--) {
         if (t->strs[i]) {
-            tablsz += strlen(t->strs[i]) + 1;
+            const unsigned info = t->str_info[i];
+            const size_t k = (info == STR_LONG ? strlen(t->strs[i]) : info >> 1) + 1;
+            FAIL_INVAL_IF(k > MAX15BITS);
+            di->str_lens[i] = k;
+            tablsz += k;
         }
     }
     req += tablsz;
 
-    FAIL_INVAL_IF(tablsz > MAX15BITS);
+    /* tablsz is checked by the callers: unibi_dump_compact() may share
+     * enough strings to bring it within limits */
 
     FAIL_INVAL_IF(t->ext_bools.used > MAX15BITS);
     FAIL_INVAL_IF(t->ext_nums.used > MAX15BITS);
@@ -579,6 +911,9 @@ size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
     ext_count = t->ext_bools.used + t->ext_nums.used + t->ext_strs.used;
     assert(ext_count == t->ext_names.used);
 
+    /* ext string lengths followed by ext name lengths */
+    di->ext_lens_ok = t->ext_strs.used + ext_count <= COUNTOF(di->ext_lens);
+
     if (ext_count) {
         if (req % 2) {
             req += 1;
@@ -610,14 +945,24 @@ size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
 
         for (i = 0; i < t->ext_strs.used; i++) {
             if (t->ext_strs.data[i]) {
-                ext_tablsz1 += strlen(t->ext_strs.data[i]) + 1;
+                const size_t k = strlen(t->ext_strs.data[i]) + 1;
+                FAIL_INVAL_IF(k > MAX15BITS);
+                if (di->ext_lens_ok) {
+                    di->ext_lens[i] = k;
+                }
+                ext_tablsz1 += k;
             }
         }
         FAIL_INVAL_IF(ext_tablsz1 > MAX15BITS);
         req += ext_tablsz1;
 
         for (i = 0; i < t->ext_names.used; i++) {
-            ext_tablsz2 += strlen(t->ext_names.data[i]) + 1;
+            const size_t k = strlen(t->ext_names.data[i]) + 1;
+            FAIL_INVAL_IF(k > MAX15BITS);
+            if (di->ext_lens_ok) {
+                di->ext_lens[t->ext_strs.used + i] = k;
+            }
+            ext_tablsz2 += k;
         }
         FAIL_INVAL_IF(ext_tablsz2 > MAX15BITS);
         req += ext_tablsz2;
@@ -625,793 +970,3651 @@ size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
         FAIL_INVAL_IF(ext_tablsz1 + ext_tablsz2 > MAX15BITS);
     }
 
-    if (req > n) {
-        errno = EFAULT;
-        return req;
+    di->namlen = namlen;
+    di->boollen = boollen;
+    di->numlen = numlen;
+    di->numsize = numsize;
+    di->strslen = strslen;
+    di->tablsz = tablsz;
+    di->ext_count = ext_count;
+    di->ext_tablsz1 = ext_tablsz1;
+    di->ext_tablsz2 = ext_tablsz2;
+    di->tbl_off = 12 + namlen + boollen;
+    di->tbl_off += di->tbl_off % 2 + numlen * numsize + strslen * 2;
+    di->ext_size =
+        10 +
+        t->ext_bools.used + t->ext_bools.used % 2 +
+        t->ext_nums.used * numsize +
+        (t->ext_strs.used + ext_count) * 2 +
+        ext_tablsz1 + ext_tablsz2;
+    di->req = dump_req(di, tablsz);
+    assert(di->req == req);
+    return di;
+}
+
+/* dump_layout() for the plain layout, which stores every string separately */
+static const struct dump_info *plain_layout(const unibi_term *t, struct dump_info *di) {
+    if (!dump_layout(t, di)) {
+        return NULL;
     }
+    FAIL_INVAL_IF(di->tablsz > MAX15BITS);
+    return di;
+}
 
-    put_ushort16(p + 0, numsize == 2 ? MAGIC_16BIT : MAGIC_32BIT);
-    put_ushort16(p + 2, namlen);
-    put_ushort16(p + 4, boollen);
-    put_ushort16(p + 6, numlen);
-    put_ushort16(p + 8, strslen);
-    put_ushort16(p + 10, tablsz);
-    p += 12;
+static size_t ext_len(const struct dump_info *di, size_t i, const char *s) {
+    return di->ext_lens_ok ? di->ext_lens[i] : strlen(s) + 1;
+}
 
-    for (i = 0; t->aliases[i]; i++) {
-        size_t k = strlen(t->aliases[i]);
-        memcpy(p, t->aliases[i], k);
-        p += k;
-        *p++ = '|';
+/* Sharing of standard strings for unibi_dump_compact(): identical strings and
+ * strings that are a suffix of another one point into the same table entry.
+ * Sorting by reversed contents puts every string right before the next longer
+ * string it is a suffix of. Extended strings can't be shared, because readers
+ * locate the extended name table by adding up the string lengths. */
+
+struct str_share {
+    size_t tablsz;
+    size_t nowners;
+    unsigned short offs[unibi_string_end_ - unibi_string_begin_ - 1];
+    unsigned short owners[unibi_string_end_ - unibi_string_begin_ - 1];
+};
+
+struct rev_ref {
+    const char *s;
+    size_t len;
+    size_t i;
+};
+
+static int cmp_rev_ref(const void *va, const void *vb) {
+    const struct rev_ref *const a = va, *const b = vb;
+    size_t ka = a->len, kb = b->len;
+    while (ka && kb) {
+        const unsigned char ca = a->s[--ka], cb = b->s[--kb];
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
     }
-    {
-        size_t k = strlen(t->name) + 1;
-        memcpy(p, t->name, k);
-        p += k;
+    if (ka != kb) {
+        return ka < kb ? -1 : 1;
     }
+    return a->i < b->i ? -1 : a->i > b->i;
+}
 
-    for (i = 0; i < boollen; i++) {
-        *p++ = t->bools[i / CHAR_BIT] >> i % CHAR_BIT & 1;
-    }
+static void share_strings(const unibi_term *t, const struct dump_info *di, struct str_share *sh) {
+    struct rev_ref refs[COUNTOF(t->strs)];
+    unsigned short root[COUNTOF(t->strs)];
+    size_t i, j, n, off;
 
-    if ((namlen + boollen) % 2) {
-        *p++ = '\0';
+    n = 0;
+    for (i = 0; i < di->strslen; i++) {
+        if (t->strs[i]) {
+            refs[n].s = t->strs[i];
+            refs[n].len = di->str_lens[i];
+            refs[n].i = i;
+            n++;
+        }
     }
 
-    for (i = 0; i < numlen; i++) {
-        if (numsize == 2) {
-            put_short16(p, t->nums[i]);
-            p += 2;
+    qsort(refs, n, sizeof *refs, cmp_rev_ref);
+
+    /* first find the owner of each string and its position in there ... */
+    for (j = n; j--; ) {
+        const struct rev_ref *const a = &refs[j];
+        const struct rev_ref *const b = &refs[j + 1];
+        if (
+            j + 1 < n &&
+            a->len <= b->len &&
+            memcmp(b->s + (b->len - a->len), a->s, a->len) == 0
+        ) {
+            root[a->i] = root[b->i];
+            sh->offs[a->i] = sh->offs[b->i] + (b->len - a->len);
         } else {
-            put_int32(p, t->nums[i]);
-            p += 4;
+            root[a->i] = a->i;
+            sh->offs[a->i] = 0;
         }
     }
 
-    {
-        char *const tbl = p + strslen * 2;
-        size_t off = 0;
+    /* ... then lay out the owners in capability order */
+    off = 0;
+    sh->nowners = 0;
+    for (i = 0; i < di->strslen; i++) {
+        if (t->strs[i] && root[i] == i) {
+            sh->offs[i] = off;
+            sh->owners[sh->nowners++] = i;
+            off += di->str_lens[i];
+        }
+    }
+    for (i = 0; i < di->strslen; i++) {
+        if (t->strs[i] && root[i] != i) {
+            sh->offs[i] += sh->offs[root[i]];
+        }
+    }
+
+    assert(off <= di->tablsz);
+    sh->tablsz = off;
+}
+
+/* The emitter hands the output to a sink in pieces. Fixed-size fields are
+ * collected in a small staging buffer; strings are passed straight from the
+ * terminal object and flagged as stable, i.e. they stay valid until the dump
+ * is finished. */
+
+typedef int dump_put_fn(void *, const char *, size_t, int);
+
+struct emitter {
+    dump_put_fn *put;
+    void *ctx;
+    int failed;
+    size_t total;
+    size_t used;
+    char buf[256];
+};
+
+static void em_init(struct emitter *e, dump_put_fn *put, void *ctx) {
+    e->put = put;
+    e->ctx = ctx;
+    e->failed = 0;
+    e->total = 0;
+    e->used = 0;
+}
+
+static void em_flush(struct emitter *e) {
+    if (e->used && !e->failed && e->put(e->ctx, e->buf, e->used, 0)) {
+        e->failed = 1;
+    }
+    e->used = 0;
+}
+
+static char *em_reserve(struct emitter *e, size_t n) {
+    char *p;
+    assert(n <= sizeof e->buf);
+    if (e->used + n > sizeof e->buf) {
+        em_flush(e);
+    }
+    p = e->buf + e->used;
+    e->used += n;
+    e->total += n;
+    return p;
+}
 
-        for (i = 0; i < strslen; i++) {
+static void em_stable(struct emitter *e, const char *p, size_t n) {
+    em_flush(e);
+    if (n && !e->failed && e->put(e->ctx, p, n, 1)) {
+        e->failed = 1;
+    }
+    e->total += n;
+}
+
+static void em_pad(struct emitter *e) {
+    if (e->total % 2) {
+        *em_reserve(e, 1) = '\0';
+    }
+}
+
+static void em_num(struct emitter *e, size_t numsize, int n) {
+    if (numsize == 2) {
+        put_short16(em_reserve(e, 2), n);
+    } else {
+        put_int32(em_reserve(e, 4), n);
+    }
+}
+
+static int dump_emit(const unibi_term *t, const struct dump_info *di, const struct str_share *sh, struct emitter *e) {
+    size_t i, off;
+    char *p;
+
+    p = em_reserve(e, 12);
+    put_ushort16(p + 0, di->numsize == 2 ? MAGIC_16BIT : MAGIC_32BIT);
+    put_ushort16(p + 2, di->namlen);
+    put_ushort16(p + 4, di->boollen);
+    put_ushort16(p + 6, di->numlen);
+    put_ushort16(p + 8, di->strslen);
+    put_ushort16(p + 10, di->tablsz);
+
+    for (i = 0; t->aliases[i]; i++) {
+        em_stable(e, t->aliases[i], strlen(t->aliases[i]));
+        *em_reserve(e, 1) = '|';
+    }
+    em_stable(e, t->name, strlen(t->name) + 1);
+
+    for (i = 0; i < di->boollen; i++) {
+        *em_reserve(e, 1) = t->bools[i / CHAR_BIT] >> i % CHAR_BIT & 1;
+    }
+
+    em_pad(e);
+
+    for (i = 0; i < di->numlen; i++) {
+        em_num(e, di->numsize, t->nums[i]);
+    }
+
+    if (sh) {
+        for (i = 0; i < di->strslen; i++) {
+            put_short16(em_reserve(e, 2), t->strs[i] ? (short)sh->offs[i] : -1);
+        }
+
+        for (i = 0; i < sh->nowners; i++) {
+            const size_t k = sh->owners[i];
+            em_stable(e, t->strs[k], di->str_lens[k]);
+        }
+    } else {
+        off = 0;
+        for (i = 0; i < di->strslen; i++) {
+            p = em_reserve(e, 2);
             if (!t->strs[i]) {
                 put_short16(p, -1);
-                p += 2;
             } else {
-                size_t k = strlen(t->strs[i]) + 1;
                 assert(off < MAX15BITS);
                 put_short16(p, (short)off);
-                p += 2;
-                memcpy(tbl + off, t->strs[i], k);
-                off += k;
+                off += di->str_lens[i];
             }
         }
+        assert(off == di->tablsz);
 
-        assert(off == tablsz);
-        assert(p == tbl);
-
-        p += off;
+        for (i = 0; i < di->strslen; i++) {
+            if (t->strs[i]) {
+                em_stable(e, t->strs[i], di->str_lens[i]);
+            }
+        }
     }
 
-    if (ext_count) {
-        if ((p - ptr) % 2) {
-            *p++ = '\0';
-        }
+    if (di->ext_count) {
+        em_pad(e);
 
+        p = em_reserve(e, 10);
         put_ushort16(p + 0, t->ext_bools.used);
         put_ushort16(p + 2, t->ext_nums.used);
         put_ushort16(p + 4, t->ext_strs.used);
-        put_ushort16(p + 6, t->ext_strs.used + ext_count);
-        put_ushort16(p + 8, ext_tablsz1 + ext_tablsz2);
-        p += 10;
+        put_ushort16(p + 6, t->ext_strs.used + di->ext_count);
+        put_ushort16(p + 8, di->ext_tablsz1 + di->ext_tablsz2);
 
-        if (t->ext_bools.used) {
-            memcpy(p, t->ext_bools.data, t->ext_bools.used);
-            p += t->ext_bools.used;
+        for (i = 0; i < t->ext_bools.used; i++) {
+            *em_reserve(e, 1) = t->ext_bools.data[i];
         }
 
-        if (t->ext_bools.used % 2) {
-            *p++ = '\0';
-        }
+        em_pad(e);
 
         for (i = 0; i < t->ext_nums.used; i++) {
-            if (numsize == 2) {
-                put_short16(p, t->ext_nums.data[i]);
-                p += 2;
-            } else {
-                put_int32(p, t->ext_nums.data[i]);
-                p += 4;
-            }
+            em_num(e, di->numsize, t->ext_nums.data[i]);
         }
 
-        {
-            char *const tbl1 = p + (t->ext_strs.used + ext_count) * 2;
-            char *const tbl2 = tbl1 + ext_tablsz1;
-            size_t off = 0;
-
-            for (i = 0; i < t->ext_strs.used; i++) {
-                const char *const s = t->ext_strs.data[i];
-                if (!s) {
-                    put_short16(p, -1);
-                } else {
-                    const size_t k = strlen(s) + 1;
-                    assert(off < MAX15BITS);
-                    put_ushort16(p, off);
-                    memcpy(tbl1 + off, s, k);
-                    off += k;
-                }
-                p += 2;
+        off = 0;
+        for (i = 0; i < t->ext_strs.used; i++) {
+            const char *const s = t->ext_strs.data[i];
+            p = em_reserve(e, 2);
+            if (!s) {
+                put_short16(p, -1);
+            } else {
+                assert(off < MAX15BITS);
+                put_ushort16(p, off);
+                off += ext_len(di, i, s);
             }
+        }
+        assert(off == di->ext_tablsz1);
 
-            assert(off == ext_tablsz1);
-            assert(p + ext_count * 2 == tbl1);
+        off = 0;
+        for (i = 0; i < t->ext_names.used; i++) {
+            assert(off < MAX15BITS);
+            put_ushort16(em_reserve(e, 2), off);
+            off += ext_len(di, t->ext_strs.used + i, t->ext_names.data[i]);
+        }
+        assert(off == di->ext_tablsz2);
 
-            off = 0;
-            for (i = 0; i < t->ext_names.used; i++) {
-                const char *const s = t->ext_names.data[i];
-                const size_t k = strlen(s) + 1;
-                assert(off < MAX15BITS);
-                put_ushort16(p, off);
-                p += 2;
-                memcpy(tbl2 + off, s, k);
-                off += k;
+        for (i = 0; i < t->ext_strs.used; i++) {
+            const char *const s = t->ext_strs.data[i];
+            if (s) {
+                em_stable(e, s, ext_len(di, i, s));
             }
+        }
 
-            assert(off == ext_tablsz2);
-            assert(p == tbl1);
-            p += ext_tablsz1 + ext_tablsz2;
+        for (i = 0; i < t->ext_names.used; i++) {
+            const char *const s = t->ext_names.data[i];
+            em_stable(e, s, ext_len(di, t->ext_strs.used + i, s));
         }
     }
 
-    assert((size_t)(p - ptr) == req);
+    em_flush(e);
 
-    return req;
-}
+    assert(e->failed || e->total == di->req);
 
-const char *unibi_get_name(const unibi_term *t) {
-    return t->name;
+    return e->failed ? -1 : 0;
 }
 
-void unibi_set_name(unibi_term *t, const char *s) {
-    t->name = s;
+static int put_mem(void *ctx, const char *p, size_t n, int stable) {
+    char **dst = ctx;
+    (void)stable;
+    memcpy(*dst, p, n);
+    *dst += n;
+    return 0;
 }
 
-const char **unibi_get_aliases(const unibi_term *t) {
-    return t->aliases;
-}
+static size_t dump_plain(const unibi_term *t, char *ptr, size_t n) {
+    struct dump_info layout;
+    const struct dump_info *di;
+    struct emitter e;
 
-void unibi_set_aliases(unibi_term *t, const char **a) {
-    t->aliases = a;
-}
+    if (!(di = plain_layout(t, &layout))) {
+        return SIZE_ERR;
+    }
 
-int unibi_get_bool(const unibi_term *t, enum unibi_boolean v) {
-    size_t i;
-    ASSERT_RETURN(v > unibi_boolean_begin_ && v < unibi_boolean_end_, -1);
-    i = v - unibi_boolean_begin_ - 1;
-    return t->bools[i / CHAR_BIT] >> i % CHAR_BIT & 1;
+    if (di->req > n) {
+        errno = EFAULT;
+        return di->req;
+    }
+
+    em_init(&e, put_mem, &ptr);
+    dump_emit(t, di, NULL, &e);
+
+    return di->req;
 }
 
-void unibi_set_bool(unibi_term *t, enum unibi_boolean v, int x) {
-    size_t i;
-    ASSERT_RETURN_(v > unibi_boolean_begin_ && v < unibi_boolean_end_);
-    i = v - unibi_boolean_begin_ - 1;
-    if (x) {
-        t->bools[i / CHAR_BIT] |= 1 << i % CHAR_BIT;
-    } else {
-        t->bools[i / CHAR_BIT] &= ~(1 << i % CHAR_BIT);
+size_t unibi_dump(const unibi_term *t, char *ptr, size_t n) {
+    unibi_term *tmp;
+    if (!(t = solid(t, &tmp))) {
+        return SIZE_ERR;
     }
+    return release(tmp, dump_plain(t, ptr, n));
 }
 
-int unibi_get_num(const unibi_term *t, enum unibi_numeric v) {
-    size_t i;
-    ASSERT_RETURN(v > unibi_numeric_begin_ && v < unibi_numeric_end_, -2);
-    i = v - unibi_numeric_begin_ - 1;
-    return t->nums[i];
-}
+static size_t dump_compact(const unibi_term *t, char *ptr, size_t n) {
+    struct dump_info layout, cdi;
+    const struct dump_info *di;
+    struct str_share sh;
+    struct emitter e;
 
-void unibi_set_num(unibi_term *t, enum unibi_numeric v, int x) {
-    size_t i;
-    ASSERT_RETURN_(v > unibi_numeric_begin_ && v < unibi_numeric_end_);
-    i = v - unibi_numeric_begin_ - 1;
-    t->nums[i] = x;
-}
+    if (!(di = dump_layout(t, &layout))) {
+        return SIZE_ERR;
+    }
 
-const char *unibi_get_str(const unibi_term *t, enum unibi_string v) {
-    size_t i;
-    ASSERT_RETURN(v > unibi_string_begin_ && v < unibi_string_end_, NULL);
-    i = v - unibi_string_begin_ - 1;
-    return t->strs[i];
-}
+    share_strings(t, di, &sh);
+    if (sh.tablsz > MAX15BITS) {
+        errno = EINVAL;
+        return SIZE_ERR;
+    }
+    cdi = *di;
+    cdi.tablsz = sh.tablsz;
+    cdi.req = dump_req(di, sh.tablsz);
 
-void unibi_set_str(unibi_term *t, enum unibi_string v, const char *x) {
-    size_t i;
-    ASSERT_RETURN_(v > unibi_string_begin_ && v < unibi_string_end_);
-    i = v - unibi_string_begin_ - 1;
-    t->strs[i] = x;
-}
+    if (cdi.req > n) {
+        errno = EFAULT;
+        return cdi.req;
+    }
 
+    em_init(&e, put_mem, &ptr);
+    dump_emit(t, &cdi, &sh, &e);
 
-size_t unibi_count_ext_bool(const unibi_term *t) {
-    return t->ext_bools.used;
+    return cdi.req;
 }
 
-size_t unibi_count_ext_num(const unibi_term *t) {
-    return t->ext_nums.used;
+size_t unibi_dump_compact(const unibi_term *t, char *ptr, size_t n) {
+    unibi_term *tmp;
+    if (!(t = solid(t, &tmp))) {
+        return SIZE_ERR;
+    }
+    return release(tmp, dump_compact(t, ptr, n));
 }
 
-size_t unibi_count_ext_str(const unibi_term *t) {
-    return t->ext_strs.used;
-}
+struct put_cb {
+    int (*write)(void *, const char *, size_t);
+    void *ctx;
+};
 
-int unibi_get_ext_bool(const unibi_term *t, size_t i) {
-    ASSERT_RETURN(i < t->ext_bools.used, -1);
-    return t->ext_bools.data[i] ? 1 : 0;
+static int put_cb(void *ctx, const char *p, size_t n, int stable) {
+    const struct put_cb *cb = ctx;
+    (void)stable;
+    return cb->write(cb->ctx, p, n);
 }
 
-const char *unibi_get_ext_bool_name(const unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN(i < t->ext_bools.used, NULL);
-    return t->ext_names.data[i];
-}
+static size_t dump_to(const unibi_term *t, int (*write)(void *, const char *, size_t), void *ctx) {
+    struct dump_info layout;
+    const struct dump_info *di;
+    struct emitter e;
+    struct put_cb cb;
 
-int unibi_get_ext_num(const unibi_term *t, size_t i) {
-    ASSERT_RETURN(i < t->ext_nums.used, -2);
-    return t->ext_nums.data[i];
-}
+    if (!(di = plain_layout(t, &layout))) {
+        return SIZE_ERR;
+    }
 
-const char *unibi_get_ext_num_name(const unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN(i < t->ext_nums.used, NULL);
-    return t->ext_names.data[t->ext_bools.used + i];
-}
+    cb.write = write;
+    cb.ctx = ctx;
+    em_init(&e, put_cb, &cb);
+    if (dump_emit(t, di, NULL, &e) < 0) {
+        return SIZE_ERR;
+    }
 
-const char *unibi_get_ext_str(const unibi_term *t, size_t i) {
-    ASSERT_RETURN(i < t->ext_strs.used, NULL);
-    return t->ext_strs.data[i];
+    return di->req;
 }
 
-const char *unibi_get_ext_str_name(const unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN(i < t->ext_strs.used, NULL);
-    return t->ext_names.data[t->ext_bools.used + t->ext_nums.used + i];
+size_t unibi_dump_to(const unibi_term *t, int (*write)(void *, const char *, size_t), void *ctx) {
+    unibi_term *tmp;
+    if (!(t = solid(t, &tmp))) {
+        return SIZE_ERR;
+    }
+    return release(tmp, dump_to(t, write, ctx));
 }
 
-void unibi_set_ext_bool(unibi_term *t, size_t i, int v) {
-    ASSERT_RETURN_(i < t->ext_bools.used);
-    t->ext_bools.data[i] = !!v;
-}
+/* unibi_dump_fd() gathers the pieces into an iovec array and writes them
+ * with writev(). Stable pieces are referenced in place; only the small
+ * staging chunks are copied, into a fixed arena. */
 
-void unibi_set_ext_bool_name(unibi_term *t, size_t i, const char *c) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_bools.used);
-    t->ext_names.data[i] = c;
-}
+enum {
+    FD_IOV_MAX = 64,
+    FD_ARENA_SIZE = 1024
+};
 
-void unibi_set_ext_num(unibi_term *t, size_t i, int v) {
-    ASSERT_RETURN_(i < t->ext_nums.used);
-    t->ext_nums.data[i] = v;
-}
+struct put_fd {
+    int fd;
+    size_t niov;
+    size_t arena_used;
+    struct iovec iov[FD_IOV_MAX];
+    char arena[FD_ARENA_SIZE];
+};
 
-void unibi_set_ext_num_name(unibi_term *t, size_t i, const char *c) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_nums.used);
-    t->ext_names.data[t->ext_bools.used + i] = c;
+static int fd_write_all(int fd, struct iovec *iov, size_t niov) {
+    while (niov) {
+#ifdef _WIN32
+        const ssize_t r = write(fd, iov->iov_base, iov->iov_len);
+#else
+        const ssize_t r = writev(fd, iov, (int)niov);
+#endif
+        size_t k;
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        k = r;
+        while (niov && k >= iov->iov_len) {
+            k -= iov->iov_len;
+            iov++;
+            niov--;
+        }
+        if (niov) {
+            iov->iov_base = (char *)iov->iov_base + k;
+            iov->iov_len -= k;
+        }
+    }
+    return 0;
 }
 
-void unibi_set_ext_str(unibi_term *t, size_t i, const char *v) {
-    ASSERT_RETURN_(i < t->ext_strs.used);
-    t->ext_strs.data[i] = v;
+static int fd_flush(struct put_fd *f) {
+    const int r = fd_write_all(f->fd, f->iov, f->niov);
+    f->niov = 0;
+    f->arena_used = 0;
+    return r;
 }
 
-void unibi_set_ext_str_name(unibi_term *t, size_t i, const char *c) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_strs.used);
-    t->ext_names.data[t->ext_bools.used + t->ext_nums.used + i] = c;
+static int put_fd(void *ctx, const char *p, size_t n, int stable) {
+    struct put_fd *f = ctx;
+    struct iovec *last;
+
+    if (!stable) {
+        if (f->arena_used + n > sizeof f->arena && fd_flush(f) < 0) {
+            return -1;
+        }
+        assert(n <= sizeof f->arena);
+        memcpy(f->arena + f->arena_used, p, n);
+        p = f->arena + f->arena_used;
+        f->arena_used += n;
+    }
+
+    last = f->niov ? &f->iov[f->niov - 1] : NULL;
+    if (last && (const char *)last->iov_base + last->iov_len == p) {
+        last->iov_len += n;
+        return 0;
+    }
+
+    if (f->niov == COUNTOF(f->iov)) {
+        if (stable) {
+            if (fd_flush(f) < 0) {
+                return -1;
+            }
+        } else {
+            /* the piece we just staged must survive the flush */
+            struct iovec v;
+            f->arena_used -= n;
+            if (fd_flush(f) < 0) {
+                return -1;
+            }
+            memmove(f->arena, p, n);
+            f->arena_used = n;
+            v.iov_base = f->arena;
+            v.iov_len = n;
+            f->iov[f->niov++] = v;
+            return 0;
+        }
+    }
+
+    f->iov[f->niov].iov_base = (char *)p;
+    f->iov[f->niov].iov_len = n;
+    f->niov++;
+    return 0;
 }
 
-size_t unibi_add_ext_bool(unibi_term *t, const char *c, int v) {
-    size_t r;
-    ASSERT_EXT_NAMES(t);
-    if (
-        !DYNARR(bool, ensure_slot)(&t->ext_bools) ||
-        !DYNARR(str, ensure_slot)(&t->ext_names)
-    ) {
+static size_t dump_fd(const unibi_term *t, int fd) {
+    struct dump_info layout;
+    const struct dump_info *di;
+    struct emitter e;
+    struct put_fd f;
+
+    if (!(di = plain_layout(t, &layout))) {
         return SIZE_ERR;
     }
-    {
-        const char **const p = t->ext_names.data + t->ext_bools.used;
-        memmove(p + 1, p, (t->ext_names.used - t->ext_bools.used) * sizeof *t->ext_names.data);
-        *p = c;
-        t->ext_names.used++;
+
+    f.fd = fd;
+    f.niov = 0;
+    f.arena_used = 0;
+    em_init(&e, put_fd, &f);
+    if (dump_emit(t, di, NULL, &e) < 0 || fd_flush(&f) < 0) {
+        return SIZE_ERR;
     }
-    r = t->ext_bools.used++;
-    t->ext_bools.data[r] = !!v;
-    return r;
+
+    return di->req;
 }
 
-size_t unibi_add_ext_num(unibi_term *t, const char *c, int v) {
-    size_t r;
-    ASSERT_EXT_NAMES(t);
-    if (
-        !DYNARR(num, ensure_slot)(&t->ext_nums) ||
-        !DYNARR(str, ensure_slot)(&t->ext_names)
-    ) {
+size_t unibi_dump_fd(const unibi_term *t, int fd) {
+    unibi_term *tmp;
+    if (!(t = solid(t, &tmp))) {
         return SIZE_ERR;
     }
-    {
-        const char **const p = t->ext_names.data + t->ext_bools.used + t->ext_nums.used;
-        memmove(p + 1, p, (t->ext_names.used - t->ext_bools.used - t->ext_nums.used) * sizeof *t->ext_names.data);
-        *p = c;
-        t->ext_names.used++;
+    return release(tmp, dump_fd(t, fd));
+}
+
+/* The image format is the in-memory form of a terminal object: native byte
+ * order, 4-byte aligned fields, and strings referenced by their offset from
+ * the start of the image. All strings live in one pool whose last byte is
+ * '\0', so an offset inside the pool always points at a terminated string.
+ * unibi_from_image() checks the header and bounds and decodes the tables into
+ * a new object without any byte shuffling; the strings stay in the caller's
+ * buffer. The str_info word of each standard string is stored next to its
+ * offset, so loading an image doesn't have to scan the strings. */
+
+#define IMAGE_MAGIC "unibiIMG"
+#define IMAGE_VERSION 2
+#define IMAGE_BYTE_ORDER 0x01020304UL
+#define IMAGE_NONE 0xffffffffUL
+
+struct image_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t size;
+    uint32_t nbools, nnums, nstrs;
+    uint32_t next_bools, next_nums, next_strs;
+    uint32_t naliases;
+    uint32_t name;
+    uint32_t aliases;
+    uint32_t bools, nums, strs, str_info;
+    uint32_t ext_bools, ext_nums, ext_strs, ext_names;
+    uint32_t pool, pool_size;
+};
+
+#define NBOOLS_ (unibi_boolean_end_ - unibi_boolean_begin_ - 1)
+
+static size_t align4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+static size_t image_str_size(const char *s) {
+    return s ? strlen(s) + 1 : 0;
+}
+
+/* computes the layout of t's image; returns 0 if it doesn't fit in 32 bits */
+static int image_layout(const unibi_term *t, struct image_header *h) {
+    size_t off, pool, i;
+    const size_t next = t->ext_names.used;
+
+    memcpy(h->magic, IMAGE_MAGIC, sizeof h->magic);
+    h->version = IMAGE_VERSION;
+    h->byte_order = IMAGE_BYTE_ORDER;
+    h->nbools = NBOOLS_;
+    h->nnums = COUNTOF(t->nums);
+    h->nstrs = COUNTOF(t->strs);
+    h->next_bools = t->ext_bools.used;
+    h->next_nums = t->ext_nums.used;
+    h->next_strs = t->ext_strs.used;
+
+    pool = image_str_size(t->name);
+    for (i = 0; t->aliases[i]; i++) {
+        pool += image_str_size(t->aliases[i]);
     }
-    r = t->ext_nums.used++;
-    t->ext_nums.data[r] = v;
-    return r;
+    h->naliases = i;
+    for (i = 0; i < COUNTOF(t->strs); i++) {
+        pool += image_str_size(t->strs[i]);
+    }
+    for (i = 0; i < t->ext_strs.used; i++) {
+        pool += image_str_size(t->ext_strs.data[i]);
+    }
+    for (i = 0; i < next; i++) {
+        pool += image_str_size(t->ext_names.data[i]);
+    }
+
+    off = sizeof *h;
+    h->aliases = off;
+    off += 4 * h->naliases;
+    h->nums = off;
+    off += 4 * h->nnums;
+    h->strs = off;
+    off += 4 * h->nstrs;
+    h->str_info = off;
+    off += 4 * h->nstrs;
+    h->ext_nums = off;
+    off += 4 * h->next_nums;
+    h->ext_strs = off;
+    off += 4 * h->next_strs;
+    h->ext_names = off;
+    off += 4 * next;
+    h->bools = off;
+    off += h->nbools;
+    h->ext_bools = off;
+    off += h->next_bools;
+    h->pool = off;
+    h->pool_size = pool;
+    off = align4(off + pool);
+
+    if (off > IMAGE_NONE || pool > IMAGE_NONE) {
+        return 0;
+    }
+    h->size = off;
+    h->name = 0;
+    return 1;
 }
 
-size_t unibi_add_ext_str(unibi_term *t, const char *c, const char *v) {
-    size_t r;
-    ASSERT_EXT_NAMES(t);
-    if (
-        !DYNARR(str, ensure_slot)(&t->ext_strs) ||
-        !DYNARR(str, ensure_slot)(&t->ext_names)
-    ) {
-        return SIZE_ERR;
+static void image_put32(char *p, size_t off, uint32_t v) {
+    memcpy(p + off, &v, sizeof v);
+}
+
+static uint32_t image_put_str(char *p, const struct image_header *h, size_t *used, const char *s) {
+    const size_t k = image_str_size(s);
+    uint32_t r;
+    if (!s) {
+        return IMAGE_NONE;
     }
-    t->ext_names.data[t->ext_names.used++] = c;
-    r = t->ext_strs.used++;
-    t->ext_strs.data[r] = v;
+    r = h->pool + *used;
+    memcpy(p + r, s, k);
+    *used += k;
     return r;
 }
 
-void unibi_del_ext_bool(unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_bools.used);
-    {
-        unsigned char *const p = t->ext_bools.data + i;
-        memmove(p, p + 1, (t->ext_bools.used - i - 1) * sizeof *t->ext_bools.data);
-        t->ext_bools.used--;
+static size_t dump_image(const unibi_term *t, char *p, size_t n) {
+    struct image_header h;
+    size_t i, used = 0;
+
+    if (!image_layout(t, &h)) {
+        errno = EINVAL;
+        return SIZE_ERR;
     }
-    {
-        const char **const p = t->ext_names.data + i;
-        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
-        t->ext_names.used--;
+    if (h.size > n) {
+        errno = EFAULT;
+        return h.size;
     }
-}
 
-void unibi_del_ext_num(unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_nums.used);
-    {
-        int *const p = t->ext_nums.data + i;
-        memmove(p, p + 1, (t->ext_nums.used - i - 1) * sizeof *t->ext_nums.data);
-        t->ext_nums.used--;
+    memset(p, '\0', h.size);
+
+    h.name = image_put_str(p, &h, &used, t->name);
+    for (i = 0; i < h.naliases; i++) {
+        image_put32(p, h.aliases + 4 * i, image_put_str(p, &h, &used, t->aliases[i]));
     }
-    {
-        const char **const p = t->ext_names.data + t->ext_bools.used + i;
-        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
-        t->ext_names.used--;
+    for (i = 0; i < h.nbools; i++) {
+        p[h.bools + i] = (char)(t->bools[i / CHAR_BIT] >> i % CHAR_BIT & 1);
+    }
+    for (i = 0; i < h.nnums; i++) {
+        image_put32(p, h.nums + 4 * i, (uint32_t)(int32_t)t->nums[i]);
     }
+    for (i = 0; i < h.nstrs; i++) {
+        image_put32(p, h.strs + 4 * i, image_put_str(p, &h, &used, t->strs[i]));
+        if (t->strs[i]) {
+            const unsigned info = t->str_info[i];
+            image_put32(p, h.str_info + 4 * i, info == STR_LONG ? IMAGE_NONE : info);
+        }
+    }
+    for (i = 0; i < h.next_bools; i++) {
+        p[h.ext_bools + i] = (char)t->ext_bools.data[i];
+    }
+    for (i = 0; i < h.next_nums; i++) {
+        image_put32(p, h.ext_nums + 4 * i, (uint32_t)(int32_t)t->ext_nums.data[i]);
+    }
+    for (i = 0; i < h.next_strs; i++) {
+        image_put32(p, h.ext_strs + 4 * i, image_put_str(p, &h, &used, t->ext_strs.data[i]));
+    }
+    for (i = 0; i < t->ext_names.used; i++) {
+        image_put32(p, h.ext_names + 4 * i, image_put_str(p, &h, &used, t->ext_names.data[i]));
+    }
+    assert(used == h.pool_size);
+
+    memcpy(p, &h, sizeof h);
+
+    return h.size;
 }
 
-void unibi_del_ext_str(unibi_term *t, size_t i) {
-    ASSERT_EXT_NAMES(t);
-    ASSERT_RETURN_(i < t->ext_strs.used);
-    {
-        const char **const p = t->ext_strs.data + i;
-        memmove(p, p + 1, (t->ext_strs.used - i - 1) * sizeof *t->ext_strs.data);
-        t->ext_strs.used--;
-    }
-    {
-        const char **const p = t->ext_names.data + t->ext_bools.used + t->ext_nums.used + i;
-        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
-        t->ext_names.used--;
+size_t unibi_dump_image(const unibi_term *t, char *p, size_t n) {
+    unibi_term *tmp;
+    if (!(t = solid(t, &tmp))) {
+        return SIZE_ERR;
     }
+    return release(tmp, dump_image(t, p, n));
 }
 
+#define FAIL_IF_(c, e, f) do { if (c) { f; errno = (e); return NULL; } } while (0)
+#define FAIL_IF(c, e) FAIL_IF_(c, e, (void)0)
+#define DEL_FAIL_IF(c, e, x) FAIL_IF_(c, e, unibi_destroy(x))
 
-unibi_var_t unibi_var_from_num(int i) {
-    unibi_var_t v;
-    v.p_ = NULL;
-    v.i_ = i;
-    return v;
+/* array of k elements of size w at off, inside the image and before the pool */
+static int image_array_ok(const struct image_header *h, uint32_t off, uint32_t k, size_t w) {
+    return off >= sizeof *h && off % w == 0 && off <= h->pool && k <= (h->pool - off) / w;
 }
 
-unibi_var_t unibi_var_from_str(char *p) {
-    unibi_var_t v;
-    assert(p != NULL);
-    v.i_ = INT_MIN;
-    v.p_ = p;
-    return v;
+static const char *image_str(const char *p, const struct image_header *h, uint32_t off, int *bad) {
+    if (off == IMAGE_NONE) {
+        return NULL;
+    }
+    if (off < h->pool || off - h->pool >= h->pool_size) {
+        *bad = 1;
+        return NULL;
+    }
+    return p + off;
 }
 
-int unibi_num_from_var(unibi_var_t v) {
-    return v.p_ ? INT_MIN : v.i_;
+/* str_info word v of the string at off (a valid pool offset): the length must
+ * end inside the pool, on a '\0' */
+static unsigned image_str_info(const char *p, const struct image_header *h, uint32_t off, uint32_t v, int *bad) {
+    const uint32_t len = v >> 1;
+    if (v == IMAGE_NONE) {
+        return STR_LONG;
+    }
+    if (len >= STR_LONG >> 1 || len >= h->pool_size - (off - h->pool) || p[off + len] != '\0') {
+        *bad = 1;
+        return 0;
+    }
+    return (unsigned)len << 1 | (v & STR_PLAIN);
 }
 
-const char *unibi_str_from_var(unibi_var_t v) {
-    return v.p_ ? v.p_ : "";
-}
+unibi_term *unibi_from_image(const char *p, size_t n) {
+    const struct image_header *h = (const void *)p;
+    const uint32_t *offs, *infos;
+    const int32_t *nums;
+    unibi_term *t;
+    size_t i, next;
+    int bad = 0;
+
+    FAIL_IF(n < sizeof *h, EFAULT);
+    FAIL_IF(((uintptr_t)p & 3) != 0, EINVAL);
+    FAIL_IF(
+        memcmp(h->magic, IMAGE_MAGIC, sizeof h->magic) != 0 ||
+        h->version != IMAGE_VERSION ||
+        h->byte_order != IMAGE_BYTE_ORDER,
+        EINVAL
+    );
+    FAIL_IF(n < h->size, EFAULT);
+    FAIL_IF(
+        h->pool > h->size || h->pool_size == 0 || h->pool_size > h->size - h->pool ||
+        p[h->pool + h->pool_size - 1] != '\0' ||
+        h->nbools > NBOOLS_ || h->nnums > COUNTOF(t->nums) || h->nstrs > COUNTOF(t->strs) ||
+        h->next_bools > MAX15BITS || h->next_nums > MAX15BITS || h->next_strs > MAX15BITS ||
+        !image_array_ok(h, h->aliases, h->naliases, 4) ||
+        !image_array_ok(h, h->nums, h->nnums, 4) ||
+        !image_array_ok(h, h->strs, h->nstrs, 4) ||
+        !image_array_ok(h, h->str_info, h->nstrs, 4) ||
+        !image_array_ok(h, h->ext_nums, h->next_nums, 4) ||
+        !image_array_ok(h, h->ext_strs, h->next_strs, 4) ||
+        !image_array_ok(h, h->ext_names, h->next_bools + h->next_nums + h->next_strs, 4) ||
+        !image_array_ok(h, h->bools, h->nbools, 1) ||
+        !image_array_ok(h, h->ext_bools, h->next_bools, 1),
+        EINVAL
+    );
+    next = h->next_bools + h->next_nums + h->next_strs;
 
-static void dput(
-    char t,
-    const char *fmt,
-    int w,
-    int p,
-    unibi_var_t x,
-    void (*out)(void *, const char *, size_t),
-    void *ctx
-) {
-    char buf[512];
-    buf[0] = '\0';
+    if (!(t = malloc(sizeof *t))) {
+        return NULL;
+    }
+    if (!(t->alloc = malloc((h->naliases + 1) * sizeof *t->aliases))) {
+        free(t);
+        return NULL;
+    }
+    t->aliases = (const char **)(void *)t->alloc;
+
+    DYNARR(bool, init)(&t->ext_bools);
+    DYNARR(num, init)(&t->ext_nums);
+    DYNARR(str, init)(&t->ext_strs);
+    DYNARR(str, init)(&t->ext_names);
+    t->ext_alloc = NULL;
+    t->progs = NULL;
+    t->memo = NULL;
+    t->ov = NULL;
+
+    t->name = image_str(p, h, h->name, &bad);
+    offs = (const uint32_t *)(const void *)(p + h->aliases);
+    for (i = 0; i < h->naliases; i++) {
+        t->aliases[i] = image_str(p, h, offs[i], &bad);
+    }
+    t->aliases[i] = NULL;
+    DEL_FAIL_IF(bad || !t->name, EINVAL, t);
+
+    memset(t->bools, '\0', sizeof t->bools);
+    for (i = 0; i < h->nbools; i++) {
+        if (p[h->bools + i]) {
+            t->bools[i / CHAR_BIT] |= 1 << i % CHAR_BIT;
+        }
+    }
+    nums = (const int32_t *)(const void *)(p + h->nums);
+    for (i = 0; i < h->nnums; i++) {
+        t->nums[i] = nums[i] < 0 ? -1 : nums[i];
+    }
+    fill_1(t->nums + i, COUNTOF(t->nums) - i);
+    offs = (const uint32_t *)(const void *)(p + h->strs);
+    infos = (const uint32_t *)(const void *)(p + h->str_info);
+    for (i = 0; i < h->nstrs; i++) {
+        if ((t->strs[i] = image_str(p, h, offs[i], &bad))) {
+            t->str_info[i] = image_str_info(p, h, offs[i], infos[i], &bad);
+        }
+    }
+    fill_null(t->strs + i, COUNTOF(t->strs) - i);
+
+    DEL_FAIL_IF(
+        !DYNARR(bool, ensure_slots)(&t->ext_bools, h->next_bools) ||
+        !DYNARR(num, ensure_slots)(&t->ext_nums, h->next_nums) ||
+        !DYNARR(str, ensure_slots)(&t->ext_strs, h->next_strs) ||
+        !DYNARR(str, ensure_slots)(&t->ext_names, next),
+        ENOMEM,
+        t
+    );
+    for (i = 0; i < h->next_bools; i++) {
+        t->ext_bools.data[i] = p[h->ext_bools + i] != 0;
+    }
+    t->ext_bools.used = h->next_bools;
+    nums = (const int32_t *)(const void *)(p + h->ext_nums);
+    for (i = 0; i < h->next_nums; i++) {
+        t->ext_nums.data[i] = nums[i] < 0 ? -1 : nums[i];
+    }
+    t->ext_nums.used = h->next_nums;
+    offs = (const uint32_t *)(const void *)(p + h->ext_strs);
+    for (i = 0; i < h->next_strs; i++) {
+        t->ext_strs.data[i] = image_str(p, h, offs[i], &bad);
+    }
+    t->ext_strs.used = h->next_strs;
+    offs = (const uint32_t *)(const void *)(p + h->ext_names);
+    for (i = 0; i < next; i++) {
+        t->ext_names.data[i] = image_str(p, h, offs[i], &bad);
+        bad |= !t->ext_names.data[i];
+    }
+    t->ext_names.used = next;
+    DEL_FAIL_IF(bad, EINVAL, t);
+
+    ASSERT_EXT_NAMES(t);
+
+    return t;
+}
+
+#undef FAIL_IF
+#undef FAIL_IF_
+#undef DEL_FAIL_IF
+
+const char *unibi_get_name(const unibi_term *t) {
+    return t->name;
+}
+
+void unibi_set_name(unibi_term *t, const char *s) {
+    ASSERT_RETURN_(!t->ov);
+    t->name = s;
+}
+
+const char **unibi_get_aliases(const unibi_term *t) {
+    return t->aliases;
+}
+
+void unibi_set_aliases(unibi_term *t, const char **a) {
+    ASSERT_RETURN_(!t->ov);
+    t->aliases = a;
+}
+
+int unibi_get_bool(const unibi_term *t, enum unibi_boolean v) {
+    size_t i;
+    ASSERT_RETURN(v > unibi_boolean_begin_ && v < unibi_boolean_end_, -1);
+    if (t->ov) {
+        return unibi_get_bool(t->ov->delta, v) || unibi_get_bool(t->ov->base, v);
+    }
+    i = v - unibi_boolean_begin_ - 1;
+    return t->bools[i / CHAR_BIT] >> i % CHAR_BIT & 1;
+}
+
+void unibi_set_bool(unibi_term *t, enum unibi_boolean v, int x) {
+    size_t i;
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(v > unibi_boolean_begin_ && v < unibi_boolean_end_);
+    i = v - unibi_boolean_begin_ - 1;
+    if (x) {
+        t->bools[i / CHAR_BIT] |= 1 << i % CHAR_BIT;
+    } else {
+        t->bools[i / CHAR_BIT] &= ~(1 << i % CHAR_BIT);
+    }
+}
+
+int unibi_get_num(const unibi_term *t, enum unibi_numeric v) {
+    size_t i;
+    ASSERT_RETURN(v > unibi_numeric_begin_ && v < unibi_numeric_end_, -2);
+    if (t->ov) {
+        const int x = unibi_get_num(t->ov->delta, v);
+        return x >= 0 ? x : unibi_get_num(t->ov->base, v);
+    }
+    i = v - unibi_numeric_begin_ - 1;
+    return t->nums[i];
+}
+
+void unibi_set_num(unibi_term *t, enum unibi_numeric v, int x) {
+    size_t i;
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(v > unibi_numeric_begin_ && v < unibi_numeric_end_);
+    i = v - unibi_numeric_begin_ - 1;
+    t->nums[i] = x;
+}
+
+const char *unibi_get_str(const unibi_term *t, enum unibi_string v) {
+    size_t i;
+    ASSERT_RETURN(v > unibi_string_begin_ && v < unibi_string_end_, NULL);
+    if (t->ov) {
+        const char *const x = unibi_get_str(t->ov->delta, v);
+        return x ? x : unibi_get_str(t->ov->base, v);
+    }
+    i = v - unibi_string_begin_ - 1;
+    return t->strs[i];
+}
+
+static void memo_clear(struct memo *m) {
+    size_t i;
+    m->used = 0;
+    m->head = m->tail = MEMO_NIL;
+    for (i = 0; i <= m->mask; i++) {
+        m->bucket[i] = MEMO_NIL;
+    }
+}
+
+static void memo_set_incr(struct memo *m, const unibi_term *t, size_t i) {
+    const unibi_prog *const prog = unibi_get_str_prog(t, unibi_string_begin_ + 1 + i);
+    m->incr[i] = prog ? memo_incr(prog) : MEMO_NO;
+}
+
+int unibi_set_memo_size(unibi_term *t, size_t n) {
+    struct memo *m = NULL;
+    size_t i;
+
+    if (n > MEMO_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (n) {
+        size_t nb = 1;
+        while (nb < n) {
+            nb <<= 1;
+        }
+        if (
+            !(m = malloc(sizeof *m)) ||
+            !(m->ent = malloc(n * sizeof *m->ent)) ||
+            !(m->bucket = malloc(nb * sizeof *m->bucket))
+        ) {
+            if (m) {
+                free(m->ent);
+                free(m);
+            }
+            return -1;
+        }
+        m->size = n;
+        m->mask = nb - 1;
+        memo_clear(m);
+        /* only compiled capabilities are cached */
+        unibi_compile_strs(t);
+        for (i = 0; i < COUNTOF(m->incr); i++) {
+            memo_set_incr(m, t, i);
+        }
+    }
+
+    if (t->memo) {
+        free(t->memo->bucket);
+        free(t->memo->ent);
+        free(t->memo);
+    }
+    t->memo = m;
+    return 0;
+}
+
+/* The length of string v, or SIZE_ERR if it's absent. *plain is set if the
+ * string can be output without interpreting it. */
+static size_t str_len_plain(const unibi_term *t, enum unibi_string v, int *plain) {
+    size_t i;
+    unsigned info;
+
+    if (t->ov) {
+        return str_len_plain(unibi_get_str(t->ov->delta, v) ? t->ov->delta : t->ov->base, v, plain);
+    }
+    i = v - unibi_string_begin_ - 1;
+    if (!t->strs[i]) {
+        *plain = 0;
+        return SIZE_ERR;
+    }
+    info = t->str_info[i];
+    if (info == STR_LONG) {
+        *plain = 0;
+        return strlen(t->strs[i]);
+    }
+    *plain = info & STR_PLAIN;
+    return info >> 1;
+}
+
+size_t unibi_get_str_len(const unibi_term *t, enum unibi_string v) {
+    int plain;
+    ASSERT_RETURN(v > unibi_string_begin_ && v < unibi_string_end_, SIZE_ERR);
+    return str_len_plain(t, v, &plain);
+}
+
+void unibi_set_str(unibi_term *t, enum unibi_string v, const char *x) {
+    size_t i;
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(v > unibi_string_begin_ && v < unibi_string_end_);
+    i = v - unibi_string_begin_ - 1;
+    t->strs[i] = x;
+    if (x) {
+        t->str_info[i] = str_info_of(x);
+    }
+    if (t->progs) {
+        /* if this fails, the string is interpreted instead */
+        unibi_prog_destroy(t->progs[i]);
+        t->progs[i] = x ? unibi_compile(x) : NULL;
+    }
+    if (t->memo) {
+        memo_set_incr(t->memo, t, i);
+        memo_clear(t->memo);
+    }
+}
+
+
+size_t unibi_count_ext_bool(const unibi_term *t) {
+    if (t->ov) {
+        return count_ext(t->ov->delta, unibi_cap_bool) + t->ov->nvis[unibi_cap_bool];
+    }
+    return t->ext_bools.used;
+}
+
+size_t unibi_count_ext_num(const unibi_term *t) {
+    if (t->ov) {
+        return count_ext(t->ov->delta, unibi_cap_num) + t->ov->nvis[unibi_cap_num];
+    }
+    return t->ext_nums.used;
+}
+
+size_t unibi_count_ext_str(const unibi_term *t) {
+    if (t->ov) {
+        return count_ext(t->ov->delta, unibi_cap_str) + t->ov->nvis[unibi_cap_str];
+    }
+    return t->ext_strs.used;
+}
+
+int unibi_get_ext_bool(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_bool, i), -1);
+        u = ov_ext(t->ov, unibi_cap_bool, &i);
+        return unibi_get_ext_bool(u, i);
+    }
+    ASSERT_RETURN(i < t->ext_bools.used, -1);
+    return t->ext_bools.data[i] ? 1 : 0;
+}
+
+const char *unibi_get_ext_bool_name(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_bool, i), NULL);
+        u = ov_ext(t->ov, unibi_cap_bool, &i);
+        return unibi_get_ext_bool_name(u, i);
+    }
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN(i < t->ext_bools.used, NULL);
+    return t->ext_names.data[i];
+}
+
+int unibi_get_ext_num(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_num, i), -2);
+        u = ov_ext(t->ov, unibi_cap_num, &i);
+        return unibi_get_ext_num(u, i);
+    }
+    ASSERT_RETURN(i < t->ext_nums.used, -2);
+    return t->ext_nums.data[i];
+}
+
+const char *unibi_get_ext_num_name(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_num, i), NULL);
+        u = ov_ext(t->ov, unibi_cap_num, &i);
+        return unibi_get_ext_num_name(u, i);
+    }
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN(i < t->ext_nums.used, NULL);
+    return t->ext_names.data[t->ext_bools.used + i];
+}
+
+const char *unibi_get_ext_str(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_str, i), NULL);
+        u = ov_ext(t->ov, unibi_cap_str, &i);
+        return unibi_get_ext_str(u, i);
+    }
+    ASSERT_RETURN(i < t->ext_strs.used, NULL);
+    return t->ext_strs.data[i];
+}
+
+const char *unibi_get_ext_str_name(const unibi_term *t, size_t i) {
+    if (t->ov) {
+        const unibi_term *u;
+        ASSERT_RETURN(ov_ext_ok(t->ov, unibi_cap_str, i), NULL);
+        u = ov_ext(t->ov, unibi_cap_str, &i);
+        return unibi_get_ext_str_name(u, i);
+    }
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN(i < t->ext_strs.used, NULL);
+    return t->ext_names.data[t->ext_bools.used + t->ext_nums.used + i];
+}
+
+void unibi_set_ext_bool(unibi_term *t, size_t i, int v) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(i < t->ext_bools.used);
+    t->ext_bools.data[i] = !!v;
+}
+
+void unibi_set_ext_bool_name(unibi_term *t, size_t i, const char *c) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_bools.used);
+    t->ext_names.data[i] = c;
+}
+
+void unibi_set_ext_num(unibi_term *t, size_t i, int v) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(i < t->ext_nums.used);
+    t->ext_nums.data[i] = v;
+}
+
+void unibi_set_ext_num_name(unibi_term *t, size_t i, const char *c) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_nums.used);
+    t->ext_names.data[t->ext_bools.used + i] = c;
+}
+
+void unibi_set_ext_str(unibi_term *t, size_t i, const char *v) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_RETURN_(i < t->ext_strs.used);
+    t->ext_strs.data[i] = v;
+}
+
+void unibi_set_ext_str_name(unibi_term *t, size_t i, const char *c) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_strs.used);
+    t->ext_names.data[t->ext_bools.used + t->ext_nums.used + i] = c;
+}
+
+size_t unibi_add_ext_bool(unibi_term *t, const char *c, int v) {
+    size_t r;
+    ASSERT_RETURN(!t->ov, SIZE_ERR);
+    ASSERT_EXT_NAMES(t);
+    if (
+        !DYNARR(bool, ensure_slot)(&t->ext_bools) ||
+        !DYNARR(str, ensure_slot)(&t->ext_names)
+    ) {
+        return SIZE_ERR;
+    }
+    {
+        const char **const p = t->ext_names.data + t->ext_bools.used;
+        memmove(p + 1, p, (t->ext_names.used - t->ext_bools.used) * sizeof *t->ext_names.data);
+        *p = c;
+        t->ext_names.used++;
+    }
+    r = t->ext_bools.used++;
+    t->ext_bools.data[r] = !!v;
+    return r;
+}
+
+size_t unibi_add_ext_num(unibi_term *t, const char *c, int v) {
+    size_t r;
+    ASSERT_RETURN(!t->ov, SIZE_ERR);
+    ASSERT_EXT_NAMES(t);
+    if (
+        !DYNARR(num, ensure_slot)(&t->ext_nums) ||
+        !DYNARR(str, ensure_slot)(&t->ext_names)
+    ) {
+        return SIZE_ERR;
+    }
+    {
+        const char **const p = t->ext_names.data + t->ext_bools.used + t->ext_nums.used;
+        memmove(p + 1, p, (t->ext_names.used - t->ext_bools.used - t->ext_nums.used) * sizeof *t->ext_names.data);
+        *p = c;
+        t->ext_names.used++;
+    }
+    r = t->ext_nums.used++;
+    t->ext_nums.data[r] = v;
+    return r;
+}
+
+size_t unibi_add_ext_str(unibi_term *t, const char *c, const char *v) {
+    size_t r;
+    ASSERT_RETURN(!t->ov, SIZE_ERR);
+    ASSERT_EXT_NAMES(t);
+    if (
+        !DYNARR(str, ensure_slot)(&t->ext_strs) ||
+        !DYNARR(str, ensure_slot)(&t->ext_names)
+    ) {
+        return SIZE_ERR;
+    }
+    t->ext_names.data[t->ext_names.used++] = c;
+    r = t->ext_strs.used++;
+    t->ext_strs.data[r] = v;
+    return r;
+}
+
+void unibi_del_ext_bool(unibi_term *t, size_t i) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_bools.used);
+    {
+        unsigned char *const p = t->ext_bools.data + i;
+        memmove(p, p + 1, (t->ext_bools.used - i - 1) * sizeof *t->ext_bools.data);
+        t->ext_bools.used--;
+    }
+    {
+        const char **const p = t->ext_names.data + i;
+        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
+        t->ext_names.used--;
+    }
+}
+
+void unibi_del_ext_num(unibi_term *t, size_t i) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_nums.used);
+    {
+        int *const p = t->ext_nums.data + i;
+        memmove(p, p + 1, (t->ext_nums.used - i - 1) * sizeof *t->ext_nums.data);
+        t->ext_nums.used--;
+    }
+    {
+        const char **const p = t->ext_names.data + t->ext_bools.used + i;
+        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
+        t->ext_names.used--;
+    }
+}
+
+void unibi_del_ext_str(unibi_term *t, size_t i) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    ASSERT_RETURN_(i < t->ext_strs.used);
+    {
+        const char **const p = t->ext_strs.data + i;
+        memmove(p, p + 1, (t->ext_strs.used - i - 1) * sizeof *t->ext_strs.data);
+        t->ext_strs.used--;
+    }
+    {
+        const char **const p = t->ext_names.data + t->ext_bools.used + t->ext_nums.used + i;
+        memmove(p, p + 1, (t->ext_names.used - i - 1) * sizeof *t->ext_names.data);
+        t->ext_names.used--;
+    }
+}
+
+size_t unibi_filter_ext(unibi_term *t, int (*keep)(void *, enum unibi_cap_type, size_t, const char *), void *ctx) {
+    const char **const names = t->ext_names.data;
+    size_t i, r = 0, w = 0, k;
+
+    ASSERT_RETURN(!t->ov, 0);
+    ASSERT_EXT_NAMES(t);
+
+    for (i = k = 0; i < t->ext_bools.used; i++, r++) {
+        if (keep(ctx, unibi_cap_bool, i, names[r])) {
+            t->ext_bools.data[k++] = t->ext_bools.data[i];
+            names[w++] = names[r];
+        }
+    }
+    t->ext_bools.used = k;
+
+    for (i = k = 0; i < t->ext_nums.used; i++, r++) {
+        if (keep(ctx, unibi_cap_num, i, names[r])) {
+            t->ext_nums.data[k++] = t->ext_nums.data[i];
+            names[w++] = names[r];
+        }
+    }
+    t->ext_nums.used = k;
+
+    for (i = k = 0; i < t->ext_strs.used; i++, r++) {
+        if (keep(ctx, unibi_cap_str, i, names[r])) {
+            t->ext_strs.data[k++] = t->ext_strs.data[i];
+            names[w++] = names[r];
+        }
+    }
+    t->ext_strs.used = k;
+
+    assert(r == t->ext_names.used);
+    t->ext_names.used = w;
+    ASSERT_EXT_NAMES(t);
+
+    return r - w;
+}
+
+void unibi_shrink_ext(unibi_term *t) {
+    ASSERT_RETURN_(!t->ov);
+    ASSERT_EXT_NAMES(t);
+    /* shrinking can't really fail; if realloc disagrees, keep the old block */
+    (void)DYNARR(bool, resize)(&t->ext_bools, t->ext_bools.used);
+    (void)DYNARR(num, resize)(&t->ext_nums, t->ext_nums.used);
+    (void)DYNARR(str, resize)(&t->ext_strs, t->ext_strs.used);
+    (void)DYNARR(str, resize)(&t->ext_names, t->ext_names.used);
+}
+
+struct unibi_ext_builder {
+    DYNARR_T(bool) bools;
+    DYNARR_T(num) nums;
+    DYNARR_T(str) strs;
+    DYNARR_T(str) bool_names;
+    DYNARR_T(str) num_names;
+    DYNARR_T(str) str_names;
+};
+
+unibi_ext_builder *unibi_ext_builder_create(void) {
+    unibi_ext_builder *b;
+
+    if (!(b = malloc(sizeof *b))) {
+        return NULL;
+    }
+
+    DYNARR(bool, init)(&b->bools);
+    DYNARR(num, init)(&b->nums);
+    DYNARR(str, init)(&b->strs);
+    DYNARR(str, init)(&b->bool_names);
+    DYNARR(str, init)(&b->num_names);
+    DYNARR(str, init)(&b->str_names);
+
+    return b;
+}
+
+void unibi_ext_builder_destroy(unibi_ext_builder *b) {
+    DYNARR(bool, free)(&b->bools);
+    DYNARR(num, free)(&b->nums);
+    DYNARR(str, free)(&b->strs);
+    DYNARR(str, free)(&b->bool_names);
+    DYNARR(str, free)(&b->num_names);
+    DYNARR(str, free)(&b->str_names);
+    free(b);
+}
+
+int unibi_ext_builder_add_bool(unibi_ext_builder *b, const char *c, int v) {
+    if (
+        !DYNARR(bool, ensure_slot)(&b->bools) ||
+        !DYNARR(str, ensure_slot)(&b->bool_names)
+    ) {
+        return -1;
+    }
+    b->bools.data[b->bools.used++] = !!v;
+    b->bool_names.data[b->bool_names.used++] = c;
+    return 0;
+}
+
+int unibi_ext_builder_add_num(unibi_ext_builder *b, const char *c, int v) {
+    if (
+        !DYNARR(num, ensure_slot)(&b->nums) ||
+        !DYNARR(str, ensure_slot)(&b->num_names)
+    ) {
+        return -1;
+    }
+    b->nums.data[b->nums.used++] = v;
+    b->num_names.data[b->num_names.used++] = c;
+    return 0;
+}
+
+int unibi_ext_builder_add_str(unibi_ext_builder *b, const char *c, const char *v) {
+    if (
+        !DYNARR(str, ensure_slot)(&b->strs) ||
+        !DYNARR(str, ensure_slot)(&b->str_names)
+    ) {
+        return -1;
+    }
+    b->strs.data[b->strs.used++] = v;
+    b->str_names.data[b->str_names.used++] = c;
+    return 0;
+}
+
+static const char **copy_names(const char **dst, const char *const *src, size_t n) {
+    if (n) {
+        memcpy(dst, src, n * sizeof *src);
+    }
+    return dst + n;
+}
+
+int unibi_ext_builder_commit(unibi_ext_builder *b, unibi_term *t) {
+    const size_t nbools = t->ext_bools.used + b->bools.used;
+    const size_t nnums = t->ext_nums.used + b->nums.used;
+    const size_t nstrs = t->ext_strs.used + b->strs.used;
+    const size_t nnames = nbools + nnums + nstrs;
+    const char **names, **q;
+
+    ASSERT_RETURN(!t->ov, -1);
+    ASSERT_EXT_NAMES(t);
+
+    if (nnames == t->ext_names.used) {
+        return 0;
+    }
+
+    /* Allocate everything up front, so a failure leaves t unchanged. */
+    if (
+        !(names = malloc(nnames * sizeof *names)) ||
+        !DYNARR(bool, resize)(&t->ext_bools, nbools) ||
+        !DYNARR(num, resize)(&t->ext_nums, nnums) ||
+        !DYNARR(str, resize)(&t->ext_strs, nstrs)
+    ) {
+        free(names);
+        return -1;
+    }
+
+    q = names;
+    q = copy_names(q, t->ext_names.data, t->ext_bools.used);
+    q = copy_names(q, b->bool_names.data, b->bools.used);
+    q = copy_names(q, t->ext_names.data + t->ext_bools.used, t->ext_nums.used);
+    q = copy_names(q, b->num_names.data, b->nums.used);
+    q = copy_names(q, t->ext_names.data + t->ext_bools.used + t->ext_nums.used, t->ext_strs.used);
+    q = copy_names(q, b->str_names.data, b->strs.used);
+    assert(q == names + nnames);
+
+    DYNARR(str, free)(&t->ext_names);
+    t->ext_names.data = names;
+    t->ext_names.used = t->ext_names.size = nnames;
+
+    if (b->bools.used) {
+        memcpy(t->ext_bools.data + t->ext_bools.used, b->bools.data, b->bools.used * sizeof *b->bools.data);
+    }
+    t->ext_bools.used = nbools;
+    if (b->nums.used) {
+        memcpy(t->ext_nums.data + t->ext_nums.used, b->nums.data, b->nums.used * sizeof *b->nums.data);
+    }
+    t->ext_nums.used = nnums;
+    if (b->strs.used) {
+        memcpy(t->ext_strs.data + t->ext_strs.used, b->strs.data, b->strs.used * sizeof *b->strs.data);
+    }
+    t->ext_strs.used = nstrs;
+
+    ASSERT_EXT_NAMES(t);
+
+    b->bools.used = b->nums.used = b->strs.used = 0;
+    b->bool_names.used = b->num_names.used = b->str_names.used = 0;
+
+    return 0;
+}
+
+/* 64-bit FNV-1a */
+#define FNV_OFFSET UINT64_C(0xcbf29ce484222325)
+#define FNV_PRIME  UINT64_C(0x100000001b3)
+
+static uint64_t hash_bytes(uint64_t h, const void *p, size_t n) {
+    const unsigned char *q = p;
+    while (n--) {
+        h ^= *q++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t hash_int32(uint64_t h, int n) {
+    char buf[4];
+    put_uint32(buf, (unsigned int)n);
+    return hash_bytes(h, buf, sizeof buf);
+}
+
+static uint64_t hash_str(uint64_t h, const char *s) {
+    const unsigned char tag = s ? 1 : 0;
+    h = hash_bytes(h, &tag, 1);
+    if (s) {
+        h = hash_bytes(h, s, strlen(s) + 1);
+    }
+    return h;
+}
+
+/* unibi_hash(), unibi_equal() and unibi_diff() only use the getters, so an
+ * overlay view is treated like the entry it stands for without copying it. */
+uint64_t unibi_hash(const unibi_term *t) {
+    unsigned char bools[sizeof t->bools];
+    const char **aliases;
+    enum unibi_cap_type type;
+    uint64_t h;
+    size_t i, n;
+    int k;
+
+    h = hash_str(FNV_OFFSET, unibi_get_name(t));
+    aliases = unibi_get_aliases(t);
+    for (i = 0; aliases[i]; i++) {
+        h = hash_str(h, aliases[i]);
+    }
+    h = hash_str(h, NULL);
+
+    memset(bools, '\0', sizeof bools);
+    for (k = unibi_boolean_begin_ + 1; k < unibi_boolean_end_; k++) {
+        if (unibi_get_bool(t, k)) {
+            i = k - unibi_boolean_begin_ - 1;
+            bools[i / CHAR_BIT] |= 1 << i % CHAR_BIT;
+        }
+    }
+    h = hash_bytes(h, bools, sizeof bools);
+    for (k = unibi_numeric_begin_ + 1; k < unibi_numeric_end_; k++) {
+        h = hash_int32(h, unibi_get_num(t, k));
+    }
+    for (k = unibi_string_begin_ + 1; k < unibi_string_end_; k++) {
+        h = hash_str(h, unibi_get_str(t, k));
+    }
+
+    for (type = unibi_cap_bool; type <= unibi_cap_str; type++) {
+        h = hash_int32(h, (int)count_ext(t, type));
+    }
+    n = unibi_count_ext_bool(t);
+    for (i = 0; i < n; i++) {
+        const unsigned char b = !!unibi_get_ext_bool(t, i);
+        h = hash_bytes(h, &b, 1);
+    }
+    n = unibi_count_ext_num(t);
+    for (i = 0; i < n; i++) {
+        h = hash_int32(h, unibi_get_ext_num(t, i));
+    }
+    n = unibi_count_ext_str(t);
+    for (i = 0; i < n; i++) {
+        h = hash_str(h, unibi_get_ext_str(t, i));
+    }
+    for (type = unibi_cap_bool; type <= unibi_cap_str; type++) {
+        n = count_ext(t, type);
+        for (i = 0; i < n; i++) {
+            h = hash_str(h, ext_name(t, type, i));
+        }
+    }
+
+    return h;
+}
+
+static int str_equal(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static int ext_same(const unibi_term *a, const unibi_term *b, enum unibi_cap_type type, size_t ia, size_t ib) {
+    switch (type) {
+        case unibi_cap_bool: return !unibi_get_ext_bool(a, ia) == !unibi_get_ext_bool(b, ib);
+        case unibi_cap_num:  return unibi_get_ext_num(a, ia) == unibi_get_ext_num(b, ib);
+        case unibi_cap_str:  return str_equal(unibi_get_ext_str(a, ia), unibi_get_ext_str(b, ib));
+    }
+    return 0;
+}
+
+int unibi_equal(const unibi_term *a, const unibi_term *b) {
+    const char **aa, **ab;
+    enum unibi_cap_type type;
+    size_t i, n;
+    int k;
+
+    if (a == b) {
+        return 1;
+    }
+
+    if (!str_equal(unibi_get_name(a), unibi_get_name(b))) {
+        return 0;
+    }
+    aa = unibi_get_aliases(a);
+    ab = unibi_get_aliases(b);
+    for (i = 0; aa[i] && ab[i]; i++) {
+        if (!str_equal(aa[i], ab[i])) {
+            return 0;
+        }
+    }
+    if (aa[i] || ab[i]) {
+        return 0;
+    }
+
+    for (k = unibi_boolean_begin_ + 1; k < unibi_boolean_end_; k++) {
+        if (!unibi_get_bool(a, k) != !unibi_get_bool(b, k)) {
+            return 0;
+        }
+    }
+    for (k = unibi_numeric_begin_ + 1; k < unibi_numeric_end_; k++) {
+        if (unibi_get_num(a, k) != unibi_get_num(b, k)) {
+            return 0;
+        }
+    }
+    for (k = unibi_string_begin_ + 1; k < unibi_string_end_; k++) {
+        if (!str_equal(unibi_get_str(a, k), unibi_get_str(b, k))) {
+            return 0;
+        }
+    }
+
+    for (type = unibi_cap_bool; type <= unibi_cap_str; type++) {
+        n = count_ext(a, type);
+        if (n != count_ext(b, type)) {
+            return 0;
+        }
+        for (i = 0; i < n; i++) {
+            if (!str_equal(ext_name(a, type, i), ext_name(b, type, i)) || !ext_same(a, b, type, i, i)) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+typedef struct {
+    const char *name;
+    size_t i;
+} ext_ref;
+
+static int cmp_ext_ref(const void *va, const void *vb) {
+    const ext_ref *a = va, *b = vb;
+    const int r = strcmp(a->name, b->name);
+    if (r) {
+        return r;
+    }
+    return a->i < b->i ? -1 : a->i > b->i;
+}
+
+static void ext_refs(ext_ref *p, const unibi_term *t, enum unibi_cap_type type, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        p[i].name = ext_name(t, type, i);
+        p[i].i = i;
+    }
+    qsort(p, n, sizeof *p, cmp_ext_ref);
+}
+
+/* match up extended capabilities of one type by name */
+static void diff_ext(
+    const unibi_term *a, const unibi_term *b,
+    enum unibi_cap_type type,
+    ext_ref *ra, ext_ref *rb,
+    void (*cb)(void *, enum unibi_diff_op, enum unibi_cap_type, int, size_t, size_t),
+    void *ctx
+) {
+    const size_t na = count_ext(a, type), nb = count_ext(b, type);
+    size_t i = 0, k = 0;
+
+    ext_refs(ra, a, type, na);
+    ext_refs(rb, b, type, nb);
+
+    while (i < na || k < nb) {
+        const int r = i == na ? 1 : k == nb ? -1 : strcmp(ra[i].name, rb[k].name);
+        if (r < 0) {
+            cb(ctx, unibi_diff_removed, type, -1, ra[i].i, SIZE_ERR);
+            i++;
+        } else if (r > 0) {
+            cb(ctx, unibi_diff_added, type, -1, SIZE_ERR, rb[k].i);
+            k++;
+        } else {
+            if (!ext_same(a, b, type, ra[i].i, rb[k].i)) {
+                cb(ctx, unibi_diff_changed, type, -1, ra[i].i, rb[k].i);
+            }
+            i++;
+            k++;
+        }
+    }
+}
+
+int unibi_diff(
+    const unibi_term *a,
+    const unibi_term *b,
+    void (*cb)(void *, enum unibi_diff_op, enum unibi_cap_type, int, size_t, size_t),
+    void *ctx
+) {
+    ext_ref *ra, *rb;
+    int k;
+
+    ra = malloc((unibi_count_ext_bool(a) + unibi_count_ext_num(a) + unibi_count_ext_str(a) + 1) * sizeof *ra);
+    rb = malloc((unibi_count_ext_bool(b) + unibi_count_ext_num(b) + unibi_count_ext_str(b) + 1) * sizeof *rb);
+    if (!ra || !rb) {
+        free(ra);
+        free(rb);
+        return -1;
+    }
+
+    for (k = unibi_boolean_begin_ + 1; k < unibi_boolean_end_; k++) {
+        const int x = unibi_get_bool(a, k), y = unibi_get_bool(b, k);
+        if (!x != !y) {
+            cb(ctx, x ? unibi_diff_removed : unibi_diff_added, unibi_cap_bool, k, SIZE_ERR, SIZE_ERR);
+        }
+    }
+    diff_ext(a, b, unibi_cap_bool, ra, rb, cb, ctx);
+
+    for (k = unibi_numeric_begin_ + 1; k < unibi_numeric_end_; k++) {
+        const int x = unibi_get_num(a, k), y = unibi_get_num(b, k);
+        if (x != y) {
+            cb(
+                ctx,
+                x == -1 ? unibi_diff_added : y == -1 ? unibi_diff_removed : unibi_diff_changed,
+                unibi_cap_num,
+                k,
+                SIZE_ERR, SIZE_ERR
+            );
+        }
+    }
+    diff_ext(a, b, unibi_cap_num, ra, rb, cb, ctx);
+
+    for (k = unibi_string_begin_ + 1; k < unibi_string_end_; k++) {
+        const char *const x = unibi_get_str(a, k), *const y = unibi_get_str(b, k);
+        if (!str_equal(x, y)) {
+            cb(
+                ctx,
+                !x ? unibi_diff_added : !y ? unibi_diff_removed : unibi_diff_changed,
+                unibi_cap_str,
+                k,
+                SIZE_ERR, SIZE_ERR
+            );
+        }
+    }
+    diff_ext(a, b, unibi_cap_str, ra, rb, cb, ctx);
+
+    free(ra);
+    free(rb);
+    return 0;
+}
+
+
+unibi_var_t unibi_var_from_num(int i) {
+    unibi_var_t v;
+    v.p_ = NULL;
+    v.i_ = i;
+    return v;
+}
+
+unibi_var_t unibi_var_from_str(char *p) {
+    unibi_var_t v;
+    assert(p != NULL);
+    v.i_ = INT_MIN;
+    v.p_ = p;
+    return v;
+}
+
+int unibi_num_from_var(unibi_var_t v) {
+    return v.p_ ? INT_MIN : v.i_;
+}
+
+const char *unibi_str_from_var(unibi_var_t v) {
+    return v.p_ ? v.p_ : "";
+}
+
+static long cstrtol(const char *s, const char **pp) {
+    long r;
+    char *tmp;
+    r = strtol(s, &tmp, 10);
+    *pp = tmp;
+    return r;
+}
+
+/* Parse the padding instruction at fmt, which points just past the '$'.
+ * Returns a pointer past the closing '>', or NULL if there is no valid
+ * padding instruction (and the '$' is literal). */
+static const char *parse_pad(const char *fmt, size_t *pn, int *pscale, int *pforce) {
+    int scale = 0, force = 0;
+    const char *v = fmt + 1;
+    size_t n;
+
+    if (!(*fmt == '<' && isdigit((unsigned char)fmt[1]))) {
+        return NULL;
+    }
+    n = cstrtol(v, &v);
+    n *= 10;
+    if (*v == '.') {
+        ++v;
+    }
+    if (isdigit((unsigned char)*v)) {
+        n += *v++ - '0';
+    }
+    if (*v == '/') {
+        ++v;
+        force = 1;
+        if (*v == '*') {
+            ++v;
+            scale = 1;
+        }
+    } else if (*v == '*') {
+        ++v;
+        scale = 1;
+        if (*v == '/') {
+            ++v;
+            force = 1;
+        }
+    }
+    if (*v != '>') {
+        return NULL;
+    }
+    *pn = n;
+    *pscale = scale;
+    *pforce = force;
+    return v + 1;
+}
+
+enum {
+    FlagAlt = 1,
+    FlagSpc = 2,
+    FlagSgn = 4,
+    FlagLft = 8,
+    FlagZro = 16
+};
+
+struct out_spec {
+    int flags, width, prec;
+    char conv;
+};
+
+/* Parse a printf-style output code at fmt, which points just past the '%'.
+ * Returns a pointer to the conversion character, or NULL if fmt doesn't start
+ * an output code. */
+static const char *parse_spec(const char *fmt, struct out_spec *sp) {
+    const char *v = fmt;
+
+    if (!(isdigit((unsigned char)*fmt) || (*fmt && strchr(":# .doxX", *fmt)))) {
+        return NULL;
+    }
+    sp->flags = 0;
+    sp->width = -1;
+    sp->prec = -1;
+    if (*v == ':') {
+        ++v;
+    }
+    while (1) {
+        switch (*v++) {
+            case '#': sp->flags |= FlagAlt; continue;
+            case ' ': sp->flags |= FlagSpc; continue;
+            case '0': sp->flags |= FlagZro; continue;
+            case '+': sp->flags |= FlagSgn; continue;
+            case '-': sp->flags |= FlagLft; continue;
+        }
+        --v;
+        break;
+    }
+    if (isdigit((unsigned char)*v)) {
+        sp->width = cstrtol(v, &v);
+    }
+    if (*v == '.' && isdigit((unsigned char)v[1])) {
+        ++v;
+        sp->prec = cstrtol(v, &v);
+    }
+    sp->conv = *v && strchr("doxXs", *v) ? *v : '\0';
+    return v;
+}
+
+/* the printf format for an output code, with '*' for width and precision */
+static void spec_gen(char *gen, const struct out_spec *sp) {
+    char *g = gen;
+    *g++ = '%';
+    if (sp->flags & FlagAlt) { *g++ = '#'; }
+    if (sp->flags & FlagSpc) { *g++ = ' '; }
+    if (sp->flags & FlagSgn) { *g++ = '+'; }
+    if (sp->flags & FlagLft) { *g++ = '-'; }
+    if (sp->flags & FlagZro) { *g++ = '0'; }
+    if (sp->width != -1) { *g++ = '*'; }
+    if (sp->prec  != -1) { *g++ = '.'; *g++ = '*'; }
+    *g++ = sp->conv;
+    *g = '\0';
+}
+
+#define SPEC_GEN_SIZE (sizeof "%# +-0*.*d")
+
+/* Where the interpreters send their output: a callback, a unibi_buf (without
+ * an indirect call), or a unibi_iovbuf. Once the buffer can't take more,
+ * further output is dropped and failed is set. */
+struct sink {
+    void (*out)(void *, const char *, size_t);
+    void *ctx;
+    unibi_buf *buf;
+    unibi_iovbuf *iov;
+    int failed;
+};
+
+static void sink_init(struct sink *sk, void (*out)(void *, const char *, size_t), void *ctx, unibi_buf *buf) {
+    sk->out = out;
+    sk->ctx = ctx;
+    sk->buf = buf;
+    sk->iov = NULL;
+    sk->failed = 0;
+}
+
+/* append an iovec entry for n bytes at p, which must stay valid */
+static void iov_add(struct sink *sk, const char *p, size_t n) {
+    unibi_iovbuf *const v = sk->iov;
+    struct iovec *last;
+
+    if (!n || sk->failed) {
+        return;
+    }
+    last = v->iovcnt ? &v->iov[v->iovcnt - 1] : NULL;
+    if (last && (const char *)last->iov_base + last->iov_len == p) {
+        last->iov_len += n;
+        return;
+    }
+    if (v->iovcnt == v->iovmax) {
+        sk->failed = 1;
+        return;
+    }
+    v->iov[v->iovcnt].iov_base = (char *)p;
+    v->iov[v->iovcnt].iov_len = n;
+    v->iovcnt++;
+}
+
+/* make room for n more bytes in sk->buf */
+static int sink_reserve(struct sink *sk, size_t n) {
+    unibi_buf *const b = sk->buf;
+    size_t k;
+    char *p;
+
+    if (n <= b->size - b->len) {
+        return 1;
+    }
+    if (sk->failed) {
+        return 0;
+    }
+    k = b->size;
+    while (b->len + n > k) {
+        k = k < 32 ? 64 : k * 2;
+    }
+    if (!(p = realloc(b->data, k))) {
+        sk->failed = 1;
+        return 0;
+    }
+    b->data = p;
+    b->size = k;
+    return 1;
+}
+
+/* Space for writing n bytes directly to the sink, or NULL. The bytes
+ * actually written are handed over with sink_commit(). */
+static char *sink_room(struct sink *sk, size_t n) {
+    if (sk->buf) {
+        return sink_reserve(sk, n) ? sk->buf->data + sk->buf->len : NULL;
+    }
+    if (sk->iov) {
+        unibi_iovbuf *const v = sk->iov;
+        return n <= v->scratch_size - v->scratch_used ? v->scratch + v->scratch_used : NULL;
+    }
+    return NULL;
+}
+
+static void sink_commit(struct sink *sk, char *p, size_t n) {
+    if (sk->buf) {
+        sk->buf->len += n;
+    } else {
+        sk->iov->scratch_used += n;
+        iov_add(sk, p, n);
+    }
+}
+
+/* output n bytes at p, which may go away after the call */
+static void sink_put(struct sink *sk, const char *p, size_t n) {
+    char *q;
+    if (!sk->buf && !sk->iov) {
+        sk->out(sk->ctx, p, n);
+        return;
+    }
+    if (!n) {
+        /* a fresh unibi_buf has no storage to point into */
+        return;
+    }
+    if ((q = sink_room(sk, n))) {
+        memcpy(q, p, n);
+        sink_commit(sk, q, n);
+    } else {
+        sk->failed = 1;
+    }
+}
+
+/* output n bytes at p, which stay valid as long as the format string (or
+ * program) and the parameters do */
+static void sink_ref(struct sink *sk, const char *p, size_t n) {
+    if (sk->iov) {
+        iov_add(sk, p, n);
+    } else {
+        sink_put(sk, p, n);
+    }
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Format x for %d, %x or %X with an optional '0' flag and width, without
+ * going through snprintf(). Returns the length, or 0 if the output code needs
+ * the general path. */
+static size_t fast_int(char *buf, size_t size, const struct out_spec *sp, int x) {
+    char tmp[3 * sizeof x], *const end = tmp + sizeof tmp, *p = end;
+    const int zero = sp->flags == FlagZro, neg = sp->conv == 'd' && x < 0;
+    size_t n, fill, k = 0;
+
+    if (
+        !(sp->flags == 0 || zero) ||
+        sp->prec != -1 ||
+        sp->width >= (int)size ||
+        !(sp->conv == 'd' || sp->conv == 'x' || sp->conv == 'X')
+    ) {
+        return 0;
+    }
+
+    if (sp->conv == 'd') {
+        unsigned u = neg ? 0u - (unsigned)x : (unsigned)x;
+        while (u >= 100) {
+            const unsigned i = u % 100 * 2;
+            u /= 100;
+            *--p = digit_pairs[i + 1];
+            *--p = digit_pairs[i];
+        }
+        if (u >= 10) {
+            *--p = digit_pairs[u * 2 + 1];
+            *--p = digit_pairs[u * 2];
+        } else {
+            *--p = '0' + u;
+        }
+    } else {
+        const char *const xdigits = sp->conv == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+        unsigned u = (unsigned)x;
+        do {
+            *--p = xdigits[u & 0xf];
+            u >>= 4;
+        } while (u);
+    }
+
+    n = end - p;
+    fill = sp->width > 0 && (size_t)sp->width > n + neg ? sp->width - (n + neg) : 0;
+    if (!zero) {
+        memset(buf, ' ', fill);
+        k = fill;
+    }
+    if (neg) {
+        buf[k++] = '-';
+    }
+    if (zero) {
+        memset(buf + k, '0', fill);
+        k += fill;
+    }
+    memcpy(buf + k, p, n);
+    return k + n;
+}
+
+/* output codes are formatted into a buffer of this size, which limits them to
+ * DPUT_BUF - 1 bytes */
+#define DPUT_BUF 512
+
+static void dput(
+    const struct out_spec *sp,
+    const char *fmt,
+    unibi_var_t x,
+    struct sink *sk
+) {
+    const char t = sp->conv;
+    const int w = sp->width, p = sp->prec;
+    char buf[DPUT_BUF];
+
+    if (t != 's') {
+        size_t n;
+        /* digits go straight into the sink's storage if there's room */
+        const size_t room = (w > 0 ? (size_t)w : 0) + 3 * sizeof (int);
+        char *q;
+        if (w < (int)sizeof buf && (q = sink_room(sk, room))) {
+            if ((n = fast_int(q, room, sp, unibi_num_from_var(x)))) {
+                sink_commit(sk, q, n);
+                return;
+            }
+        } else if ((n = fast_int(buf, sizeof buf, sp, unibi_num_from_var(x)))) {
+            sink_put(sk, buf, n);
+            return;
+        }
+    }
+    buf[0] = '\0';
+
+#define BITTY(A, B, C) (!!(A) << 0 | !!(B) << 1 | !!(C) << 2)
+
+    switch (BITTY(t == 's', w != -1, p != -1)) {
+        case BITTY(0, 0, 0): snprintf(buf, sizeof buf, fmt,       unibi_num_from_var(x)); break;
+        case BITTY(0, 0, 1): snprintf(buf, sizeof buf, fmt,    p, unibi_num_from_var(x)); break;
+        case BITTY(0, 1, 0): snprintf(buf, sizeof buf, fmt, w,    unibi_num_from_var(x)); break;
+        case BITTY(0, 1, 1): snprintf(buf, sizeof buf, fmt, w, p, unibi_num_from_var(x)); break;
+        case BITTY(1, 0, 0): snprintf(buf, sizeof buf, fmt,       unibi_str_from_var(x)); break;
+        case BITTY(1, 0, 1): snprintf(buf, sizeof buf, fmt,    p, unibi_str_from_var(x)); break;
+        case BITTY(1, 1, 0): snprintf(buf, sizeof buf, fmt, w,    unibi_str_from_var(x)); break;
+        case BITTY(1, 1, 1): snprintf(buf, sizeof buf, fmt, w, p, unibi_str_from_var(x)); break;
+    }
+
+#undef BITTY
+
+    sink_put(sk, buf, strlen(buf));
+}
+
+/* Skip the rest of a conditional branch. fmt points just past a '%t' (if
+ * stop_at_else is set) or '%e'. Returns a pointer past the matching '%;' (or
+ * '%e'), or to the terminating '\0'. */
+static const char *skip_branch(const char *fmt, int stop_at_else) {
+    size_t nesting = 0;
+    for (; *fmt; ++fmt) {
+        if (*fmt == '%') {
+            ++fmt;
+            if (*fmt == '?') {
+                ++nesting;
+            } else if (*fmt == ';') {
+                if (!nesting) {
+                    ++fmt;
+                    break;
+                }
+                --nesting;
+            } else if (*fmt == 'e' && stop_at_else && !nesting) {
+                ++fmt;
+                break;
+            } else if (!*fmt) {
+                break;
+            }
+        }
+    }
+    return fmt;
+}
+
+/* The variables of a format string. dyn and stat point to %Pa..%Pz and
+ * %PA..%PZ. fresh has a bit for every variable that reads as zero until it is
+ * assigned, whatever its slot holds, so those slots need no clearing. */
+struct fmt_vars {
+    unibi_var_t *dyn, *stat;
+    uint64_t fresh;
+};
+
+#define VARS_NONE ((uint64_t)0)
+#define VARS_DYN (((uint64_t)1 << 26) - 1)
+#define VARS_ALL (((uint64_t)1 << 52) - 1)
+
+static void vars_init(struct fmt_vars *v, unibi_var_t *dyn, unibi_var_t *stat, uint64_t fresh) {
+    v->dyn = dyn;
+    v->stat = stat;
+    v->fresh = fresh;
+}
+
+/* i is 0..25 for the dynamic variables and 26..51 for the static ones */
+static unibi_var_t var_get(const struct fmt_vars *v, unsigned i) {
+    const unibi_var_t zero = {0};
+    if (v->fresh >> i & 1) {
+        return zero;
+    }
+    return i < 26 ? v->dyn[i] : v->stat[i - 26];
+}
+
+static void var_set(struct fmt_vars *v, unsigned i, unibi_var_t x) {
+    v->fresh &= ~((uint64_t)1 << i);
+    if (i < 26) {
+        v->dyn[i] = x;
+    } else {
+        v->stat[i - 26] = x;
+    }
+}
+
+static void format(
+    struct fmt_vars *vars,
+    const char *fmt,
+    unibi_var_t param[9],
+    struct sink *sk,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    const unibi_var_t zero = {0};
+    /* only the slots below sp are ever read */
+    unibi_var_t stack[123];
+    size_t sp = 0;
+
+#define POP() (sp ? stack[--sp] : zero)
+#define PUSH(X) do { if (sp < COUNTOF(stack)) { stack[sp++] = (X); } } while (0)
+#define PUSHi(N) do { unibi_var_t tmp_ = unibi_var_from_num(N); PUSH(tmp_); } while (0)
+
+    while (*fmt) {
+        {
+            size_t r = strcspn(fmt, "%$");
+            if (r) {
+                sink_ref(sk, fmt, r);
+                fmt += r;
+                if (!*fmt) {
+                    break;
+                }
+            }
+        }
+
+        if (*fmt == '$') {
+            size_t n;
+            int scale, force;
+            const char *v = parse_pad(++fmt, &n, &scale, &force);
+            if (v) {
+                fmt = v;
+                if (pad) {
+                    pad(ctx2, n, scale, force);
+                }
+            } else {
+                sink_ref(sk, fmt - 1, 1);
+            }
+            continue;
+        }
+
+        assert(*fmt == '%');
+        ++fmt;
+
+        {
+            struct out_spec spec;
+            const char *v = parse_spec(fmt, &spec);
+            if (v) {
+                if (spec.conv) {
+                    char gen[SPEC_GEN_SIZE];
+                    spec_gen(gen, &spec);
+                    dput(&spec, gen, POP(), sk);
+                    fmt = v;
+                } else {
+                    sink_ref(sk, fmt - 1, 2);
+                }
+                ++fmt;
+                continue;
+            }
+        }
+
+        switch (*fmt++) {
+            default:
+                sink_ref(sk, fmt - 2, 2);
+                break;
+
+            case '\0':
+                --fmt;
+                sink_ref(sk, "%", 1);
+                break;
+
+            case '%':
+                sink_ref(sk, "%", 1);
+                break;
+
+            case 'c': {
+                unsigned char c;
+                c = unibi_num_from_var(POP());
+                sink_put(sk, (const char *)&c, 1);
+                break;
+            }
+
+            case 's': {
+                const char *s;
+                s = unibi_str_from_var(POP());
+                sink_ref(sk, s, strlen(s));
+                break;
+            }
+
+            case 'p':
+                if (*fmt >= '1' && *fmt <= '9') {
+                    size_t n = *fmt++ - '1';
+                    PUSH(param[n]);
+                } else {
+                    sink_ref(sk, fmt - 2, 2);
+                }
+                break;
+
+            case 'P':
+                if (*fmt >= 'a' && *fmt <= 'z') {
+                    var_set(vars, *fmt - 'a', POP());
+                    fmt++;
+                } else if (*fmt >= 'A' && *fmt <= 'Z') {
+                    var_set(vars, 26 + *fmt - 'A', POP());
+                    fmt++;
+                } else {
+                    sink_ref(sk, fmt - 2, 2);
+                }
+                break;
+
+            case 'g':
+                if (*fmt >= 'a' && *fmt <= 'z') {
+                    PUSH(var_get(vars, *fmt - 'a'));
+                    fmt++;
+                } else if (*fmt >= 'A' && *fmt <= 'Z') {
+                    PUSH(var_get(vars, 26 + *fmt - 'A'));
+                    fmt++;
+                } else {
+                    sink_ref(sk, fmt - 2, 2);
+                }
+                break;
+
+            case '\'':
+                if (*fmt && fmt[1] == '\'') {
+                    PUSHi((unsigned char)*fmt);
+                    fmt += 2;
+                } else {
+                    sink_ref(sk, fmt - 2, 2);
+                }
+                break;
+
+            case '{': {
+                size_t r = strspn(fmt, "0123456789");
+                if (r && fmt[r] == '}') {
+                    PUSHi(atoi(fmt));
+                    fmt += r + 1;
+                } else {
+                    sink_ref(sk, fmt - 2, 2);
+                }
+                break;
+            }
+
+            case 'l':
+                PUSHi(strlen(unibi_str_from_var(POP())));
+                break;
+
+            case 'i':
+                param[0] = unibi_var_from_num(unibi_num_from_var(param[0]) + 1);
+                param[1] = unibi_var_from_num(unibi_num_from_var(param[1]) + 1);
+                break;
+
+            case '?':
+                break;
+
+            case 't':
+                if (!unibi_num_from_var(POP())) {
+                    fmt = skip_branch(fmt, 1);
+                }
+                break;
+
+            case 'e':
+                fmt = skip_branch(fmt, 0);
+                break;
+
+            case ';':
+                break;
+
+#define ARITH2(C, E) \
+    case (C): { \
+        int x, y; \
+        y = unibi_num_from_var(POP()); \
+        x = unibi_num_from_var(POP()); \
+        PUSHi(E); \
+    } break
+
+            ARITH2('+', x + y);
+            ARITH2('-', x - y);
+            ARITH2('*', x * y);
+            /* like ncurses, division by zero pushes 0 */
+            ARITH2('/', y ? x / y : 0);
+            ARITH2('m', y ? x % y : 0);
+            ARITH2('&', x & y);
+            ARITH2('|', x | y);
+            ARITH2('^', x ^ y);
+            ARITH2('=', x == y);
+            ARITH2('<', x < y);
+            ARITH2('>', x > y);
+            ARITH2('A', x && y);
+            ARITH2('O', x || y);
+
+#undef ARITH2
+
+#define ARITH1(C, O) \
+    case (C): \
+        PUSHi(O unibi_num_from_var(POP())); \
+        break
+
+            ARITH1('!', !);
+            ARITH1('~', ~);
+
+#undef ARITH1
+        }
+    }
+
+#undef PUSHi
+#undef PUSH
+#undef POP
+}
+
+void unibi_format(
+    unibi_var_t var_dyn[26],
+    unibi_var_t var_static[26],
+    const char *fmt,
+    unibi_var_t param[9],
+    void (*out)(void *, const char *, size_t),
+    void *ctx1,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    struct fmt_vars vars;
+    struct sink sk;
+    vars_init(&vars, var_dyn, var_static, VARS_NONE);
+    sink_init(&sk, out, ctx1, NULL);
+    format(&vars, fmt, param, &sk, pad, ctx2);
+}
+
+typedef struct {
+    char *p;
+    size_t n, w;
+} run_ctx_t;
+
+static size_t xmin(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static void out(void *vctx, const char *p, size_t n) {
+    run_ctx_t *ctx = vctx;
+    size_t k = xmin(n, ctx->n);
+    ctx->w += n;
+    memcpy(ctx->p, p, k);
+    ctx->p += k;
+    ctx->n -= k;
+}
+
+size_t unibi_run(const char *fmt, unibi_var_t param[9], char *p, size_t n) {
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+    run_ctx_t ctx;
+
+    ctx.p = p;
+    ctx.n = n;
+    ctx.w = 0;
+
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, out, &ctx, NULL);
+    format(&vars, fmt, param, &sk, NULL, NULL);
+    return ctx.w;
+}
+
+/* Compiled format strings. A program is an array of instructions followed by
+ * a pool holding the literal text. %? and %; compile to nothing; %t and %e
+ * become jumps whose targets are instruction indices. */
+enum {
+    OP_LIT,
+    OP_PAD,
+    OP_PRINT,
+    OP_CHAR,
+    OP_STR,
+    OP_STRLEN,
+    OP_PARAM,
+    OP_SET_VAR,
+    OP_GET_VAR,
+    OP_CONST,
+    OP_INCR,
+    OP_JZ,
+    OP_JMP,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_AND, OP_OR, OP_XOR,
+    OP_EQ, OP_LT, OP_GT,
+    OP_LAND, OP_LOR,
+    OP_NOT, OP_COMPL
+};
+
+struct insn {
+    unsigned char op;
+    unsigned char arg;       /* OP_PARAM, OP_*_VAR: index (see var_get()); OP_PAD: scale | force << 1 */
+    char gen[SPEC_GEN_SIZE]; /* OP_PRINT: format for dput() */
+    struct out_spec spec;    /* OP_PRINT */
+    int val;                 /* OP_CONST */
+    size_t off, len;         /* OP_LIT: text in the pool; OP_PAD: delay in len; OP_JZ, OP_JMP: target in off */
+};
+
+struct unibi_prog {
+    size_t ncode;
+    struct insn code[];
+};
+
+#define PROG_POOL(P) ((const char *)((P)->code + (P)->ncode))
+
+struct compiler {
+    struct insn *code;
+    size_t ncode;
+    char *pool;
+    size_t pool_used;
+    int merge;
+};
+
+static struct insn *emit(struct compiler *cc, unsigned char op) {
+    struct insn *c = &cc->code[cc->ncode++];
+    memset(c, 0, sizeof *c);
+    c->op = op;
+    cc->merge = 0;
+    return c;
+}
+
+/* adjacent literal text is merged into one instruction unless a jump may land
+ * between the pieces */
+static void emit_lit(struct compiler *cc, const char *p, size_t n) {
+    if (!cc->merge) {
+        emit(cc, OP_LIT)->off = cc->pool_used;
+        cc->merge = 1;
+    }
+    memcpy(cc->pool + cc->pool_used, p, n);
+    cc->pool_used += n;
+    cc->code[cc->ncode - 1].len += n;
+}
+
+static unibi_prog *compile(const char *fmt, size_t *at, struct compiler *cc) {
+    const char *p = fmt;
+    unibi_prog *prog;
+    size_t i;
+
+    while (*p) {
+        at[p - fmt] = cc->ncode;
+
+        if (*p != '%' && *p != '$') {
+            const size_t r = strcspn(p, "%$");
+            emit_lit(cc, p, r);
+            p += r;
+            continue;
+        }
+
+        if (*p == '$') {
+            size_t n;
+            int scale, force;
+            const char *v = parse_pad(p + 1, &n, &scale, &force);
+            if (v) {
+                struct insn *c = emit(cc, OP_PAD);
+                c->len = n;
+                c->arg = scale | force << 1;
+                p = v;
+            } else {
+                emit_lit(cc, p++, 1);
+            }
+            continue;
+        }
+
+        ++p;
+
+        {
+            struct out_spec spec;
+            const char *v = parse_spec(p, &spec);
+            if (v) {
+                if (spec.conv) {
+                    struct insn *c = emit(cc, OP_PRINT);
+                    c->spec = spec;
+                    spec_gen(c->gen, &spec);
+                    p = v;
+                } else {
+                    emit_lit(cc, p - 1, 2);
+                }
+                ++p;
+                continue;
+            }
+        }
+
+        switch (*p++) {
+            default:
+                emit_lit(cc, p - 2, 2);
+                break;
+
+            case '\0':
+                --p;
+                emit_lit(cc, "%", 1);
+                break;
+
+            case '%':
+                emit_lit(cc, "%", 1);
+                break;
+
+            case 'c':
+                emit(cc, OP_CHAR);
+                break;
+
+            case 's':
+                emit(cc, OP_STR);
+                break;
+
+            case 'p':
+                if (*p >= '1' && *p <= '9') {
+                    emit(cc, OP_PARAM)->arg = *p++ - '1';
+                } else {
+                    emit_lit(cc, p - 2, 2);
+                }
+                break;
+
+            case 'P':
+                if (*p >= 'a' && *p <= 'z') {
+                    emit(cc, OP_SET_VAR)->arg = *p++ - 'a';
+                } else if (*p >= 'A' && *p <= 'Z') {
+                    emit(cc, OP_SET_VAR)->arg = 26 + *p++ - 'A';
+                } else {
+                    emit_lit(cc, p - 2, 2);
+                }
+                break;
+
+            case 'g':
+                if (*p >= 'a' && *p <= 'z') {
+                    emit(cc, OP_GET_VAR)->arg = *p++ - 'a';
+                } else if (*p >= 'A' && *p <= 'Z') {
+                    emit(cc, OP_GET_VAR)->arg = 26 + *p++ - 'A';
+                } else {
+                    emit_lit(cc, p - 2, 2);
+                }
+                break;
+
+            case '\'':
+                if (*p && p[1] == '\'') {
+                    emit(cc, OP_CONST)->val = (unsigned char)*p;
+                    p += 2;
+                } else {
+                    emit_lit(cc, p - 2, 2);
+                }
+                break;
+
+            case '{': {
+                size_t r = strspn(p, "0123456789");
+                if (r && p[r] == '}') {
+                    emit(cc, OP_CONST)->val = atoi(p);
+                    p += r + 1;
+                } else {
+                    emit_lit(cc, p - 2, 2);
+                }
+                break;
+            }
+
+            case 'l':
+                emit(cc, OP_STRLEN);
+                break;
+
+            case 'i':
+                emit(cc, OP_INCR);
+                break;
+
+            case '?':
+            case ';':
+                cc->merge = 0;
+                break;
+
+            case 't':
+                emit(cc, OP_JZ)->off = skip_branch(p, 1) - fmt;
+                break;
+
+            case 'e':
+                emit(cc, OP_JMP)->off = skip_branch(p, 0) - fmt;
+                break;
+
+            case '+': emit(cc, OP_ADD); break;
+            case '-': emit(cc, OP_SUB); break;
+            case '*': emit(cc, OP_MUL); break;
+            case '/': emit(cc, OP_DIV); break;
+            case 'm': emit(cc, OP_MOD); break;
+            case '&': emit(cc, OP_AND); break;
+            case '|': emit(cc, OP_OR); break;
+            case '^': emit(cc, OP_XOR); break;
+            case '=': emit(cc, OP_EQ); break;
+            case '<': emit(cc, OP_LT); break;
+            case '>': emit(cc, OP_GT); break;
+            case 'A': emit(cc, OP_LAND); break;
+            case 'O': emit(cc, OP_LOR); break;
+            case '!': emit(cc, OP_NOT); break;
+            case '~': emit(cc, OP_COMPL); break;
+        }
+    }
+    at[p - fmt] = cc->ncode;
+
+    /* A branch is skipped by scanning the source text, like unibi_format()
+     * does, and always ends up right after a %e or %; (or at the end), which
+     * is where an instruction starts. */
+    for (i = 0; i < cc->ncode; i++) {
+        struct insn *c = &cc->code[i];
+        if (c->op == OP_JZ || c->op == OP_JMP) {
+            c->off = at[c->off];
+        }
+    }
+
+    if (!(prog = malloc(sizeof *prog + cc->ncode * sizeof *prog->code + cc->pool_used))) {
+        return NULL;
+    }
+    prog->ncode = cc->ncode;
+    if (cc->ncode) {
+        memcpy(prog->code, cc->code, cc->ncode * sizeof *prog->code);
+    }
+    if (cc->pool_used) {
+        memcpy((char *)PROG_POOL(prog), cc->pool, cc->pool_used);
+    }
+    return prog;
+}
+
+unibi_prog *unibi_compile(const char *fmt) {
+    const size_t len = strlen(fmt);
+    struct compiler cc;
+    unibi_prog *prog;
+    size_t *at;
+
+    /* every piece of the source yields at most one instruction and no more
+     * literal text than its own length */
+    cc.code = malloc((len + 1) * sizeof *cc.code);
+    cc.pool = malloc(len + 1);
+    at = malloc((len + 1) * sizeof *at);
+    if (!cc.code || !cc.pool || !at) {
+        prog = NULL;
+    } else {
+        cc.ncode = 0;
+        cc.pool_used = 0;
+        cc.merge = 0;
+        prog = compile(fmt, at, &cc);
+    }
+
+    free(at);
+    free(cc.pool);
+    free(cc.code);
+    return prog;
+}
+
+void unibi_prog_destroy(unibi_prog *prog) {
+    free(prog);
+}
+
+static void exec(
+    const unibi_prog *prog,
+    struct fmt_vars *vars,
+    unibi_var_t param[9],
+    struct sink *sk,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    const char *const pool = PROG_POOL(prog);
+    const unibi_var_t zero = {0};
+    unibi_var_t stack[123];
+    size_t sp = 0, pc = 0;
+
+#define POP() (sp ? stack[--sp] : zero)
+#define PUSH(X) do { if (sp < COUNTOF(stack)) { stack[sp++] = (X); } } while (0)
+#define PUSHi(N) do { unibi_var_t tmp_ = unibi_var_from_num(N); PUSH(tmp_); } while (0)
+
+    while (pc < prog->ncode) {
+        const struct insn *const c = &prog->code[pc++];
+        switch (c->op) {
+            case OP_LIT:
+                sink_ref(sk, pool + c->off, c->len);
+                break;
+
+            case OP_PAD:
+                if (pad) {
+                    pad(ctx2, c->len, c->arg & 1, c->arg >> 1);
+                }
+                break;
+
+            case OP_PRINT:
+                dput(&c->spec, c->gen, POP(), sk);
+                break;
+
+            case OP_CHAR: {
+                unsigned char ch;
+                ch = unibi_num_from_var(POP());
+                sink_put(sk, (const char *)&ch, 1);
+                break;
+            }
+
+            case OP_STR: {
+                const char *s;
+                s = unibi_str_from_var(POP());
+                sink_ref(sk, s, strlen(s));
+                break;
+            }
+
+            case OP_STRLEN:
+                PUSHi(strlen(unibi_str_from_var(POP())));
+                break;
+
+            case OP_PARAM:
+                PUSH(param[c->arg]);
+                break;
+
+            case OP_SET_VAR:
+                var_set(vars, c->arg, POP());
+                break;
+
+            case OP_GET_VAR:
+                PUSH(var_get(vars, c->arg));
+                break;
+
+            case OP_CONST:
+                PUSHi(c->val);
+                break;
+
+            case OP_INCR:
+                param[0] = unibi_var_from_num(unibi_num_from_var(param[0]) + 1);
+                param[1] = unibi_var_from_num(unibi_num_from_var(param[1]) + 1);
+                break;
+
+            case OP_JZ:
+                if (!unibi_num_from_var(POP())) {
+                    pc = c->off;
+                }
+                break;
+
+            case OP_JMP:
+                pc = c->off;
+                break;
+
+#define ARITH2(C, E) \
+    case (C): { \
+        int x, y; \
+        y = unibi_num_from_var(POP()); \
+        x = unibi_num_from_var(POP()); \
+        PUSHi(E); \
+    } break
+
+            ARITH2(OP_ADD, x + y);
+            ARITH2(OP_SUB, x - y);
+            ARITH2(OP_MUL, x * y);
+            ARITH2(OP_DIV, y ? x / y : 0);
+            ARITH2(OP_MOD, y ? x % y : 0);
+            ARITH2(OP_AND, x & y);
+            ARITH2(OP_OR, x | y);
+            ARITH2(OP_XOR, x ^ y);
+            ARITH2(OP_EQ, x == y);
+            ARITH2(OP_LT, x < y);
+            ARITH2(OP_GT, x > y);
+            ARITH2(OP_LAND, x && y);
+            ARITH2(OP_LOR, x || y);
+
+#undef ARITH2
+
+            case OP_NOT:
+                PUSHi(!unibi_num_from_var(POP()));
+                break;
+
+            case OP_COMPL:
+                PUSHi(~unibi_num_from_var(POP()));
+                break;
+        }
+    }
+
+#undef PUSHi
+#undef PUSH
+#undef POP
+}
+
+void unibi_exec(
+    const unibi_prog *prog,
+    unibi_var_t var_dyn[26],
+    unibi_var_t var_static[26],
+    unibi_var_t param[9],
+    void (*out)(void *, const char *, size_t),
+    void *ctx1,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    struct fmt_vars vars;
+    struct sink sk;
+    vars_init(&vars, var_dyn, var_static, VARS_NONE);
+    sink_init(&sk, out, ctx1, NULL);
+    exec(prog, &vars, param, &sk, pad, ctx2);
+}
+
+size_t unibi_run_prog(const unibi_prog *prog, unibi_var_t param[9], char *p, size_t n) {
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+    run_ctx_t ctx;
+
+    ctx.p = p;
+    ctx.n = n;
+    ctx.w = 0;
+
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, out, &ctx, NULL);
+    exec(prog, &vars, param, &sk, NULL, NULL);
+    return ctx.w;
+}
+
+/* A terminal can keep the programs compiled from its string capabilities,
+ * so the branch targets of a capability are worked out only once. They are
+ * built by unibi_compile_strs() and kept current by unibi_set_str(), never
+ * behind a const pointer. A view without programs of its own uses those of
+ * the entry that supplies the string. */
+int unibi_compile_strs(unibi_term *t) {
+    size_t i;
+    int r = 0;
+
+    if (!t->progs) {
+        if (!(t->progs = malloc(COUNTOF(t->strs) * sizeof *t->progs))) {
+            return -1;
+        }
+        for (i = 0; i < COUNTOF(t->strs); i++) {
+            t->progs[i] = NULL;
+        }
+    }
+    for (i = 0; i < COUNTOF(t->strs); i++) {
+        const char *const s = unibi_get_str(t, unibi_string_begin_ + 1 + i);
+        if (s && !t->progs[i] && !(t->progs[i] = unibi_compile(s))) {
+            r = -1;
+        }
+    }
+    return r;
+}
+
+const unibi_prog *unibi_get_str_prog(const unibi_term *t, enum unibi_string v) {
+    ASSERT_RETURN(v > unibi_string_begin_ && v < unibi_string_end_, NULL);
+    if (t->progs) {
+        return t->progs[v - unibi_string_begin_ - 1];
+    }
+    if (t->ov) {
+        return unibi_get_str_prog(unibi_get_str(t->ov->delta, v) ? t->ov->delta : t->ov->base, v);
+    }
+    return NULL;
+}
+
+/* How often prog applies %i if its output depends only on the numeric values
+ * of the parameters, MEMO_NO otherwise. Increments under a conditional can't
+ * be replayed, so they rule out caching too. */
+static int memo_incr(const unibi_prog *prog) {
+    size_t i;
+    int incr = 0, jumps = 0;
+
+    for (i = 0; i < prog->ncode; i++) {
+        switch (prog->code[i].op) {
+            case OP_PRINT:
+                if (prog->code[i].spec.conv == 's') {
+                    return MEMO_NO;
+                }
+                break;
+
+            case OP_STR:
+            case OP_STRLEN:
+            case OP_SET_VAR:
+            case OP_GET_VAR:
+                return MEMO_NO;
+
+            case OP_INCR:
+                if (++incr > 100) {
+                    return MEMO_NO;
+                }
+                break;
+
+            case OP_JZ:
+            case OP_JMP:
+                jumps = 1;
+                break;
+
+            default:
+                break;
+        }
+    }
+    return incr && jumps ? MEMO_NO : incr;
+}
+
+static size_t memo_hash(size_t cap, const int key[9]) {
+    uint32_t h = 2166136261u ^ (uint32_t)cap;
+    size_t i;
+    for (i = 0; i < 9; i++) {
+        h = (h ^ (uint32_t)key[i]) * 16777619u;
+    }
+    /* the multiplications only carry upwards; fold the top bits back down */
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
+}
+
+static void memo_unlink(struct memo *m, size_t e) {
+    struct memo_entry *const x = &m->ent[e];
+    if (x->prev != MEMO_NIL) {
+        m->ent[x->prev].next = x->next;
+    } else {
+        m->head = x->next;
+    }
+    if (x->next != MEMO_NIL) {
+        m->ent[x->next].prev = x->prev;
+    } else {
+        m->tail = x->prev;
+    }
+}
+
+static void memo_push(struct memo *m, size_t e) {
+    m->ent[e].prev = MEMO_NIL;
+    m->ent[e].next = m->head;
+    if (m->head != MEMO_NIL) {
+        m->ent[m->head].prev = e;
+    } else {
+        m->tail = e;
+    }
+    m->head = e;
+}
+
+static void memo_store(struct memo *m, size_t h, size_t cap, const int key[9], const char *out, size_t len) {
+    struct memo_entry *x;
+    size_t e;
+
+    if (m->used < m->size) {
+        e = m->used++;
+    } else {
+        size_t *link;
+        e = m->tail;
+        memo_unlink(m, e);
+        link = &m->bucket[memo_hash(m->ent[e].cap, m->ent[e].key) & m->mask];
+        while (*link != e) {
+            link = &m->ent[*link].chain;
+        }
+        *link = m->ent[e].chain;
+    }
+
+    x = &m->ent[e];
+    x->cap = cap;
+    x->len = len;
+    memcpy(x->key, key, sizeof x->key);
+    memcpy(x->out, out, len);
+    x->chain = m->bucket[h];
+    m->bucket[h] = e;
+    memo_push(m, e);
+}
+
+/* Look up the output of capability cap for param. Returns NULL if cap can't
+ * be cached, and otherwise fills in key and h for memo_store(). On a hit the
+ * entry becomes the most recently used one and the %i increments are applied
+ * to param; on a miss the result is &memo_miss. */
+static const struct memo_entry memo_miss;
+
+static const struct memo_entry *memo_find(struct memo *m, size_t cap, unibi_var_t param[9], int key[9], size_t *h) {
+    const int incr = m->incr[cap];
+    size_t e;
+
+    if (incr == MEMO_NO) {
+        return NULL;
+    }
+
+    for (e = 0; e < 9; e++) {
+        key[e] = unibi_num_from_var(param[e]);
+    }
+    *h = memo_hash(cap, key) & m->mask;
+    for (e = m->bucket[*h]; e != MEMO_NIL; e = m->ent[e].chain) {
+        const struct memo_entry *const x = &m->ent[e];
+        if (x->cap == cap && memcmp(x->key, key, sizeof x->key) == 0) {
+            if (m->head != e) {
+                memo_unlink(m, e);
+                memo_push(m, e);
+            }
+            if (incr) {
+                param[0] = unibi_var_from_num(key[0] + incr);
+                param[1] = unibi_var_from_num(key[1] + incr);
+            }
+            return x;
+        }
+    }
+    return &memo_miss;
+}
+
+static size_t run_memo(struct memo *m, size_t cap, const unibi_prog *prog, unibi_var_t param[9], char *p, size_t n) {
+    const struct memo_entry *x;
+    int key[9];
+    size_t h, w;
+
+    if (!(x = memo_find(m, cap, param, key, &h))) {
+        return unibi_run_prog(prog, param, p, n);
+    }
+    if (x != &memo_miss) {
+        memcpy(p, x->out, xmin(x->len, n));
+        return x->len;
+    }
+
+    w = unibi_run_prog(prog, param, p, n);
+    if (w <= MEMO_OUT && w <= n) {
+        memo_store(m, h, cap, key, p, w);
+    }
+    return w;
+}
+
+size_t unibi_run_str(unibi_term *t, enum unibi_string v, unibi_var_t param[9], char *p, size_t n) {
+    unibi_var_t zero[9];
+    const unibi_prog *prog;
+    size_t len;
+    int plain;
+
+    ASSERT_RETURN(v > unibi_string_begin_ && v < unibi_string_end_, 0);
+    if ((len = str_len_plain(t, v, &plain)) == SIZE_ERR) {
+        return 0;
+    }
+    if (plain) {
+        memcpy(p, unibi_get_str(t, v), xmin(len, n));
+        return len;
+    }
+    if (!param) {
+        size_t i;
+        for (i = 0; i < COUNTOF(zero); i++) {
+            zero[i] = unibi_var_from_num(0);
+        }
+        param = zero;
+    }
+    if (!(prog = unibi_get_str_prog(t, v))) {
+        return unibi_run(unibi_get_str(t, v), param, p, n);
+    }
+    if (t->memo) {
+        return run_memo(t->memo, v - unibi_string_begin_ - 1, prog, param, p, n);
+    }
+    return unibi_run_prog(prog, param, p, n);
+}
+
+/* Static bound on the output of a program, by running it on intervals. Each
+ * value is a range of numbers, plus, if str is set, possibly a string of at
+ * most slen bytes (whose numeric value is INT_MIN). Both ways out of a %t
+ * are followed when the condition isn't known; the states meeting at a jump
+ * target are joined, keeping the larger output so far. Variables start out
+ * as 0, as they do in unibi_run(). */
+struct aval {
+    long long lo, hi;
+    int str;
+    size_t slen;
+};
+
+struct astate {
+    size_t target;   /* for states waiting at a jump target */
+    size_t out;
+    int live;
+    int lost;        /* branches left the stack at different depths */
+    size_t sp;
+    struct aval stack[123];
+    struct aval var[26 + 26];
+    struct aval param[9];
+};
+
+static struct aval aval_num(long long lo, long long hi) {
+    struct aval a;
+    if (lo < INT_MIN || hi > INT_MAX) {
+        lo = INT_MIN;
+        hi = INT_MAX;
+    }
+    a.lo = lo;
+    a.hi = hi;
+    a.str = 0;
+    a.slen = 0;
+    return a;
+}
+
+/* the range of unibi_num_from_var() */
+static void aval_range(const struct aval *a, long long *lo, long long *hi) {
+    *lo = a->str ? INT_MIN : a->lo;
+    *hi = a->hi;
+}
+
+static void aval_join(struct aval *a, const struct aval *b) {
+    if (b->lo < a->lo) { a->lo = b->lo; }
+    if (b->hi > a->hi) { a->hi = b->hi; }
+    a->str |= b->str;
+    if (b->slen > a->slen) { a->slen = b->slen; }
+}
+
+static void astate_join(struct astate *a, const struct astate *b) {
+    size_t i;
+
+    if (!b->live) {
+        return;
+    }
+    if (!a->live) {
+        *a = *b;
+        return;
+    }
+    if (b->out > a->out) {
+        a->out = b->out;
+    }
+    if (a->sp != b->sp || b->lost) {
+        a->lost = 1;
+    } else {
+        for (i = 0; i < a->sp; i++) {
+            aval_join(&a->stack[i], &b->stack[i]);
+        }
+    }
+    for (i = 0; i < COUNTOF(a->var); i++) {
+        aval_join(&a->var[i], &b->var[i]);
+    }
+    for (i = 0; i < COUNTOF(a->param); i++) {
+        aval_join(&a->param[i], &b->param[i]);
+    }
+}
 
-#define BITTY(A, B, C) (!!(A) << 0 | !!(B) << 1 | !!(C) << 2)
+static long long mmin(long long a, long long b) {
+    return a < b ? a : b;
+}
 
-    switch (BITTY(t == 's', w != -1, p != -1)) {
-        case BITTY(0, 0, 0): snprintf(buf, sizeof buf, fmt,       unibi_num_from_var(x)); break;
-        case BITTY(0, 0, 1): snprintf(buf, sizeof buf, fmt,    p, unibi_num_from_var(x)); break;
-        case BITTY(0, 1, 0): snprintf(buf, sizeof buf, fmt, w,    unibi_num_from_var(x)); break;
-        case BITTY(0, 1, 1): snprintf(buf, sizeof buf, fmt, w, p, unibi_num_from_var(x)); break;
-        case BITTY(1, 0, 0): snprintf(buf, sizeof buf, fmt,       unibi_str_from_var(x)); break;
-        case BITTY(1, 0, 1): snprintf(buf, sizeof buf, fmt,    p, unibi_str_from_var(x)); break;
-        case BITTY(1, 1, 0): snprintf(buf, sizeof buf, fmt, w,    unibi_str_from_var(x)); break;
-        case BITTY(1, 1, 1): snprintf(buf, sizeof buf, fmt, w, p, unibi_str_from_var(x)); break;
-    }
+static long long mmax(long long a, long long b) {
+    return a > b ? a : b;
+}
 
-#undef BITTY
+/* the largest magnitude in [lo, hi] */
+static long long mabs(long long lo, long long hi) {
+    return mmax(lo < 0 ? -lo : lo, hi < 0 ? -hi : hi);
+}
 
-    out(ctx, buf, strlen(buf));
+/* the smallest 2**k - 1 >= x, for x >= 0 */
+static long long ones(long long x) {
+    long long m = 0;
+    while (m < x) {
+        m = m << 1 | 1;
+    }
+    return m;
 }
 
-static long cstrtol(const char *s, const char **pp) {
-    long r;
-    char *tmp;
-    r = strtol(s, &tmp, 10);
-    *pp = tmp;
-    return r;
+static size_t digits(unsigned long long x, unsigned base) {
+    size_t n = 1;
+    while (x >= base) {
+        x /= base;
+        n++;
+    }
+    return n;
 }
 
-void unibi_format(
-    unibi_var_t var_dyn[26],
-    unibi_var_t var_static[26],
-    const char *fmt,
-    unibi_var_t param[9],
-    void (*out)(void *, const char *, size_t),
-    void *ctx1,
-    void (*pad)(void *, size_t, int, int),
-    void *ctx2
-) {
-    const unibi_var_t zero = {0};
-    unibi_var_t stack[123] = {{0}};
-    size_t sp = 0;
+/* the most dput() can output for a value in a */
+static size_t print_max(const struct out_spec *sp, const struct aval *a) {
+    long long lo, hi;
+    size_t n;
 
-#define UC(F, C) (F((unsigned char)(C)))
+    aval_range(a, &lo, &hi);
+    if (sp->conv == 's') {
+        n = a->str ? a->slen : 0;
+        if (sp->prec >= 0 && (size_t)sp->prec < n) {
+            n = sp->prec;
+        }
+    } else if (sp->conv == 'd') {
+        n = digits(mabs(lo, hi), 10);
+        if (sp->prec >= 0 && (size_t)sp->prec > n) {
+            n = sp->prec;
+        }
+        n += lo < 0 || sp->flags & (FlagSgn | FlagSpc);
+    } else {
+        const unsigned base = sp->conv == 'o' ? 8 : 16;
+        n = digits(lo < 0 ? UINT_MAX : (unsigned long long)hi, base);
+        if (sp->prec >= 0 && (size_t)sp->prec > n) {
+            n = sp->prec;
+        }
+        if (sp->flags & FlagAlt) {
+            n += base == 8 ? 1 : 2;
+        }
+    }
+    if (sp->width >= 0 && (size_t)sp->width > n) {
+        n = sp->width;
+    }
+    return xmin(n, DPUT_BUF - 1);
+}
 
-#define POP() (sp ? stack[--sp] : zero)
-#define PUSH(X) do { if (sp < COUNTOF(stack)) { stack[sp++] = (X); } } while (0)
-#define PUSHi(N) do { unibi_var_t tmp_ = unibi_var_from_num(N); PUSH(tmp_); } while (0)
+static size_t prog_max_len(const unibi_prog *prog, const unibi_param_bound bounds[9]) {
+    struct astate *st, *cur;
+    size_t njumps = 0, npending = 0, pc, i, result;
+    struct aval top, zero;
 
-    while (*fmt) {
-        {
-            size_t r = strcspn(fmt, "%$");
-            if (r) {
-                out(ctx1, fmt, r);
-                fmt += r;
-                if (!*fmt) {
-                    break;
-                }
-            }
+    /* every jump leaves at most one state pending */
+    for (pc = 0; pc < prog->ncode; pc++) {
+        njumps += prog->code[pc].op == OP_JZ || prog->code[pc].op == OP_JMP;
+    }
+    if (!(st = malloc((njumps + 1) * sizeof *st))) {
+        return SIZE_ERR;
+    }
+    cur = &st[njumps];
+
+    zero = aval_num(0, 0);
+    top = aval_num(INT_MIN, INT_MAX);
+    cur->out = 0;
+    cur->live = 1;
+    cur->lost = 0;
+    cur->sp = 0;
+    for (i = 0; i < COUNTOF(cur->var); i++) {
+        cur->var[i] = zero;
+    }
+    for (i = 0; i < COUNTOF(cur->param); i++) {
+        if (bounds) {
+            cur->param[i] = aval_num(bounds[i].min, bounds[i].max);
+            cur->param[i].str = bounds[i].max_len != 0;
+            cur->param[i].slen = bounds[i].max_len;
+        } else {
+            cur->param[i] = top;
         }
+        aval_join(&top, &cur->param[i]);
+    }
 
-        if (*fmt == '$') {
-            ++fmt;
-            if (*fmt == '<' && UC(isdigit, fmt[1])) {
-                int scale = 0, force = 0;
-                const char *v = fmt + 1;
-                size_t n = cstrtol(v, &v);
-                n *= 10;
-                if (*v == '.') {
-                    ++v;
-                }
-                if (UC(isdigit, *v)) {
-                    n += *v++ - '0';
-                }
-                if (*v == '/') {
-                    ++v;
-                    force = 1;
-                    if (*v == '*') {
-                        ++v;
-                        scale = 1;
-                    }
-                } else if (*v == '*') {
-                    ++v;
-                    scale = 1;
-                    if (*v == '/') {
-                        ++v;
-                        force = 1;
-                    }
-                }
-                if (*v == '>') {
-                    fmt = v + 1;
-                    if (pad) {
-                        pad(ctx2, n, scale, force);
-                    }
-                } else {
-                    out(ctx1, fmt - 1, 1);
-                }
+#define POP(X) do { \
+    if (cur->lost) { (X) = top; } \
+    else if (cur->sp) { (X) = cur->stack[--cur->sp]; } \
+    else { (X) = zero; } \
+} while (0)
+#define PUSH(X) do { if (!cur->lost && cur->sp < COUNTOF(cur->stack)) { cur->stack[cur->sp++] = (X); } } while (0)
+
+    for (pc = 0; pc <= prog->ncode; pc++) {
+        const struct insn *c;
+        struct aval x, y;
+        long long xl, xh, yl, yh;
+
+        for (i = 0; i < npending; ) {
+            if (st[i].target == pc) {
+                astate_join(cur, &st[i]);
+                st[i] = st[--npending];
             } else {
-                out(ctx1, fmt - 1, 1);
+                i++;
             }
+        }
+        if (pc == prog->ncode) {
+            break;
+        }
+        if (!cur->live) {
             continue;
         }
 
-        assert(*fmt == '%');
-        ++fmt;
+        c = &prog->code[pc];
+        switch (c->op) {
+            case OP_LIT:
+                cur->out += c->len;
+                break;
 
-        if (UC(isdigit, *fmt) || (*fmt && strchr(":# .doxX", *fmt))) {
-            enum {
-                FlagAlt = 1,
-                FlagSpc = 2,
-                FlagSgn = 4,
-                FlagLft = 8,
-                FlagZro = 16
-            };
-            int flags = 0, width = -1, prec = -1;
-            const char *v = fmt;
-            if (*v == ':') {
-                ++v;
-            }
-            while (1) {
-                switch (*v++) {
-                    case '#': flags |= FlagAlt; continue;
-                    case ' ': flags |= FlagSpc; continue;
-                    case '0': flags |= FlagZro; continue;
-                    case '+': flags |= FlagSgn; continue;
-                    case '-': flags |= FlagLft; continue;
-                }
-                --v;
+            case OP_PAD:
                 break;
-            }
-            if (UC(isdigit, *v)) {
-                width = cstrtol(v, &v);
-            }
-            if (*v == '.' && UC(isdigit, v[1])) {
-                ++v;
-                prec = cstrtol(v, &v);
-            }
-            if (*v && strchr("doxXs", *v)) {
-                char gen[sizeof "%# +-0*.*d"], *g = gen;
-                *g++ = '%';
-                if (flags & FlagAlt) { *g++ = '#'; }
-                if (flags & FlagSpc) { *g++ = ' '; }
-                if (flags & FlagSgn) { *g++ = '+'; }
-                if (flags & FlagLft) { *g++ = '-'; }
-                if (flags & FlagZro) { *g++ = '0'; }
-                if (width != -1) { *g++ = '*'; }
-                if (prec  != -1) { *g++ = '.'; *g++ = '*'; }
-                *g++ = *v;
-                *g = '\0';
-                dput(*v, gen, width, prec, POP(), out, ctx1);
-                fmt = v;
-            } else {
-                out(ctx1, fmt - 1, 2);
-            }
-            ++fmt;
-            continue;
-        }
 
-        switch (*fmt++) {
-            default:
-                out(ctx1, fmt - 2, 2);
+            case OP_PRINT:
+                POP(x);
+                cur->out += print_max(&c->spec, &x);
                 break;
 
-            case '\0':
-                --fmt;
-                out(ctx1, "%", 1);
+            case OP_CHAR:
+                POP(x);
+                cur->out += 1;
                 break;
 
-            case '%':
-                out(ctx1, "%", 1);
+            case OP_STR:
+                POP(x);
+                cur->out += x.str ? x.slen : 0;
                 break;
 
-            case 'c': {
-                unsigned char c;
-                c = unibi_num_from_var(POP());
-                out(ctx1, (const char *)&c, 1);
+            case OP_STRLEN:
+                POP(x);
+                PUSH(aval_num(0, x.str ? (long long)xmin(x.slen, INT_MAX) : 0));
                 break;
-            }
 
-            case 's': {
-                const char *s;
-                s = unibi_str_from_var(POP());
-                out(ctx1, s, strlen(s));
+            case OP_PARAM:
+                PUSH(cur->param[c->arg]);
                 break;
-            }
 
-            case 'p':
-                if (*fmt >= '1' && *fmt <= '9') {
-                    size_t n = *fmt++ - '1';
-                    PUSH(param[n]);
-                } else {
-                    out(ctx1, fmt - 2, 2);
-                }
+            case OP_SET_VAR:
+                POP(cur->var[c->arg]);
                 break;
 
-            case 'P':
-                if (*fmt >= 'a' && *fmt <= 'z') {
-                    var_dyn[*fmt - 'a'] = POP();
-                    fmt++;
-                } else if (*fmt >= 'A' && *fmt <= 'Z') {
-                    var_static[*fmt - 'A'] = POP();
-                    fmt++;
-                } else {
-                    out(ctx1, fmt - 2, 2);
-                }
+            case OP_GET_VAR:
+                PUSH(cur->var[c->arg]);
                 break;
 
-            case 'g':
-                if (*fmt >= 'a' && *fmt <= 'z') {
-                    PUSH(var_dyn[*fmt - 'a']);
-                    fmt++;
-                } else if (*fmt >= 'A' && *fmt <= 'Z') {
-                    PUSH(var_static[*fmt - 'A']);
-                    fmt++;
-                } else {
-                    out(ctx1, fmt - 2, 2);
-                }
+            case OP_CONST:
+                PUSH(aval_num(c->val, c->val));
                 break;
 
-            case '\'':
-                if (*fmt && fmt[1] == '\'') {
-                    PUSHi((unsigned char)*fmt);
-                    fmt += 2;
-                } else {
-                    out(ctx1, fmt - 2, 2);
+            case OP_INCR:
+                for (i = 0; i < 2; i++) {
+                    aval_range(&cur->param[i], &xl, &xh);
+                    cur->param[i] = aval_num(xl + 1, xh + 1);
                 }
                 break;
 
-            case '{': {
-                size_t r = strspn(fmt, "0123456789");
-                if (r && fmt[r] == '}') {
-                    PUSHi(atoi(fmt));
-                    fmt += r + 1;
-                } else {
-                    out(ctx1, fmt - 2, 2);
+            case OP_JZ:
+            case OP_JMP:
+                if (c->off <= pc) {
+                    /* can't happen: the compiler only jumps forward */
+                    free(st);
+                    return SIZE_ERR;
+                }
+                xl = xh = 0;
+                if (c->op == OP_JZ) {
+                    POP(x);
+                    aval_range(&x, &xl, &xh);
+                }
+                if (xl <= 0 && xh >= 0) {
+                    st[npending] = *cur;
+                    st[npending++].target = c->off;
+                    if (c->op == OP_JMP || (xl == 0 && xh == 0)) {
+                        cur->live = 0;
+                    }
                 }
                 break;
-            }
 
-            case 'l':
-                PUSHi(strlen(unibi_str_from_var(POP())));
-                break;
+#define ARITH2(C, LO, HI) \
+    case (C): \
+        POP(y); \
+        POP(x); \
+        aval_range(&y, &yl, &yh); \
+        aval_range(&x, &xl, &xh); \
+        PUSH(aval_num((LO), (HI))); \
+        break
 
-            case 'i':
-                param[0] = unibi_var_from_num(unibi_num_from_var(param[0]) + 1);
-                param[1] = unibi_var_from_num(unibi_num_from_var(param[1]) + 1);
-                break;
+            ARITH2(OP_ADD, xl + yl, xh + yh);
+            ARITH2(OP_SUB, xl - yh, xh - yl);
+            ARITH2(OP_MUL,
+                mmin(mmin(xl * yl, xl * yh), mmin(xh * yl, xh * yh)),
+                mmax(mmax(xl * yl, xl * yh), mmax(xh * yl, xh * yh)));
+            ARITH2(OP_DIV, -mabs(xl, xh), mabs(xl, xh));
+            ARITH2(OP_MOD,
+                xl < 0 ? -mmin(mabs(xl, xh), mabs(yl, yh)) : 0,
+                xh > 0 ? mmin(mabs(xl, xh), mabs(yl, yh)) : 0);
+            ARITH2(OP_AND,
+                xl < 0 && yl < 0 ? INT_MIN : 0,
+                xl < 0 && yl < 0 ? INT_MAX : xl < 0 ? yh : yl < 0 ? xh : mmin(xh, yh));
+            ARITH2(OP_OR,
+                xl < 0 || yl < 0 ? INT_MIN : 0,
+                xl < 0 || yl < 0 ? INT_MAX : ones(mmax(xh, yh)));
+            ARITH2(OP_XOR,
+                xl < 0 || yl < 0 ? INT_MIN : 0,
+                xl < 0 || yl < 0 ? INT_MAX : ones(mmax(xh, yh)));
+            ARITH2(OP_EQ, 0, 1);
+            ARITH2(OP_LT, 0, 1);
+            ARITH2(OP_GT, 0, 1);
+            ARITH2(OP_LAND, 0, 1);
+            ARITH2(OP_LOR, 0, 1);
 
-            case '?':
-                break;
+#undef ARITH2
 
-            case 't': {
-                int c = unibi_num_from_var(POP());
-                if (!c) {
-                    size_t nesting = 0;
-                    for (; *fmt; ++fmt) {
-                        if (*fmt == '%') {
-                            ++fmt;
-                            if (*fmt == '?') {
-                                ++nesting;
-                            } else if (*fmt == ';') {
-                                if (!nesting) {
-                                    ++fmt;
-                                    break;
-                                }
-                                --nesting;
-                            } else if (*fmt == 'e' && !nesting) {
-                                ++fmt;
-                                break;
-                            } else if (!*fmt) {
-                                break;
-                            }
-                        }
-                    }
-                }
+            case OP_NOT:
+                POP(x);
+                PUSH(aval_num(0, 1));
                 break;
-            }
 
-            case 'e': {
-                size_t nesting = 0;
-                for (; *fmt; ++fmt) {
-                    if (*fmt == '%') {
-                        ++fmt;
-                        if (*fmt == '?') {
-                            ++nesting;
-                        } else if (*fmt == ';') {
-                            if (!nesting) {
-                                ++fmt;
-                                break;
-                            }
-                            --nesting;
-                        } else if (!*fmt) {
-                            break;
-                        }
-                    }
-                }
+            case OP_COMPL:
+                POP(x);
+                aval_range(&x, &xl, &xh);
+                PUSH(aval_num(~xh, ~xl));
                 break;
-            }
+        }
+    }
 
-            case ';':
-                break;
+#undef PUSH
+#undef POP
 
-#define ARITH2(C, O) \
-    case (C): { \
-        unibi_var_t x, y; \
-        y = POP(); \
-        x = POP(); \
-        PUSHi(unibi_num_from_var(x) O unibi_num_from_var(y)); \
-    } break
+    result = cur->live ? cur->out : 0;
+    free(st);
+    return result;
+}
 
-            ARITH2('+', +);
-            ARITH2('-', -);
-            ARITH2('*', *);
-            ARITH2('/', /);
-            ARITH2('m', %);
-            ARITH2('&', &);
-            ARITH2('|', |);
-            ARITH2('^', ^);
-            ARITH2('=', ==);
-            ARITH2('<', <);
-            ARITH2('>', >);
-            ARITH2('A', &&);
-            ARITH2('O', ||);
+size_t unibi_max_output_len(const char *fmt, const unibi_param_bound bounds[9]) {
+    unibi_prog *prog;
+    size_t n;
 
-#undef ARITH2
+    if (!(prog = unibi_compile(fmt))) {
+        return SIZE_ERR;
+    }
+    n = prog_max_len(prog, bounds);
+    unibi_prog_destroy(prog);
+    return n;
+}
 
-#define ARITH1(C, O) \
-    case (C): \
-        PUSHi(O unibi_num_from_var(POP())); \
-        break
+/* The static variables live on from call to call; the dynamic ones are
+ * reset lazily by vars_init(). */
+struct unibi_fmt_ctx {
+    unibi_var_t vars[26 + 26];
+};
 
-            ARITH1('!', !);
-            ARITH1('~', ~);
+unibi_fmt_ctx *unibi_fmt_ctx_create(void) {
+    unibi_fmt_ctx *fc;
+    size_t i;
 
-#undef ARITH1
-        }
+    if (!(fc = malloc(sizeof *fc))) {
+        return NULL;
+    }
+    for (i = 26; i < COUNTOF(fc->vars); i++) {
+        fc->vars[i] = unibi_var_from_num(0);
     }
+    return fc;
+}
 
-#undef PUSHi
-#undef PUSH
-#undef POP
+void unibi_fmt_ctx_destroy(unibi_fmt_ctx *fc) {
+    free(fc);
+}
+
+void unibi_fmt_ctx_format(
+    unibi_fmt_ctx *fc,
+    const char *fmt,
+    unibi_var_t param[9],
+    void (*out)(void *, const char *, size_t),
+    void *ctx1,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    struct fmt_vars vars;
+    struct sink sk;
+    vars_init(&vars, fc->vars, fc->vars + 26, VARS_DYN);
+    sink_init(&sk, out, ctx1, NULL);
+    format(&vars, fmt, param, &sk, pad, ctx2);
+}
 
-#undef UC
+void unibi_fmt_ctx_exec(
+    unibi_fmt_ctx *fc,
+    const unibi_prog *prog,
+    unibi_var_t param[9],
+    void (*out)(void *, const char *, size_t),
+    void *ctx1,
+    void (*pad)(void *, size_t, int, int),
+    void *ctx2
+) {
+    struct fmt_vars vars;
+    struct sink sk;
+    vars_init(&vars, fc->vars, fc->vars + 26, VARS_DYN);
+    sink_init(&sk, out, ctx1, NULL);
+    exec(prog, &vars, param, &sk, pad, ctx2);
 }
 
-typedef struct {
-    char *p;
-    size_t n, w;
-} run_ctx_t;
+void unibi_buf_init(unibi_buf *b) {
+    b->data = NULL;
+    b->len = b->size = 0;
+}
 
-static size_t xmin(size_t a, size_t b) {
-    return a < b ? a : b;
+void unibi_buf_free(unibi_buf *b) {
+    free(b->data);
+    unibi_buf_init(b);
 }
 
-static void out(void *vctx, const char *p, size_t n) {
-    run_ctx_t *ctx = vctx;
-    size_t k = xmin(n, ctx->n);
-    ctx->w += n;
-    memcpy(ctx->p, p, k);
-    ctx->p += k;
-    ctx->n -= k;
+/* finish a call that appended to b, which held len bytes before */
+static int buf_done(const struct sink *sk, unibi_buf *b, size_t len) {
+    if (sk->failed) {
+        b->len = len;
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
 }
 
-size_t unibi_run(const char *fmt, unibi_var_t param[9], char *p, size_t n) {
-    unibi_var_t vars[26 + 26] = {{0}};
-    run_ctx_t ctx;
+int unibi_format_buf(unibi_buf *b, const char *fmt, unibi_var_t param[9]) {
+    const size_t len = b->len;
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
 
-    ctx.p = p;
-    ctx.n = n;
-    ctx.w = 0;
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, NULL, NULL, b);
+    format(&vars, fmt, param, &sk, NULL, NULL);
+    return buf_done(&sk, b, len);
+}
 
-    unibi_format(vars, vars + 26, fmt, param, out, &ctx, NULL, NULL);
-    return ctx.w;
+int unibi_exec_buf(unibi_buf *b, const unibi_prog *prog, unibi_var_t param[9]) {
+    const size_t len = b->len;
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, NULL, NULL, b);
+    exec(prog, &vars, param, &sk, NULL, NULL);
+    return buf_done(&sk, b, len);
+}
+
+int unibi_format_batch(unibi_term *t, const unibi_batch_op *ops, size_t n, unibi_buf *b) {
+    const size_t len = b->len;
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+    size_t i;
+
+    sink_init(&sk, NULL, NULL, b);
+    for (i = 0; i < n && !sk.failed; i++) {
+        const unibi_batch_op *const op = &ops[i];
+        const unibi_prog *prog;
+        unibi_var_t param[9];
+        size_t k;
+        int plain;
+
+        if (op->text) {
+            sink_put(&sk, op->text, op->len);
+            continue;
+        }
+        assert(op->cap > unibi_string_begin_ && op->cap < unibi_string_end_);
+        if (!(op->cap > unibi_string_begin_ && op->cap < unibi_string_end_)) {
+            b->len = len;
+            errno = EINVAL;
+            return -1;
+        }
+        if ((k = str_len_plain(t, op->cap, &plain)) == SIZE_ERR) {
+            continue;
+        }
+        if (plain) {
+            sink_put(&sk, unibi_get_str(t, op->cap), k);
+            continue;
+        }
+        memcpy(param, op->param, sizeof param);
+        vars_init(&vars, storage, storage + 26, VARS_ALL);
+        if (!(prog = unibi_get_str_prog(t, op->cap))) {
+            format(&vars, unibi_get_str(t, op->cap), param, &sk, NULL, NULL);
+            continue;
+        }
+        if (t->memo) {
+            const size_t cap = op->cap - unibi_string_begin_ - 1;
+            const struct memo_entry *x;
+            int key[9];
+            size_t h;
+
+            if ((x = memo_find(t->memo, cap, param, key, &h))) {
+                if (x != &memo_miss) {
+                    sink_put(&sk, x->out, x->len);
+                } else {
+                    const size_t start = b->len;
+                    exec(prog, &vars, param, &sk, NULL, NULL);
+                    if (!sk.failed && b->len - start <= MEMO_OUT) {
+                        memo_store(t->memo, h, cap, key, b->data + start, b->len - start);
+                    }
+                }
+                continue;
+            }
+        }
+        exec(prog, &vars, param, &sk, NULL, NULL);
+    }
+    return buf_done(&sk, b, len);
+}
+
+/* finish a call that appended to v, which held iovcnt entries and
+ * scratch_used bytes before */
+static int iov_done(const struct sink *sk, unibi_iovbuf *v, size_t iovcnt, size_t scratch_used) {
+    if (sk->failed) {
+        v->iovcnt = iovcnt;
+        v->scratch_used = scratch_used;
+        errno = ENOBUFS;
+        return -1;
+    }
+    return 0;
+}
+
+int unibi_format_iov(unibi_iovbuf *v, const char *fmt, unibi_var_t param[9]) {
+    const size_t iovcnt = v->iovcnt, scratch_used = v->scratch_used;
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, NULL, NULL, NULL);
+    sk.iov = v;
+    format(&vars, fmt, param, &sk, NULL, NULL);
+    return iov_done(&sk, v, iovcnt, scratch_used);
+}
+
+int unibi_exec_iov(unibi_iovbuf *v, const unibi_prog *prog, unibi_var_t param[9]) {
+    const size_t iovcnt = v->iovcnt, scratch_used = v->scratch_used;
+    unibi_var_t storage[26 + 26];
+    struct fmt_vars vars;
+    struct sink sk;
+
+    vars_init(&vars, storage, storage + 26, VARS_ALL);
+    sink_init(&sk, NULL, NULL, NULL);
+    sk.iov = v;
+    exec(prog, &vars, param, &sk, NULL, NULL);
+    return iov_done(&sk, v, iovcnt, scratch_used);
 }
@@ -23,6 +23,7 @@ along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdio.h>
+#include <stdint.h>
 
 enum unibi_boolean {
     unibi_boolean_begin_,
@@ -543,6 +544,17 @@ unibi_term *unibi_from_mem(const char *, size_t);
 void unibi_destroy(unibi_term *);
 
 size_t unibi_dump(const unibi_term *, char *, size_t);
+size_t unibi_dump_compact(const unibi_term *, char *, size_t);
+size_t unibi_dump_to(const unibi_term *, int (*)(void *, const char *, size_t), void *);
+size_t unibi_dump_fd(const unibi_term *, int);
+
+size_t      unibi_dump_image(const unibi_term *, char *, size_t);
+unibi_term *unibi_from_image(const char *, size_t);
+
+unibi_term *unibi_overlay(const unibi_term *, const unibi_term *);
+
+uint64_t unibi_hash(const unibi_term *);
+int      unibi_equal(const unibi_term *, const unibi_term *);
 
 const char *unibi_get_name(const unibi_term *);
 void        unibi_set_name(unibi_term *, const char *);
@@ -557,6 +569,7 @@ int  unibi_get_num(const unibi_term *, enum unibi_numeric);
 void unibi_set_num(unibi_term *, enum unibi_numeric, int);
 
 const char *unibi_get_str(const unibi_term *, enum unibi_string);
+size_t      unibi_get_str_len(const unibi_term *, enum unibi_string);
 void        unibi_set_str(unibi_term *, enum unibi_string, const char *);
 
 unibi_term *unibi_from_fp(FILE *);
@@ -565,6 +578,23 @@ unibi_term *unibi_from_file(const char *);
 unibi_term *unibi_from_term(const char *);
 unibi_term *unibi_from_env(void);
 
+unibi_term *unibi_from_builtin(const char *);
+size_t      unibi_count_builtin(void);
+const char *unibi_builtin_name(size_t);
+
+int unibi_install(const char *, const unibi_term *);
+
+unibi_term *unibi_from_source(const char *, size_t, const unibi_term *(*)(void *, const char *), void *);
+size_t      unibi_to_source(const unibi_term *, int (*)(void *, const char *, size_t), void *);
+size_t      unibi_escape_str(const char *, int (*)(void *, const char *, size_t), void *);
+
+typedef struct unibi_termcap unibi_termcap;
+
+unibi_termcap *unibi_termcap_from_mem(const char *, size_t);
+unibi_termcap *unibi_termcap_from_file(const char *);
+void           unibi_termcap_destroy(unibi_termcap *);
+unibi_term    *unibi_termcap_get(const unibi_termcap *, const char *);
+
 extern const char *const unibi_terminfo_dirs;
 
 const char *unibi_name_bool(enum unibi_boolean);
@@ -573,6 +603,18 @@ const char *unibi_name_num(enum unibi_numeric);
 const char *unibi_short_name_num(enum unibi_numeric);
 const char *unibi_name_str(enum unibi_string);
 const char *unibi_short_name_str(enum unibi_string);
+const char *unibi_termcap_name_bool(enum unibi_boolean);
+const char *unibi_termcap_name_num(enum unibi_numeric);
+const char *unibi_termcap_name_str(enum unibi_string);
+
+enum unibi_param_type {
+    unibi_param_none,
+    unibi_param_num,
+    unibi_param_str
+};
+
+size_t                unibi_count_params_str(enum unibi_string);
+enum unibi_param_type unibi_param_type_str(enum unibi_string, size_t);
 
 
 size_t unibi_count_ext_bool(const unibi_term *);
@@ -603,6 +645,42 @@ void unibi_del_ext_bool(unibi_term *, size_t);
 void unibi_del_ext_num(unibi_term *, size_t);
 void unibi_del_ext_str(unibi_term *, size_t);
 
+enum unibi_cap_type {
+    unibi_cap_bool,
+    unibi_cap_num,
+    unibi_cap_str
+};
+
+int unibi_find_cap(const char *, enum unibi_cap_type *);
+int unibi_find_termcap(const char *, enum unibi_cap_type);
+
+size_t unibi_filter_ext(unibi_term *, int (*)(void *, enum unibi_cap_type, size_t, const char *), void *);
+void   unibi_shrink_ext(unibi_term *);
+
+enum unibi_diff_op {
+    unibi_diff_added,
+    unibi_diff_removed,
+    unibi_diff_changed
+};
+
+int unibi_diff(
+    const unibi_term *,
+    const unibi_term *,
+    void (*)(void *, enum unibi_diff_op, enum unibi_cap_type, int, size_t, size_t),
+    void *
+);
+
+typedef struct unibi_ext_builder unibi_ext_builder;
+
+unibi_ext_builder *unibi_ext_builder_create(void);
+void               unibi_ext_builder_destroy(unibi_ext_builder *);
+
+int unibi_ext_builder_add_bool(unibi_ext_builder *, const char *, int);
+int unibi_ext_builder_add_num(unibi_ext_builder *, const char *, int);
+int unibi_ext_builder_add_str(unibi_ext_builder *, const char *, const char *);
+
+int unibi_ext_builder_commit(unibi_ext_builder *, unibi_term *);
+
 
 typedef struct {
     int i_;
@@ -626,5 +704,93 @@ void unibi_format(
 );
 
 size_t unibi_run(const char *, unibi_var_t [9], char *, size_t);
+size_t unibi_run_str(unibi_term *, enum unibi_string, unibi_var_t [9], char *, size_t);
+int    unibi_set_memo_size(unibi_term *, size_t);
+size_t unibi_tgoto(const char *, int, int, char *, size_t);
+
+typedef struct unibi_prog unibi_prog;
+
+unibi_prog *unibi_compile(const char *);
+void        unibi_prog_destroy(unibi_prog *);
+
+void unibi_exec(
+    const unibi_prog *,
+    unibi_var_t [26],
+    unibi_var_t [26],
+    unibi_var_t [9],
+    void (*)(void *, const char *, size_t),
+    void *,
+    void (*)(void *, size_t, int, int),
+    void *
+);
+
+size_t unibi_run_prog(const unibi_prog *, unibi_var_t [9], char *, size_t);
+
+int               unibi_compile_strs(unibi_term *);
+const unibi_prog *unibi_get_str_prog(const unibi_term *, enum unibi_string);
+
+typedef struct {
+    int min, max;
+    size_t max_len;
+} unibi_param_bound;
+
+size_t unibi_max_output_len(const char *, const unibi_param_bound [9]);
+
+typedef struct {
+    char *data;
+    size_t len, size;
+} unibi_buf;
+
+void unibi_buf_init(unibi_buf *);
+void unibi_buf_free(unibi_buf *);
+
+int unibi_format_buf(unibi_buf *, const char *, unibi_var_t [9]);
+int unibi_exec_buf(unibi_buf *, const unibi_prog *, unibi_var_t [9]);
+
+typedef struct {
+    enum unibi_string cap;
+    unibi_var_t param[9];
+    const char *text;
+    size_t len;
+} unibi_batch_op;
+
+int unibi_format_batch(unibi_term *, const unibi_batch_op *, size_t, unibi_buf *);
+
+struct iovec;
+
+typedef struct {
+    struct iovec *iov;
+    size_t iovcnt, iovmax;
+    char *scratch;
+    size_t scratch_used, scratch_size;
+} unibi_iovbuf;
+
+int unibi_format_iov(unibi_iovbuf *, const char *, unibi_var_t [9]);
+int unibi_exec_iov(unibi_iovbuf *, const unibi_prog *, unibi_var_t [9]);
+
+typedef struct unibi_fmt_ctx unibi_fmt_ctx;
+
+unibi_fmt_ctx *unibi_fmt_ctx_create(void);
+void           unibi_fmt_ctx_destroy(unibi_fmt_ctx *);
+
+void unibi_fmt_ctx_format(
+    unibi_fmt_ctx *,
+    const char *,
+    unibi_var_t [9],
+    void (*)(void *, const char *, size_t),
+    void *,
+    void (*)(void *, size_t, int, int),
+    void *
+);
+
+void unibi_fmt_ctx_exec(
+    unibi_fmt_ctx *,
+    const unibi_prog *,
+    unibi_var_t [9],
+    void (*)(void *, const char *, size_t),
+    void *,
+    void (*)(void *, size_t, int, int),
+    void *
+);
 
 #endif /* GUARD_UNIBILIUM_H_ */
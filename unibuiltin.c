@@ -0,0 +1,139 @@
+/*
+
+This file is part of unibilium.
+
+Unibilium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Unibilium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "unibilium.h"
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define COUNTOF(a) (sizeof (a) / sizeof *(a))
+
+/* The built-in database is plain C data generated by tools/gen-builtin.
+ * unibi_from_builtin() points the new terminal object at it with the public
+ * setters, which store pointers, so no capability string is copied. */
+
+struct builtin_num {
+    enum unibi_numeric cap;
+    int value;
+};
+
+struct builtin_str {
+    enum unibi_string cap;
+    const char *value;
+};
+
+struct builtin_ext_num {
+    const char *name;
+    int value;
+};
+
+struct builtin_ext_str {
+    const char *name;
+    const char *value;
+};
+
+struct builtin_entry {
+    const char *name;
+    const char **aliases;
+    const enum unibi_boolean *bools;
+    size_t nbools;
+    const struct builtin_num *nums;
+    size_t nnums;
+    const struct builtin_str *strs;
+    size_t nstrs;
+    const struct builtin_ext_num *ext_bools;
+    size_t next_bools;
+    const struct builtin_ext_num *ext_nums;
+    size_t next_nums;
+    const struct builtin_ext_str *ext_strs;
+    size_t next_strs;
+};
+
+struct builtin_name {
+    const char *name;
+    size_t entry;
+};
+
+#include "unibuiltin-data.c.inc"
+
+static int cmp_name(const void *key, const void *elem) {
+    return strcmp(key, ((const struct builtin_name *)elem)->name);
+}
+
+unibi_term *unibi_from_builtin(const char *name) {
+    const struct builtin_name *bn;
+    const struct builtin_entry *b;
+    unibi_term *t;
+    size_t i;
+
+    bn = bsearch(name, builtin_names, COUNTOF(builtin_names), sizeof *builtin_names, cmp_name);
+    if (!bn) {
+        errno = ENOENT;
+        return NULL;
+    }
+    b = &builtin_entries[bn->entry];
+
+    if (!(t = unibi_dummy())) {
+        return NULL;
+    }
+    unibi_set_name(t, b->name);
+    unibi_set_aliases(t, b->aliases);
+
+    for (i = 0; i < b->nbools; i++) {
+        unibi_set_bool(t, b->bools[i], 1);
+    }
+    for (i = 0; i < b->nnums; i++) {
+        unibi_set_num(t, b->nums[i].cap, b->nums[i].value);
+    }
+    for (i = 0; i < b->nstrs; i++) {
+        unibi_set_str(t, b->strs[i].cap, b->strs[i].value);
+    }
+
+    for (i = 0; i < b->next_bools; i++) {
+        if (unibi_add_ext_bool(t, b->ext_bools[i].name, b->ext_bools[i].value) == (size_t)-1) {
+            goto fail;
+        }
+    }
+    for (i = 0; i < b->next_nums; i++) {
+        if (unibi_add_ext_num(t, b->ext_nums[i].name, b->ext_nums[i].value) == (size_t)-1) {
+            goto fail;
+        }
+    }
+    for (i = 0; i < b->next_strs; i++) {
+        if (unibi_add_ext_str(t, b->ext_strs[i].name, b->ext_strs[i].value) == (size_t)-1) {
+            goto fail;
+        }
+    }
+
+    return t;
+
+fail:
+    unibi_destroy(t);
+    errno = ENOMEM;
+    return NULL;
+}
+
+size_t unibi_count_builtin(void) {
+    return COUNTOF(builtin_names);
+}
+
+const char *unibi_builtin_name(size_t i) {
+    return i < COUNTOF(builtin_names) ? builtin_names[i].name : NULL;
+}
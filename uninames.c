@@ -22,52 +22,53 @@ along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
 #include "unibilium.h"
 
 #include <assert.h>
+#include <string.h>
 
-static const char *names_bool[][2] = {
-    { "bw"      , "auto_left_margin" },
-    { "am"      , "auto_right_margin" },
-    { "xsb"     , "no_esc_ctlc" },
-    { "xhp"     , "ceol_standout_glitch" },
-    { "xenl"    , "eat_newline_glitch" },
-    { "eo"      , "erase_overstrike" },
-    { "gn"      , "generic_type" },
-    { "hc"      , "hard_copy" },
-    { "km"      , "has_meta_key" },
-    { "hs"      , "has_status_line" },
-    { "in"      , "insert_null_glitch" },
-    { "da"      , "memory_above" },
-    { "db"      , "memory_below" },
-    { "mir"     , "move_insert_mode" },
-    { "msgr"    , "move_standout_mode" },
-    { "os"      , "over_strike" },
-    { "eslok"   , "status_line_esc_ok" },
-    { "xt"      , "dest_tabs_magic_smso" },
-    { "hz"      , "tilde_glitch" },
-    { "ul"      , "transparent_underline" },
-    { "xon"     , "xon_xoff" },
-    { "nxon"    , "needs_xon_xoff" },
-    { "mc5i"    , "prtr_silent" },
-    { "chts"    , "hard_cursor" },
-    { "nrrmc"   , "non_rev_rmcup" },
-    { "npc"     , "no_pad_char" },
-    { "ndscr"   , "non_dest_scroll_region" },
-    { "ccc"     , "can_change" },
-    { "bce"     , "back_color_erase" },
-    { "hls"     , "hue_lightness_saturation" },
-    { "xhpa"    , "col_addr_glitch" },
-    { "crxm"    , "cr_cancels_micro_mode" },
-    { "daisy"   , "has_print_wheel" },
-    { "xvpa"    , "row_addr_glitch" },
-    { "sam"     , "semi_auto_right_margin" },
-    { "cpix"    , "cpi_changes_res" },
-    { "lpix"    , "lpi_changes_res" },
-    { "OTbs"    , "backspaces_with_bs" },
-    { "OTns"    , "crt_no_scrolling" },
-    { "OTnc"    , "no_correctly_working_cr" },
-    { "OTMT"    , "gnu_has_meta_key" },
-    { "OTNL"    , "linefeed_is_newline" },
-    { "OTpt"    , "has_hardware_tabs" },
-    { "OTxr"    , "return_does_clr_eol" }
+static const char *names_bool[][3] = {
+    { "bw"      , "auto_left_margin"         , "bw" },
+    { "am"      , "auto_right_margin"        , "am" },
+    { "xsb"     , "no_esc_ctlc"              , "xb" },
+    { "xhp"     , "ceol_standout_glitch"     , "xs" },
+    { "xenl"    , "eat_newline_glitch"       , "xn" },
+    { "eo"      , "erase_overstrike"         , "eo" },
+    { "gn"      , "generic_type"             , "gn" },
+    { "hc"      , "hard_copy"                , "hc" },
+    { "km"      , "has_meta_key"             , "km" },
+    { "hs"      , "has_status_line"          , "hs" },
+    { "in"      , "insert_null_glitch"       , "in" },
+    { "da"      , "memory_above"             , "da" },
+    { "db"      , "memory_below"             , "db" },
+    { "mir"     , "move_insert_mode"         , "mi" },
+    { "msgr"    , "move_standout_mode"       , "ms" },
+    { "os"      , "over_strike"              , "os" },
+    { "eslok"   , "status_line_esc_ok"       , "es" },
+    { "xt"      , "dest_tabs_magic_smso"     , "xt" },
+    { "hz"      , "tilde_glitch"             , "hz" },
+    { "ul"      , "transparent_underline"    , "ul" },
+    { "xon"     , "xon_xoff"                 , "xo" },
+    { "nxon"    , "needs_xon_xoff"           , "nx" },
+    { "mc5i"    , "prtr_silent"              , "5i" },
+    { "chts"    , "hard_cursor"              , "HC" },
+    { "nrrmc"   , "non_rev_rmcup"            , "NR" },
+    { "npc"     , "no_pad_char"              , "NP" },
+    { "ndscr"   , "non_dest_scroll_region"   , "ND" },
+    { "ccc"     , "can_change"               , "cc" },
+    { "bce"     , "back_color_erase"         , "ut" },
+    { "hls"     , "hue_lightness_saturation" , "hl" },
+    { "xhpa"    , "col_addr_glitch"          , "YA" },
+    { "crxm"    , "cr_cancels_micro_mode"    , "YB" },
+    { "daisy"   , "has_print_wheel"          , "YC" },
+    { "xvpa"    , "row_addr_glitch"          , "YD" },
+    { "sam"     , "semi_auto_right_margin"   , "YE" },
+    { "cpix"    , "cpi_changes_res"          , "YF" },
+    { "lpix"    , "lpi_changes_res"          , "YG" },
+    { "OTbs"    , "backspaces_with_bs"       , "bs" },
+    { "OTns"    , "crt_no_scrolling"         , "ns" },
+    { "OTnc"    , "no_correctly_working_cr"  , "nc" },
+    { "OTMT"    , "gnu_has_meta_key"         , "MT" },
+    { "OTNL"    , "linefeed_is_newline"      , "NL" },
+    { "OTpt"    , "has_hardware_tabs"        , "pt" },
+    { "OTxr"    , "return_does_clr_eol"      , "xr" }
 };
 
 static const char *unibi_x_name_bool(enum unibi_boolean v, int long_name) {
@@ -88,46 +89,56 @@ const char *unibi_short_name_bool(enum unibi_boolean v) {
     return unibi_x_name_bool(v, 0);
 }
 
-static const char *names_num[][2] = {
-    { "cols"    , "columns" },
-    { "it"      , "init_tabs" },
-    { "lines"   , "lines" },
-    { "lm"      , "lines_of_memory" },
-    { "xmc"     , "magic_cookie_glitch" },
-    { "pb"      , "padding_baud_rate" },
-    { "vt"      , "virtual_terminal" },
-    { "wsl"     , "width_status_line" },
-    { "nlab"    , "num_labels" },
-    { "lh"      , "label_height" },
-    { "lw"      , "label_width" },
-    { "ma"      , "max_attributes" },
-    { "wnum"    , "maximum_windows" },
-    { "colors"  , "max_colors" },
-    { "pairs"   , "max_pairs" },
-    { "ncv"     , "no_color_video" },
-    { "bufsz"   , "buffer_capacity" },
-    { "spinv"   , "dot_vert_spacing" },
-    { "spinh"   , "dot_horz_spacing" },
-    { "maddr"   , "max_micro_address" },
-    { "mjump"   , "max_micro_jump" },
-    { "mcs"     , "micro_col_size" },
-    { "mls"     , "micro_line_size" },
-    { "npins"   , "number_of_pins" },
-    { "orc"     , "output_res_char" },
-    { "orl"     , "output_res_line" },
-    { "orhi"    , "output_res_horz_inch" },
-    { "orvi"    , "output_res_vert_inch" },
-    { "cps"     , "print_rate" },
-    { "widcs"   , "wide_char_size" },
-    { "btns"    , "buttons" },
-    { "bitwin"  , "bit_image_entwining" },
-    { "bitype"  , "bit_image_type" },
-    { "OTug"    , "magic_cookie_glitch_ul" },
-    { "OTdC"    , "carriage_return_delay" },
-    { "OTdN"    , "new_line_delay" },
-    { "OTdB"    , "backspace_delay" },
-    { "OTdT"    , "horizontal_tab_delay" },
-    { "OTkn"    , "number_of_function_keys" }
+const char *unibi_termcap_name_bool(enum unibi_boolean v) {
+    size_t i;
+    assert(v > unibi_boolean_begin_ && v < unibi_boolean_end_);
+    if (v <= unibi_boolean_begin_ || v >= unibi_boolean_end_) {
+        return NULL;
+    }
+    i = v - unibi_boolean_begin_ - 1;
+    return names_bool[i][2];
+}
+
+static const char *names_num[][3] = {
+    { "cols"    , "columns"                 , "co" },
+    { "it"      , "init_tabs"               , "it" },
+    { "lines"   , "lines"                   , "li" },
+    { "lm"      , "lines_of_memory"         , "lm" },
+    { "xmc"     , "magic_cookie_glitch"     , "sg" },
+    { "pb"      , "padding_baud_rate"       , "pb" },
+    { "vt"      , "virtual_terminal"        , "vt" },
+    { "wsl"     , "width_status_line"       , "ws" },
+    { "nlab"    , "num_labels"              , "Nl" },
+    { "lh"      , "label_height"            , "lh" },
+    { "lw"      , "label_width"             , "lw" },
+    { "ma"      , "max_attributes"          , "ma" },
+    { "wnum"    , "maximum_windows"         , "MW" },
+    { "colors"  , "max_colors"              , "Co" },
+    { "pairs"   , "max_pairs"               , "pa" },
+    { "ncv"     , "no_color_video"          , "NC" },
+    { "bufsz"   , "buffer_capacity"         , "Ya" },
+    { "spinv"   , "dot_vert_spacing"        , "Yb" },
+    { "spinh"   , "dot_horz_spacing"        , "Yc" },
+    { "maddr"   , "max_micro_address"       , "Yd" },
+    { "mjump"   , "max_micro_jump"          , "Ye" },
+    { "mcs"     , "micro_col_size"          , "Yf" },
+    { "mls"     , "micro_line_size"         , "Yg" },
+    { "npins"   , "number_of_pins"          , "Yh" },
+    { "orc"     , "output_res_char"         , "Yi" },
+    { "orl"     , "output_res_line"         , "Yj" },
+    { "orhi"    , "output_res_horz_inch"    , "Yk" },
+    { "orvi"    , "output_res_vert_inch"    , "Yl" },
+    { "cps"     , "print_rate"              , "Ym" },
+    { "widcs"   , "wide_char_size"          , "Yn" },
+    { "btns"    , "buttons"                 , "BT" },
+    { "bitwin"  , "bit_image_entwining"     , "Yo" },
+    { "bitype"  , "bit_image_type"          , "Yp" },
+    { "OTug"    , "magic_cookie_glitch_ul"  , "ug" },
+    { "OTdC"    , "carriage_return_delay"   , "dC" },
+    { "OTdN"    , "new_line_delay"          , "dN" },
+    { "OTdB"    , "backspace_delay"         , "dB" },
+    { "OTdT"    , "horizontal_tab_delay"    , "dT" },
+    { "OTkn"    , "number_of_function_keys" , "kn" }
 };
 
 static const char *unibi_x_name_num(enum unibi_numeric v, int long_name) {
@@ -148,421 +159,431 @@ const char *unibi_short_name_num(enum unibi_numeric v) {
     return unibi_x_name_num(v, 0);
 }
 
-static const char *names_str[][2] = {
-    { "cbt"     , "back_tab" },
-    { "bel"     , "bell" },
-    { "cr"      , "carriage_return" },
-    { "csr"     , "change_scroll_region" },
-    { "tbc"     , "clear_all_tabs" },
-    { "clear"   , "clear_screen" },
-    { "el"      , "clr_eol" },
-    { "ed"      , "clr_eos" },
-    { "hpa"     , "column_address" },
-    { "cmdch"   , "command_character" },
-    { "cup"     , "cursor_address" },
-    { "cud1"    , "cursor_down" },
-    { "home"    , "cursor_home" },
-    { "civis"   , "cursor_invisible" },
-    { "cub1"    , "cursor_left" },
-    { "mrcup"   , "cursor_mem_address" },
-    { "cnorm"   , "cursor_normal" },
-    { "cuf1"    , "cursor_right" },
-    { "ll"      , "cursor_to_ll" },
-    { "cuu1"    , "cursor_up" },
-    { "cvvis"   , "cursor_visible" },
-    { "dch1"    , "delete_character" },
-    { "dl1"     , "delete_line" },
-    { "dsl"     , "dis_status_line" },
-    { "hd"      , "down_half_line" },
-    { "smacs"   , "enter_alt_charset_mode" },
-    { "blink"   , "enter_blink_mode" },
-    { "bold"    , "enter_bold_mode" },
-    { "smcup"   , "enter_ca_mode" },
-    { "smdc"    , "enter_delete_mode" },
-    { "dim"     , "enter_dim_mode" },
-    { "smir"    , "enter_insert_mode" },
-    { "invis"   , "enter_secure_mode" },
-    { "prot"    , "enter_protected_mode" },
-    { "rev"     , "enter_reverse_mode" },
-    { "smso"    , "enter_standout_mode" },
-    { "smul"    , "enter_underline_mode" },
-    { "ech"     , "erase_chars" },
-    { "rmacs"   , "exit_alt_charset_mode" },
-    { "sgr0"    , "exit_attribute_mode" },
-    { "rmcup"   , "exit_ca_mode" },
-    { "rmdc"    , "exit_delete_mode" },
-    { "rmir"    , "exit_insert_mode" },
-    { "rmso"    , "exit_standout_mode" },
-    { "rmul"    , "exit_underline_mode" },
-    { "flash"   , "flash_screen" },
-    { "ff"      , "form_feed" },
-    { "fsl"     , "from_status_line" },
-    { "is1"     , "init_1string" },
-    { "is2"     , "init_2string" },
-    { "is3"     , "init_3string" },
-    { "if"      , "init_file" },
-    { "ich1"    , "insert_character" },
-    { "il1"     , "insert_line" },
-    { "ip"      , "insert_padding" },
-    { "kbs"     , "key_backspace" },
-    { "ktbc"    , "key_catab" },
-    { "kclr"    , "key_clear" },
-    { "kctab"   , "key_ctab" },
-    { "kdch1"   , "key_dc" },
-    { "kdl1"    , "key_dl" },
-    { "kcud1"   , "key_down" },
-    { "krmir"   , "key_eic" },
-    { "kel"     , "key_eol" },
-    { "ked"     , "key_eos" },
-    { "kf0"     , "key_f0" },
-    { "kf1"     , "key_f1" },
-    { "kf10"    , "key_f10" },
-    { "kf2"     , "key_f2" },
-    { "kf3"     , "key_f3" },
-    { "kf4"     , "key_f4" },
-    { "kf5"     , "key_f5" },
-    { "kf6"     , "key_f6" },
-    { "kf7"     , "key_f7" },
-    { "kf8"     , "key_f8" },
-    { "kf9"     , "key_f9" },
-    { "khome"   , "key_home" },
-    { "kich1"   , "key_ic" },
-    { "kil1"    , "key_il" },
-    { "kcub1"   , "key_left" },
-    { "kll"     , "key_ll" },
-    { "knp"     , "key_npage" },
-    { "kpp"     , "key_ppage" },
-    { "kcuf1"   , "key_right" },
-    { "kind"    , "key_sf" },
-    { "kri"     , "key_sr" },
-    { "khts"    , "key_stab" },
-    { "kcuu1"   , "key_up" },
-    { "rmkx"    , "keypad_local" },
-    { "smkx"    , "keypad_xmit" },
-    { "lf0"     , "lab_f0" },
-    { "lf1"     , "lab_f1" },
-    { "lf10"    , "lab_f10" },
-    { "lf2"     , "lab_f2" },
-    { "lf3"     , "lab_f3" },
-    { "lf4"     , "lab_f4" },
-    { "lf5"     , "lab_f5" },
-    { "lf6"     , "lab_f6" },
-    { "lf7"     , "lab_f7" },
-    { "lf8"     , "lab_f8" },
-    { "lf9"     , "lab_f9" },
-    { "rmm"     , "meta_off" },
-    { "smm"     , "meta_on" },
-    { "nel"     , "newline" },
-    { "pad"     , "pad_char" },
-    { "dch"     , "parm_dch" },
-    { "dl"      , "parm_delete_line" },
-    { "cud"     , "parm_down_cursor" },
-    { "ich"     , "parm_ich" },
-    { "indn"    , "parm_index" },
-    { "il"      , "parm_insert_line" },
-    { "cub"     , "parm_left_cursor" },
-    { "cuf"     , "parm_right_cursor" },
-    { "rin"     , "parm_rindex" },
-    { "cuu"     , "parm_up_cursor" },
-    { "pfkey"   , "pkey_key" },
-    { "pfloc"   , "pkey_local" },
-    { "pfx"     , "pkey_xmit" },
-    { "mc0"     , "print_screen" },
-    { "mc4"     , "prtr_off" },
-    { "mc5"     , "prtr_on" },
-    { "rep"     , "repeat_char" },
-    { "rs1"     , "reset_1string" },
-    { "rs2"     , "reset_2string" },
-    { "rs3"     , "reset_3string" },
-    { "rf"      , "reset_file" },
-    { "rc"      , "restore_cursor" },
-    { "vpa"     , "row_address" },
-    { "sc"      , "save_cursor" },
-    { "ind"     , "scroll_forward" },
-    { "ri"      , "scroll_reverse" },
-    { "sgr"     , "set_attributes" },
-    { "hts"     , "set_tab" },
-    { "wind"    , "set_window" },
-    { "ht"      , "tab" },
-    { "tsl"     , "to_status_line" },
-    { "uc"      , "underline_char" },
-    { "hu"      , "up_half_line" },
-    { "iprog"   , "init_prog" },
-    { "ka1"     , "key_a1" },
-    { "ka3"     , "key_a3" },
-    { "kb2"     , "key_b2" },
-    { "kc1"     , "key_c1" },
-    { "kc3"     , "key_c3" },
-    { "mc5p"    , "prtr_non" },
-    { "rmp"     , "char_padding" },
-    { "acsc"    , "acs_chars" },
-    { "pln"     , "plab_norm" },
-    { "kcbt"    , "key_btab" },
-    { "smxon"   , "enter_xon_mode" },
-    { "rmxon"   , "exit_xon_mode" },
-    { "smam"    , "enter_am_mode" },
-    { "rmam"    , "exit_am_mode" },
-    { "xonc"    , "xon_character" },
-    { "xoffc"   , "xoff_character" },
-    { "enacs"   , "ena_acs" },
-    { "smln"    , "label_on" },
-    { "rmln"    , "label_off" },
-    { "kbeg"    , "key_beg" },
-    { "kcan"    , "key_cancel" },
-    { "kclo"    , "key_close" },
-    { "kcmd"    , "key_command" },
-    { "kcpy"    , "key_copy" },
-    { "kcrt"    , "key_create" },
-    { "kend"    , "key_end" },
-    { "kent"    , "key_enter" },
-    { "kext"    , "key_exit" },
-    { "kfnd"    , "key_find" },
-    { "khlp"    , "key_help" },
-    { "kmrk"    , "key_mark" },
-    { "kmsg"    , "key_message" },
-    { "kmov"    , "key_move" },
-    { "knxt"    , "key_next" },
-    { "kopn"    , "key_open" },
-    { "kopt"    , "key_options" },
-    { "kprv"    , "key_previous" },
-    { "kprt"    , "key_print" },
-    { "krdo"    , "key_redo" },
-    { "kref"    , "key_reference" },
-    { "krfr"    , "key_refresh" },
-    { "krpl"    , "key_replace" },
-    { "krst"    , "key_restart" },
-    { "kres"    , "key_resume" },
-    { "ksav"    , "key_save" },
-    { "kspd"    , "key_suspend" },
-    { "kund"    , "key_undo" },
-    { "kBEG"    , "key_sbeg" },
-    { "kCAN"    , "key_scancel" },
-    { "kCMD"    , "key_scommand" },
-    { "kCPY"    , "key_scopy" },
-    { "kCRT"    , "key_screate" },
-    { "kDC"     , "key_sdc" },
-    { "kDL"     , "key_sdl" },
-    { "kslt"    , "key_select" },
-    { "kEND"    , "key_send" },
-    { "kEOL"    , "key_seol" },
-    { "kEXT"    , "key_sexit" },
-    { "kFND"    , "key_sfind" },
-    { "kHLP"    , "key_shelp" },
-    { "kHOM"    , "key_shome" },
-    { "kIC"     , "key_sic" },
-    { "kLFT"    , "key_sleft" },
-    { "kMSG"    , "key_smessage" },
-    { "kMOV"    , "key_smove" },
-    { "kNXT"    , "key_snext" },
-    { "kOPT"    , "key_soptions" },
-    { "kPRV"    , "key_sprevious" },
-    { "kPRT"    , "key_sprint" },
-    { "kRDO"    , "key_sredo" },
-    { "kRPL"    , "key_sreplace" },
-    { "kRIT"    , "key_sright" },
-    { "kRES"    , "key_srsume" },
-    { "kSAV"    , "key_ssave" },
-    { "kSPD"    , "key_ssuspend" },
-    { "kUND"    , "key_sundo" },
-    { "rfi"     , "req_for_input" },
-    { "kf11"    , "key_f11" },
-    { "kf12"    , "key_f12" },
-    { "kf13"    , "key_f13" },
-    { "kf14"    , "key_f14" },
-    { "kf15"    , "key_f15" },
-    { "kf16"    , "key_f16" },
-    { "kf17"    , "key_f17" },
-    { "kf18"    , "key_f18" },
-    { "kf19"    , "key_f19" },
-    { "kf20"    , "key_f20" },
-    { "kf21"    , "key_f21" },
-    { "kf22"    , "key_f22" },
-    { "kf23"    , "key_f23" },
-    { "kf24"    , "key_f24" },
-    { "kf25"    , "key_f25" },
-    { "kf26"    , "key_f26" },
-    { "kf27"    , "key_f27" },
-    { "kf28"    , "key_f28" },
-    { "kf29"    , "key_f29" },
-    { "kf30"    , "key_f30" },
-    { "kf31"    , "key_f31" },
-    { "kf32"    , "key_f32" },
-    { "kf33"    , "key_f33" },
-    { "kf34"    , "key_f34" },
-    { "kf35"    , "key_f35" },
-    { "kf36"    , "key_f36" },
-    { "kf37"    , "key_f37" },
-    { "kf38"    , "key_f38" },
-    { "kf39"    , "key_f39" },
-    { "kf40"    , "key_f40" },
-    { "kf41"    , "key_f41" },
-    { "kf42"    , "key_f42" },
-    { "kf43"    , "key_f43" },
-    { "kf44"    , "key_f44" },
-    { "kf45"    , "key_f45" },
-    { "kf46"    , "key_f46" },
-    { "kf47"    , "key_f47" },
-    { "kf48"    , "key_f48" },
-    { "kf49"    , "key_f49" },
-    { "kf50"    , "key_f50" },
-    { "kf51"    , "key_f51" },
-    { "kf52"    , "key_f52" },
-    { "kf53"    , "key_f53" },
-    { "kf54"    , "key_f54" },
-    { "kf55"    , "key_f55" },
-    { "kf56"    , "key_f56" },
-    { "kf57"    , "key_f57" },
-    { "kf58"    , "key_f58" },
-    { "kf59"    , "key_f59" },
-    { "kf60"    , "key_f60" },
-    { "kf61"    , "key_f61" },
-    { "kf62"    , "key_f62" },
-    { "kf63"    , "key_f63" },
-    { "el1"     , "clr_bol" },
-    { "mgc"     , "clear_margins" },
-    { "smgl"    , "set_left_margin" },
-    { "smgr"    , "set_right_margin" },
-    { "fln"     , "label_format" },
-    { "sclk"    , "set_clock" },
-    { "dclk"    , "display_clock" },
-    { "rmclk"   , "remove_clock" },
-    { "cwin"    , "create_window" },
-    { "wingo"   , "goto_window" },
-    { "hup"     , "hangup" },
-    { "dial"    , "dial_phone" },
-    { "qdial"   , "quick_dial" },
-    { "tone"    , "tone" },
-    { "pulse"   , "pulse" },
-    { "hook"    , "flash_hook" },
-    { "pause"   , "fixed_pause" },
-    { "wait"    , "wait_tone" },
-    { "u0"      , "user0" },
-    { "u1"      , "user1" },
-    { "u2"      , "user2" },
-    { "u3"      , "user3" },
-    { "u4"      , "user4" },
-    { "u5"      , "user5" },
-    { "u6"      , "user6" },
-    { "u7"      , "user7" },
-    { "u8"      , "user8" },
-    { "u9"      , "user9" },
-    { "op"      , "orig_pair" },
-    { "oc"      , "orig_colors" },
-    { "initc"   , "initialize_color" },
-    { "initp"   , "initialize_pair" },
-    { "scp"     , "set_color_pair" },
-    { "setf"    , "set_foreground" },
-    { "setb"    , "set_background" },
-    { "cpi"     , "change_char_pitch" },
-    { "lpi"     , "change_line_pitch" },
-    { "chr"     , "change_res_horz" },
-    { "cvr"     , "change_res_vert" },
-    { "defc"    , "define_char" },
-    { "swidm"   , "enter_doublewide_mode" },
-    { "sdrfq"   , "enter_draft_quality" },
-    { "sitm"    , "enter_italics_mode" },
-    { "slm"     , "enter_leftward_mode" },
-    { "smicm"   , "enter_micro_mode" },
-    { "snlq"    , "enter_near_letter_quality" },
-    { "snrmq"   , "enter_normal_quality" },
-    { "sshm"    , "enter_shadow_mode" },
-    { "ssubm"   , "enter_subscript_mode" },
-    { "ssupm"   , "enter_superscript_mode" },
-    { "sum"     , "enter_upward_mode" },
-    { "rwidm"   , "exit_doublewide_mode" },
-    { "ritm"    , "exit_italics_mode" },
-    { "rlm"     , "exit_leftward_mode" },
-    { "rmicm"   , "exit_micro_mode" },
-    { "rshm"    , "exit_shadow_mode" },
-    { "rsubm"   , "exit_subscript_mode" },
-    { "rsupm"   , "exit_superscript_mode" },
-    { "rum"     , "exit_upward_mode" },
-    { "mhpa"    , "micro_column_address" },
-    { "mcud1"   , "micro_down" },
-    { "mcub1"   , "micro_left" },
-    { "mcuf1"   , "micro_right" },
-    { "mvpa"    , "micro_row_address" },
-    { "mcuu1"   , "micro_up" },
-    { "porder"  , "order_of_pins" },
-    { "mcud"    , "parm_down_micro" },
-    { "mcub"    , "parm_left_micro" },
-    { "mcuf"    , "parm_right_micro" },
-    { "mcuu"    , "parm_up_micro" },
-    { "scs"     , "select_char_set" },
-    { "smgb"    , "set_bottom_margin" },
-    { "smgbp"   , "set_bottom_margin_parm" },
-    { "smglp"   , "set_left_margin_parm" },
-    { "smgrp"   , "set_right_margin_parm" },
-    { "smgt"    , "set_top_margin" },
-    { "smgtp"   , "set_top_margin_parm" },
-    { "sbim"    , "start_bit_image" },
-    { "scsd"    , "start_char_set_def" },
-    { "rbim"    , "stop_bit_image" },
-    { "rcsd"    , "stop_char_set_def" },
-    { "subcs"   , "subscript_characters" },
-    { "supcs"   , "superscript_characters" },
-    { "docr"    , "these_cause_cr" },
-    { "zerom"   , "zero_motion" },
-    { "csnm"    , "char_set_names" },
-    { "kmous"   , "key_mouse" },
-    { "minfo"   , "mouse_info" },
-    { "reqmp"   , "req_mouse_pos" },
-    { "getm"    , "get_mouse" },
-    { "setaf"   , "set_a_foreground" },
-    { "setab"   , "set_a_background" },
-    { "pfxl"    , "pkey_plab" },
-    { "devt"    , "device_type" },
-    { "csin"    , "code_set_init" },
-    { "s0ds"    , "set0_des_seq" },
-    { "s1ds"    , "set1_des_seq" },
-    { "s2ds"    , "set2_des_seq" },
-    { "s3ds"    , "set3_des_seq" },
-    { "smglr"   , "set_lr_margin" },
-    { "smgtb"   , "set_tb_margin" },
-    { "birep"   , "bit_image_repeat" },
-    { "binel"   , "bit_image_newline" },
-    { "bicr"    , "bit_image_carriage_return" },
-    { "colornm" , "color_names" },
-    { "defbi"   , "define_bit_image_region" },
-    { "endbi"   , "end_bit_image_region" },
-    { "setcolor", "set_color_band" },
-    { "slines"  , "set_page_length" },
-    { "dispc"   , "display_pc_char" },
-    { "smpch"   , "enter_pc_charset_mode" },
-    { "rmpch"   , "exit_pc_charset_mode" },
-    { "smsc"    , "enter_scancode_mode" },
-    { "rmsc"    , "exit_scancode_mode" },
-    { "pctrm"   , "pc_term_options" },
-    { "scesc"   , "scancode_escape" },
-    { "scesa"   , "alt_scancode_esc" },
-    { "ehhlm"   , "enter_horizontal_hl_mode" },
-    { "elhlm"   , "enter_left_hl_mode" },
-    { "elohlm"  , "enter_low_hl_mode" },
-    { "erhlm"   , "enter_right_hl_mode" },
-    { "ethlm"   , "enter_top_hl_mode" },
-    { "evhlm"   , "enter_vertical_hl_mode" },
-    { "sgr1"    , "set_a_attributes" },
-    { "slength" , "set_pglen_inch" },
-    { "OTi2"    , "termcap_init2" },
-    { "OTrs"    , "termcap_reset" },
-    { "OTnl"    , "linefeed_if_not_lf" },
-    { "OTbc"    , "backspace_if_not_bs" },
-    { "OTko"    , "other_non_function_keys" },
-    { "OTma"    , "arrow_key_map" },
-    { "OTG2"    , "acs_ulcorner" },
-    { "OTG3"    , "acs_llcorner" },
-    { "OTG1"    , "acs_urcorner" },
-    { "OTG4"    , "acs_lrcorner" },
-    { "OTGR"    , "acs_ltee" },
-    { "OTGL"    , "acs_rtee" },
-    { "OTGU"    , "acs_btee" },
-    { "OTGD"    , "acs_ttee" },
-    { "OTGH"    , "acs_hline" },
-    { "OTGV"    , "acs_vline" },
-    { "OTGC"    , "acs_plus" },
-    { "meml"    , "memory_lock" },
-    { "memu"    , "memory_unlock" },
-    { "box1"    , "box_chars_1" }
+const char *unibi_termcap_name_num(enum unibi_numeric v) {
+    size_t i;
+    assert(v > unibi_numeric_begin_ && v < unibi_numeric_end_);
+    if (v <= unibi_numeric_begin_ || v >= unibi_numeric_end_) {
+        return NULL;
+    }
+    i = v - unibi_numeric_begin_ - 1;
+    return names_num[i][2];
+}
+
+static const char *names_str[][4] = {
+    { "cbt"     , "back_tab"                 , ""          , "bt" },
+    { "bel"     , "bell"                     , ""          , "bl" },
+    { "cr"      , "carriage_return"          , ""          , "cr" },
+    { "csr"     , "change_scroll_region"     , "nn"        , "cs" },
+    { "tbc"     , "clear_all_tabs"           , ""          , "ct" },
+    { "clear"   , "clear_screen"             , ""          , "cl" },
+    { "el"      , "clr_eol"                  , ""          , "ce" },
+    { "ed"      , "clr_eos"                  , ""          , "cd" },
+    { "hpa"     , "column_address"           , "n"         , "ch" },
+    { "cmdch"   , "command_character"        , ""          , "CC" },
+    { "cup"     , "cursor_address"           , "nn"        , "cm" },
+    { "cud1"    , "cursor_down"              , ""          , "do" },
+    { "home"    , "cursor_home"              , ""          , "ho" },
+    { "civis"   , "cursor_invisible"         , ""          , "vi" },
+    { "cub1"    , "cursor_left"              , ""          , "le" },
+    { "mrcup"   , "cursor_mem_address"       , "nn"        , "CM" },
+    { "cnorm"   , "cursor_normal"            , ""          , "ve" },
+    { "cuf1"    , "cursor_right"             , ""          , "nd" },
+    { "ll"      , "cursor_to_ll"             , ""          , "ll" },
+    { "cuu1"    , "cursor_up"                , ""          , "up" },
+    { "cvvis"   , "cursor_visible"           , ""          , "vs" },
+    { "dch1"    , "delete_character"         , ""          , "dc" },
+    { "dl1"     , "delete_line"              , ""          , "dl" },
+    { "dsl"     , "dis_status_line"          , ""          , "ds" },
+    { "hd"      , "down_half_line"           , ""          , "hd" },
+    { "smacs"   , "enter_alt_charset_mode"   , ""          , "as" },
+    { "blink"   , "enter_blink_mode"         , ""          , "mb" },
+    { "bold"    , "enter_bold_mode"          , ""          , "md" },
+    { "smcup"   , "enter_ca_mode"            , ""          , "ti" },
+    { "smdc"    , "enter_delete_mode"        , ""          , "dm" },
+    { "dim"     , "enter_dim_mode"           , ""          , "mh" },
+    { "smir"    , "enter_insert_mode"        , ""          , "im" },
+    { "invis"   , "enter_secure_mode"        , ""          , "mk" },
+    { "prot"    , "enter_protected_mode"     , ""          , "mp" },
+    { "rev"     , "enter_reverse_mode"       , ""          , "mr" },
+    { "smso"    , "enter_standout_mode"      , ""          , "so" },
+    { "smul"    , "enter_underline_mode"     , ""          , "us" },
+    { "ech"     , "erase_chars"              , "n"         , "ec" },
+    { "rmacs"   , "exit_alt_charset_mode"    , ""          , "ae" },
+    { "sgr0"    , "exit_attribute_mode"      , ""          , "me" },
+    { "rmcup"   , "exit_ca_mode"             , ""          , "te" },
+    { "rmdc"    , "exit_delete_mode"         , ""          , "ed" },
+    { "rmir"    , "exit_insert_mode"         , ""          , "ei" },
+    { "rmso"    , "exit_standout_mode"       , ""          , "se" },
+    { "rmul"    , "exit_underline_mode"      , ""          , "ue" },
+    { "flash"   , "flash_screen"             , ""          , "vb" },
+    { "ff"      , "form_feed"                , ""          , "ff" },
+    { "fsl"     , "from_status_line"         , ""          , "fs" },
+    { "is1"     , "init_1string"             , ""          , "i1" },
+    { "is2"     , "init_2string"             , ""          , "is" },
+    { "is3"     , "init_3string"             , ""          , "i3" },
+    { "if"      , "init_file"                , ""          , "if" },
+    { "ich1"    , "insert_character"         , ""          , "ic" },
+    { "il1"     , "insert_line"              , ""          , "al" },
+    { "ip"      , "insert_padding"           , ""          , "ip" },
+    { "kbs"     , "key_backspace"            , ""          , "kb" },
+    { "ktbc"    , "key_catab"                , ""          , "ka" },
+    { "kclr"    , "key_clear"                , ""          , "kC" },
+    { "kctab"   , "key_ctab"                 , ""          , "kt" },
+    { "kdch1"   , "key_dc"                   , ""          , "kD" },
+    { "kdl1"    , "key_dl"                   , ""          , "kL" },
+    { "kcud1"   , "key_down"                 , ""          , "kd" },
+    { "krmir"   , "key_eic"                  , ""          , "kM" },
+    { "kel"     , "key_eol"                  , ""          , "kE" },
+    { "ked"     , "key_eos"                  , ""          , "kS" },
+    { "kf0"     , "key_f0"                   , ""          , "k0" },
+    { "kf1"     , "key_f1"                   , ""          , "k1" },
+    { "kf10"    , "key_f10"                  , ""          , "k;" },
+    { "kf2"     , "key_f2"                   , ""          , "k2" },
+    { "kf3"     , "key_f3"                   , ""          , "k3" },
+    { "kf4"     , "key_f4"                   , ""          , "k4" },
+    { "kf5"     , "key_f5"                   , ""          , "k5" },
+    { "kf6"     , "key_f6"                   , ""          , "k6" },
+    { "kf7"     , "key_f7"                   , ""          , "k7" },
+    { "kf8"     , "key_f8"                   , ""          , "k8" },
+    { "kf9"     , "key_f9"                   , ""          , "k9" },
+    { "khome"   , "key_home"                 , ""          , "kh" },
+    { "kich1"   , "key_ic"                   , ""          , "kI" },
+    { "kil1"    , "key_il"                   , ""          , "kA" },
+    { "kcub1"   , "key_left"                 , ""          , "kl" },
+    { "kll"     , "key_ll"                   , ""          , "kH" },
+    { "knp"     , "key_npage"                , ""          , "kN" },
+    { "kpp"     , "key_ppage"                , ""          , "kP" },
+    { "kcuf1"   , "key_right"                , ""          , "kr" },
+    { "kind"    , "key_sf"                   , ""          , "kF" },
+    { "kri"     , "key_sr"                   , ""          , "kR" },
+    { "khts"    , "key_stab"                 , ""          , "kT" },
+    { "kcuu1"   , "key_up"                   , ""          , "ku" },
+    { "rmkx"    , "keypad_local"             , ""          , "ke" },
+    { "smkx"    , "keypad_xmit"              , ""          , "ks" },
+    { "lf0"     , "lab_f0"                   , ""          , "l0" },
+    { "lf1"     , "lab_f1"                   , ""          , "l1" },
+    { "lf10"    , "lab_f10"                  , ""          , "la" },
+    { "lf2"     , "lab_f2"                   , ""          , "l2" },
+    { "lf3"     , "lab_f3"                   , ""          , "l3" },
+    { "lf4"     , "lab_f4"                   , ""          , "l4" },
+    { "lf5"     , "lab_f5"                   , ""          , "l5" },
+    { "lf6"     , "lab_f6"                   , ""          , "l6" },
+    { "lf7"     , "lab_f7"                   , ""          , "l7" },
+    { "lf8"     , "lab_f8"                   , ""          , "l8" },
+    { "lf9"     , "lab_f9"                   , ""          , "l9" },
+    { "rmm"     , "meta_off"                 , ""          , "mo" },
+    { "smm"     , "meta_on"                  , ""          , "mm" },
+    { "nel"     , "newline"                  , ""          , "nw" },
+    { "pad"     , "pad_char"                 , ""          , "pc" },
+    { "dch"     , "parm_dch"                 , "n"         , "DC" },
+    { "dl"      , "parm_delete_line"         , "n"         , "DL" },
+    { "cud"     , "parm_down_cursor"         , "n"         , "DO" },
+    { "ich"     , "parm_ich"                 , "n"         , "IC" },
+    { "indn"    , "parm_index"               , "n"         , "SF" },
+    { "il"      , "parm_insert_line"         , "n"         , "AL" },
+    { "cub"     , "parm_left_cursor"         , "n"         , "LE" },
+    { "cuf"     , "parm_right_cursor"        , "n"         , "RI" },
+    { "rin"     , "parm_rindex"              , "n"         , "SR" },
+    { "cuu"     , "parm_up_cursor"           , "n"         , "UP" },
+    { "pfkey"   , "pkey_key"                 , "ns"        , "pk" },
+    { "pfloc"   , "pkey_local"               , "ns"        , "pl" },
+    { "pfx"     , "pkey_xmit"                , "ns"        , "px" },
+    { "mc0"     , "print_screen"             , ""          , "ps" },
+    { "mc4"     , "prtr_off"                 , ""          , "pf" },
+    { "mc5"     , "prtr_on"                  , ""          , "po" },
+    { "rep"     , "repeat_char"              , "nn"        , "rp" },
+    { "rs1"     , "reset_1string"            , ""          , "r1" },
+    { "rs2"     , "reset_2string"            , ""          , "r2" },
+    { "rs3"     , "reset_3string"            , ""          , "r3" },
+    { "rf"      , "reset_file"               , ""          , "rf" },
+    { "rc"      , "restore_cursor"           , ""          , "rc" },
+    { "vpa"     , "row_address"              , "n"         , "cv" },
+    { "sc"      , "save_cursor"              , ""          , "sc" },
+    { "ind"     , "scroll_forward"           , ""          , "sf" },
+    { "ri"      , "scroll_reverse"           , ""          , "sr" },
+    { "sgr"     , "set_attributes"           , "nnnnnnnnn" , "sa" },
+    { "hts"     , "set_tab"                  , ""          , "st" },
+    { "wind"    , "set_window"               , "nnnn"      , "wi" },
+    { "ht"      , "tab"                      , ""          , "ta" },
+    { "tsl"     , "to_status_line"           , "n"         , "ts" },
+    { "uc"      , "underline_char"           , ""          , "uc" },
+    { "hu"      , "up_half_line"             , ""          , "hu" },
+    { "iprog"   , "init_prog"                , ""          , "iP" },
+    { "ka1"     , "key_a1"                   , ""          , "K1" },
+    { "ka3"     , "key_a3"                   , ""          , "K3" },
+    { "kb2"     , "key_b2"                   , ""          , "K2" },
+    { "kc1"     , "key_c1"                   , ""          , "K4" },
+    { "kc3"     , "key_c3"                   , ""          , "K5" },
+    { "mc5p"    , "prtr_non"                 , "n"         , "pO" },
+    { "rmp"     , "char_padding"             , ""          , "rP" },
+    { "acsc"    , "acs_chars"                , ""          , "ac" },
+    { "pln"     , "plab_norm"                , "ns"        , "pn" },
+    { "kcbt"    , "key_btab"                 , ""          , "kB" },
+    { "smxon"   , "enter_xon_mode"           , ""          , "SX" },
+    { "rmxon"   , "exit_xon_mode"            , ""          , "RX" },
+    { "smam"    , "enter_am_mode"            , ""          , "SA" },
+    { "rmam"    , "exit_am_mode"             , ""          , "RA" },
+    { "xonc"    , "xon_character"            , ""          , "XN" },
+    { "xoffc"   , "xoff_character"           , ""          , "XF" },
+    { "enacs"   , "ena_acs"                  , ""          , "eA" },
+    { "smln"    , "label_on"                 , ""          , "LO" },
+    { "rmln"    , "label_off"                , ""          , "LF" },
+    { "kbeg"    , "key_beg"                  , ""          , "@1" },
+    { "kcan"    , "key_cancel"               , ""          , "@2" },
+    { "kclo"    , "key_close"                , ""          , "@3" },
+    { "kcmd"    , "key_command"              , ""          , "@4" },
+    { "kcpy"    , "key_copy"                 , ""          , "@5" },
+    { "kcrt"    , "key_create"               , ""          , "@6" },
+    { "kend"    , "key_end"                  , ""          , "@7" },
+    { "kent"    , "key_enter"                , ""          , "@8" },
+    { "kext"    , "key_exit"                 , ""          , "@9" },
+    { "kfnd"    , "key_find"                 , ""          , "@0" },
+    { "khlp"    , "key_help"                 , ""          , "%1" },
+    { "kmrk"    , "key_mark"                 , ""          , "%2" },
+    { "kmsg"    , "key_message"              , ""          , "%3" },
+    { "kmov"    , "key_move"                 , ""          , "%4" },
+    { "knxt"    , "key_next"                 , ""          , "%5" },
+    { "kopn"    , "key_open"                 , ""          , "%6" },
+    { "kopt"    , "key_options"              , ""          , "%7" },
+    { "kprv"    , "key_previous"             , ""          , "%8" },
+    { "kprt"    , "key_print"                , ""          , "%9" },
+    { "krdo"    , "key_redo"                 , ""          , "%0" },
+    { "kref"    , "key_reference"            , ""          , "&1" },
+    { "krfr"    , "key_refresh"              , ""          , "&2" },
+    { "krpl"    , "key_replace"              , ""          , "&3" },
+    { "krst"    , "key_restart"              , ""          , "&4" },
+    { "kres"    , "key_resume"               , ""          , "&5" },
+    { "ksav"    , "key_save"                 , ""          , "&6" },
+    { "kspd"    , "key_suspend"              , ""          , "&7" },
+    { "kund"    , "key_undo"                 , ""          , "&8" },
+    { "kBEG"    , "key_sbeg"                 , ""          , "&9" },
+    { "kCAN"    , "key_scancel"              , ""          , "&0" },
+    { "kCMD"    , "key_scommand"             , ""          , "*1" },
+    { "kCPY"    , "key_scopy"                , ""          , "*2" },
+    { "kCRT"    , "key_screate"              , ""          , "*3" },
+    { "kDC"     , "key_sdc"                  , ""          , "*4" },
+    { "kDL"     , "key_sdl"                  , ""          , "*5" },
+    { "kslt"    , "key_select"               , ""          , "*6" },
+    { "kEND"    , "key_send"                 , ""          , "*7" },
+    { "kEOL"    , "key_seol"                 , ""          , "*8" },
+    { "kEXT"    , "key_sexit"                , ""          , "*9" },
+    { "kFND"    , "key_sfind"                , ""          , "*0" },
+    { "kHLP"    , "key_shelp"                , ""          , "#1" },
+    { "kHOM"    , "key_shome"                , ""          , "#2" },
+    { "kIC"     , "key_sic"                  , ""          , "#3" },
+    { "kLFT"    , "key_sleft"                , ""          , "#4" },
+    { "kMSG"    , "key_smessage"             , ""          , "%a" },
+    { "kMOV"    , "key_smove"                , ""          , "%b" },
+    { "kNXT"    , "key_snext"                , ""          , "%c" },
+    { "kOPT"    , "key_soptions"             , ""          , "%d" },
+    { "kPRV"    , "key_sprevious"            , ""          , "%e" },
+    { "kPRT"    , "key_sprint"               , ""          , "%f" },
+    { "kRDO"    , "key_sredo"                , ""          , "%g" },
+    { "kRPL"    , "key_sreplace"             , ""          , "%h" },
+    { "kRIT"    , "key_sright"               , ""          , "%i" },
+    { "kRES"    , "key_srsume"               , ""          , "%j" },
+    { "kSAV"    , "key_ssave"                , ""          , "!1" },
+    { "kSPD"    , "key_ssuspend"             , ""          , "!2" },
+    { "kUND"    , "key_sundo"                , ""          , "!3" },
+    { "rfi"     , "req_for_input"            , ""          , "RF" },
+    { "kf11"    , "key_f11"                  , ""          , "F1" },
+    { "kf12"    , "key_f12"                  , ""          , "F2" },
+    { "kf13"    , "key_f13"                  , ""          , "F3" },
+    { "kf14"    , "key_f14"                  , ""          , "F4" },
+    { "kf15"    , "key_f15"                  , ""          , "F5" },
+    { "kf16"    , "key_f16"                  , ""          , "F6" },
+    { "kf17"    , "key_f17"                  , ""          , "F7" },
+    { "kf18"    , "key_f18"                  , ""          , "F8" },
+    { "kf19"    , "key_f19"                  , ""          , "F9" },
+    { "kf20"    , "key_f20"                  , ""          , "FA" },
+    { "kf21"    , "key_f21"                  , ""          , "FB" },
+    { "kf22"    , "key_f22"                  , ""          , "FC" },
+    { "kf23"    , "key_f23"                  , ""          , "FD" },
+    { "kf24"    , "key_f24"                  , ""          , "FE" },
+    { "kf25"    , "key_f25"                  , ""          , "FF" },
+    { "kf26"    , "key_f26"                  , ""          , "FG" },
+    { "kf27"    , "key_f27"                  , ""          , "FH" },
+    { "kf28"    , "key_f28"                  , ""          , "FI" },
+    { "kf29"    , "key_f29"                  , ""          , "FJ" },
+    { "kf30"    , "key_f30"                  , ""          , "FK" },
+    { "kf31"    , "key_f31"                  , ""          , "FL" },
+    { "kf32"    , "key_f32"                  , ""          , "FM" },
+    { "kf33"    , "key_f33"                  , ""          , "FN" },
+    { "kf34"    , "key_f34"                  , ""          , "FO" },
+    { "kf35"    , "key_f35"                  , ""          , "FP" },
+    { "kf36"    , "key_f36"                  , ""          , "FQ" },
+    { "kf37"    , "key_f37"                  , ""          , "FR" },
+    { "kf38"    , "key_f38"                  , ""          , "FS" },
+    { "kf39"    , "key_f39"                  , ""          , "FT" },
+    { "kf40"    , "key_f40"                  , ""          , "FU" },
+    { "kf41"    , "key_f41"                  , ""          , "FV" },
+    { "kf42"    , "key_f42"                  , ""          , "FW" },
+    { "kf43"    , "key_f43"                  , ""          , "FX" },
+    { "kf44"    , "key_f44"                  , ""          , "FY" },
+    { "kf45"    , "key_f45"                  , ""          , "FZ" },
+    { "kf46"    , "key_f46"                  , ""          , "Fa" },
+    { "kf47"    , "key_f47"                  , ""          , "Fb" },
+    { "kf48"    , "key_f48"                  , ""          , "Fc" },
+    { "kf49"    , "key_f49"                  , ""          , "Fd" },
+    { "kf50"    , "key_f50"                  , ""          , "Fe" },
+    { "kf51"    , "key_f51"                  , ""          , "Ff" },
+    { "kf52"    , "key_f52"                  , ""          , "Fg" },
+    { "kf53"    , "key_f53"                  , ""          , "Fh" },
+    { "kf54"    , "key_f54"                  , ""          , "Fi" },
+    { "kf55"    , "key_f55"                  , ""          , "Fj" },
+    { "kf56"    , "key_f56"                  , ""          , "Fk" },
+    { "kf57"    , "key_f57"                  , ""          , "Fl" },
+    { "kf58"    , "key_f58"                  , ""          , "Fm" },
+    { "kf59"    , "key_f59"                  , ""          , "Fn" },
+    { "kf60"    , "key_f60"                  , ""          , "Fo" },
+    { "kf61"    , "key_f61"                  , ""          , "Fp" },
+    { "kf62"    , "key_f62"                  , ""          , "Fq" },
+    { "kf63"    , "key_f63"                  , ""          , "Fr" },
+    { "el1"     , "clr_bol"                  , ""          , "cb" },
+    { "mgc"     , "clear_margins"            , ""          , "MC" },
+    { "smgl"    , "set_left_margin"          , ""          , "ML" },
+    { "smgr"    , "set_right_margin"         , ""          , "MR" },
+    { "fln"     , "label_format"             , ""          , "Lf" },
+    { "sclk"    , "set_clock"                , "nnn"       , "SC" },
+    { "dclk"    , "display_clock"            , ""          , "DK" },
+    { "rmclk"   , "remove_clock"             , ""          , "RC" },
+    { "cwin"    , "create_window"            , "nnnnn"     , "CW" },
+    { "wingo"   , "goto_window"              , "n"         , "WG" },
+    { "hup"     , "hangup"                   , ""          , "HU" },
+    { "dial"    , "dial_phone"               , "s"         , "DI" },
+    { "qdial"   , "quick_dial"               , "s"         , "QD" },
+    { "tone"    , "tone"                     , ""          , "TO" },
+    { "pulse"   , "pulse"                    , ""          , "PU" },
+    { "hook"    , "flash_hook"               , ""          , "fh" },
+    { "pause"   , "fixed_pause"              , ""          , "PA" },
+    { "wait"    , "wait_tone"                , ""          , "WA" },
+    { "u0"      , "user0"                    , ""          , "u0" },
+    { "u1"      , "user1"                    , ""          , "u1" },
+    { "u2"      , "user2"                    , ""          , "u2" },
+    { "u3"      , "user3"                    , ""          , "u3" },
+    { "u4"      , "user4"                    , ""          , "u4" },
+    { "u5"      , "user5"                    , ""          , "u5" },
+    { "u6"      , "user6"                    , ""          , "u6" },
+    { "u7"      , "user7"                    , ""          , "u7" },
+    { "u8"      , "user8"                    , ""          , "u8" },
+    { "u9"      , "user9"                    , ""          , "u9" },
+    { "op"      , "orig_pair"                , ""          , "op" },
+    { "oc"      , "orig_colors"              , ""          , "oc" },
+    { "initc"   , "initialize_color"         , "nnnn"      , "Ic" },
+    { "initp"   , "initialize_pair"          , "nnnnnnn"   , "Ip" },
+    { "scp"     , "set_color_pair"           , "n"         , "sp" },
+    { "setf"    , "set_foreground"           , "n"         , "Sf" },
+    { "setb"    , "set_background"           , "n"         , "Sb" },
+    { "cpi"     , "change_char_pitch"        , "n"         , "ZA" },
+    { "lpi"     , "change_line_pitch"        , "n"         , "ZB" },
+    { "chr"     , "change_res_horz"          , "n"         , "ZC" },
+    { "cvr"     , "change_res_vert"          , "n"         , "ZD" },
+    { "defc"    , "define_char"              , "nnn"       , "ZE" },
+    { "swidm"   , "enter_doublewide_mode"    , ""          , "ZF" },
+    { "sdrfq"   , "enter_draft_quality"      , ""          , "ZG" },
+    { "sitm"    , "enter_italics_mode"       , ""          , "ZH" },
+    { "slm"     , "enter_leftward_mode"      , ""          , "ZI" },
+    { "smicm"   , "enter_micro_mode"         , ""          , "ZJ" },
+    { "snlq"    , "enter_near_letter_quality", ""          , "ZK" },
+    { "snrmq"   , "enter_normal_quality"     , ""          , "ZL" },
+    { "sshm"    , "enter_shadow_mode"        , ""          , "ZM" },
+    { "ssubm"   , "enter_subscript_mode"     , ""          , "ZN" },
+    { "ssupm"   , "enter_superscript_mode"   , ""          , "ZO" },
+    { "sum"     , "enter_upward_mode"        , ""          , "ZP" },
+    { "rwidm"   , "exit_doublewide_mode"     , ""          , "ZQ" },
+    { "ritm"    , "exit_italics_mode"        , ""          , "ZR" },
+    { "rlm"     , "exit_leftward_mode"       , ""          , "ZS" },
+    { "rmicm"   , "exit_micro_mode"          , ""          , "ZT" },
+    { "rshm"    , "exit_shadow_mode"         , ""          , "ZU" },
+    { "rsubm"   , "exit_subscript_mode"      , ""          , "ZV" },
+    { "rsupm"   , "exit_superscript_mode"    , ""          , "ZW" },
+    { "rum"     , "exit_upward_mode"         , ""          , "ZX" },
+    { "mhpa"    , "micro_column_address"     , "n"         , "ZY" },
+    { "mcud1"   , "micro_down"               , ""          , "ZZ" },
+    { "mcub1"   , "micro_left"               , ""          , "Za" },
+    { "mcuf1"   , "micro_right"              , ""          , "Zb" },
+    { "mvpa"    , "micro_row_address"        , "n"         , "Zc" },
+    { "mcuu1"   , "micro_up"                 , ""          , "Zd" },
+    { "porder"  , "order_of_pins"            , ""          , "Ze" },
+    { "mcud"    , "parm_down_micro"          , "n"         , "Zf" },
+    { "mcub"    , "parm_left_micro"          , "n"         , "Zg" },
+    { "mcuf"    , "parm_right_micro"         , "n"         , "Zh" },
+    { "mcuu"    , "parm_up_micro"            , "n"         , "Zi" },
+    { "scs"     , "select_char_set"          , "n"         , "Zj" },
+    { "smgb"    , "set_bottom_margin"        , ""          , "Zk" },
+    { "smgbp"   , "set_bottom_margin_parm"   , "n"         , "Zl" },
+    { "smglp"   , "set_left_margin_parm"     , "n"         , "Zm" },
+    { "smgrp"   , "set_right_margin_parm"    , "n"         , "Zn" },
+    { "smgt"    , "set_top_margin"           , ""          , "Zo" },
+    { "smgtp"   , "set_top_margin_parm"      , "n"         , "Zp" },
+    { "sbim"    , "start_bit_image"          , ""          , "Zq" },
+    { "scsd"    , "start_char_set_def"       , "nn"        , "Zr" },
+    { "rbim"    , "stop_bit_image"           , ""          , "Zs" },
+    { "rcsd"    , "stop_char_set_def"        , "n"         , "Zt" },
+    { "subcs"   , "subscript_characters"     , ""          , "Zu" },
+    { "supcs"   , "superscript_characters"   , ""          , "Zv" },
+    { "docr"    , "these_cause_cr"           , ""          , "Zw" },
+    { "zerom"   , "zero_motion"              , ""          , "Zx" },
+    { "csnm"    , "char_set_names"           , "n"         , "Zy" },
+    { "kmous"   , "key_mouse"                , ""          , "Km" },
+    { "minfo"   , "mouse_info"               , ""          , "Mi" },
+    { "reqmp"   , "req_mouse_pos"            , ""          , "RQ" },
+    { "getm"    , "get_mouse"                , "n"         , "Gm" },
+    { "setaf"   , "set_a_foreground"         , "n"         , "AF" },
+    { "setab"   , "set_a_background"         , "n"         , "AB" },
+    { "pfxl"    , "pkey_plab"                , "nss"       , "xl" },
+    { "devt"    , "device_type"              , "n"         , "dv" },
+    { "csin"    , "code_set_init"            , ""          , "ci" },
+    { "s0ds"    , "set0_des_seq"             , ""          , "s0" },
+    { "s1ds"    , "set1_des_seq"             , ""          , "s1" },
+    { "s2ds"    , "set2_des_seq"             , ""          , "s2" },
+    { "s3ds"    , "set3_des_seq"             , ""          , "s3" },
+    { "smglr"   , "set_lr_margin"            , "nn"        , "ML" },
+    { "smgtb"   , "set_tb_margin"            , "nn"        , "MT" },
+    { "birep"   , "bit_image_repeat"         , "nn"        , "Xy" },
+    { "binel"   , "bit_image_newline"        , ""          , "Zz" },
+    { "bicr"    , "bit_image_carriage_return", ""          , "Yv" },
+    { "colornm" , "color_names"              , "n"         , "Yw" },
+    { "defbi"   , "define_bit_image_region"  , "nnnn"      , "Yx" },
+    { "endbi"   , "end_bit_image_region"     , ""          , "Yy" },
+    { "setcolor", "set_color_band"           , "n"         , "Yz" },
+    { "slines"  , "set_page_length"          , "n"         , "YZ" },
+    { "dispc"   , "display_pc_char"          , "n"         , "S1" },
+    { "smpch"   , "enter_pc_charset_mode"    , ""          , "S2" },
+    { "rmpch"   , "exit_pc_charset_mode"     , ""          , "S3" },
+    { "smsc"    , "enter_scancode_mode"      , ""          , "S4" },
+    { "rmsc"    , "exit_scancode_mode"       , ""          , "S5" },
+    { "pctrm"   , "pc_term_options"          , ""          , "S6" },
+    { "scesc"   , "scancode_escape"          , ""          , "S7" },
+    { "scesa"   , "alt_scancode_esc"         , ""          , "S8" },
+    { "ehhlm"   , "enter_horizontal_hl_mode" , ""          , "Xh" },
+    { "elhlm"   , "enter_left_hl_mode"       , ""          , "Xl" },
+    { "elohlm"  , "enter_low_hl_mode"        , ""          , "Xo" },
+    { "erhlm"   , "enter_right_hl_mode"      , ""          , "Xr" },
+    { "ethlm"   , "enter_top_hl_mode"        , ""          , "Xt" },
+    { "evhlm"   , "enter_vertical_hl_mode"   , ""          , "Xv" },
+    { "sgr1"    , "set_a_attributes"         , "nnnnnn"    , "sA" },
+    { "slength" , "set_pglen_inch"           , "n"         , "YI" },
+    { "OTi2"    , "termcap_init2"            , ""          , "i2" },
+    { "OTrs"    , "termcap_reset"            , ""          , "rs" },
+    { "OTnl"    , "linefeed_if_not_lf"       , ""          , "nl" },
+    { "OTbc"    , "backspace_if_not_bs"      , ""          , "bc" },
+    { "OTko"    , "other_non_function_keys"  , ""          , "ko" },
+    { "OTma"    , "arrow_key_map"            , ""          , "ma" },
+    { "OTG2"    , "acs_ulcorner"             , ""          , "G2" },
+    { "OTG3"    , "acs_llcorner"             , ""          , "G3" },
+    { "OTG1"    , "acs_urcorner"             , ""          , "G1" },
+    { "OTG4"    , "acs_lrcorner"             , ""          , "G4" },
+    { "OTGR"    , "acs_ltee"                 , ""          , "GR" },
+    { "OTGL"    , "acs_rtee"                 , ""          , "GL" },
+    { "OTGU"    , "acs_btee"                 , ""          , "GU" },
+    { "OTGD"    , "acs_ttee"                 , ""          , "GD" },
+    { "OTGH"    , "acs_hline"                , ""          , "GH" },
+    { "OTGV"    , "acs_vline"                , ""          , "GV" },
+    { "OTGC"    , "acs_plus"                 , ""          , "GC" },
+    { "meml"    , "memory_lock"              , ""          , "ml" },
+    { "memu"    , "memory_unlock"            , ""          , "mu" },
+    { "box1"    , "box_chars_1"              , ""          , "bx" }
 };
 
 static const char *unibi_x_name_str(enum unibi_string v, int long_name) {
@@ -582,3 +603,103 @@ const char *unibi_name_str(enum unibi_string v) {
 const char *unibi_short_name_str(enum unibi_string v) {
     return unibi_x_name_str(v, 0);
 }
+
+const char *unibi_termcap_name_str(enum unibi_string v) {
+    size_t i;
+    assert(v > unibi_string_begin_ && v < unibi_string_end_);
+    if (v <= unibi_string_begin_ || v >= unibi_string_end_) {
+        return NULL;
+    }
+    i = v - unibi_string_begin_ - 1;
+    return names_str[i][3];
+}
+
+static const char *unibi_x_params_str(enum unibi_string v) {
+    size_t i;
+    assert(v > unibi_string_begin_ && v < unibi_string_end_);
+    if (v <= unibi_string_begin_ || v >= unibi_string_end_) {
+        return "";
+    }
+    i = v - unibi_string_begin_ - 1;
+    return names_str[i][2];
+}
+
+size_t unibi_count_params_str(enum unibi_string v) {
+    return strlen(unibi_x_params_str(v));
+}
+
+enum unibi_param_type unibi_param_type_str(enum unibi_string v, size_t n) {
+    const char *const s = unibi_x_params_str(v);
+    if (n >= strlen(s)) {
+        return unibi_param_none;
+    }
+    return s[n] == 's' ? unibi_param_str : unibi_param_num;
+}
+
+/* must match cap_hash() in tools/gen-cap-hash.c */
+static unsigned long cap_hash(const char *s) {
+    unsigned long h = 2166136261UL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h = (h * 16777619UL) & 0xffffffffUL;
+    }
+    return h;
+}
+
+#include "uninames-hash.c.inc"
+
+static int find_name(
+    const unsigned short *table,
+    const char *name,
+    int termcap,
+    int want,
+    enum unibi_cap_type *type
+) {
+    unsigned long h;
+    unsigned short e;
+
+    for (h = cap_hash(name) % CAP_HASH_SIZE; (e = table[h]); h = (h + 1) % CAP_HASH_SIZE) {
+        const enum unibi_cap_type ty = (enum unibi_cap_type)(e >> 10);
+        const int i = (e & 0x3ff) - 1;
+        int v;
+        const char *s;
+
+        if (want >= 0 && ty != (enum unibi_cap_type)want) {
+            continue;
+        }
+
+        switch (ty) {
+            case unibi_cap_bool:
+                v = unibi_boolean_begin_ + 1 + i;
+                s = termcap ? unibi_termcap_name_bool(v) : unibi_short_name_bool(v);
+                break;
+            case unibi_cap_num:
+                v = unibi_numeric_begin_ + 1 + i;
+                s = termcap ? unibi_termcap_name_num(v) : unibi_short_name_num(v);
+                break;
+            default:
+                v = unibi_string_begin_ + 1 + i;
+                s = termcap ? unibi_termcap_name_str(v) : unibi_short_name_str(v);
+                break;
+        }
+
+        if (strcmp(s, name) == 0) {
+            if (type) {
+                *type = ty;
+            }
+            return v;
+        }
+    }
+
+    return -1;
+}
+
+int unibi_find_cap(const char *name, enum unibi_cap_type *type) {
+    return find_name(cap_hash_table, name, 0, -1, type);
+}
+
+/* ML is the termcap code of both smgl and smglr; the table is built in
+ * capability order, so smgl is found first. */
+int unibi_find_termcap(const char *code, enum unibi_cap_type type) {
+    return find_name(termcap_hash_table, code, 1, type, NULL);
+}
@@ -0,0 +1,1459 @@
+/*
+
+This file is part of unibilium.
+
+Unibilium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Unibilium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "unibilium.h"
+
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MAX31BITS 0x7fffffff
+
+#define NBOOLS (unibi_boolean_end_ - unibi_boolean_begin_ - 1)
+#define NNUMS (unibi_numeric_end_ - unibi_numeric_begin_ - 1)
+#define NSTRS (unibi_string_end_ - unibi_string_begin_ - 1)
+
+/* unibi_from_source() parses each entry into a draft terminal object built
+ * with the public setters. The drafts point into buffers owned by a pool.
+ * The finished draft is then round-tripped through unibi_dump() and
+ * unibi_from_mem(), which gives the result its own copy of everything. */
+
+struct chunk {
+    struct chunk *next;
+    unibi_term *term;
+};
+
+struct pool {
+    struct chunk *head;
+};
+
+static void *pool_alloc(struct pool *pl, size_t n) {
+    struct chunk *c;
+    if (!(c = malloc(sizeof *c + n))) {
+        return NULL;
+    }
+    c->next = pl->head;
+    c->term = NULL;
+    pl->head = c;
+    return c + 1;
+}
+
+static int pool_add_term(struct pool *pl, unibi_term *t) {
+    struct chunk *c;
+    if (!(c = malloc(sizeof *c))) {
+        return -1;
+    }
+    c->next = pl->head;
+    c->term = t;
+    pl->head = c;
+    return 0;
+}
+
+static void pool_free(struct pool *pl) {
+    while (pl->head) {
+        struct chunk *const c = pl->head;
+        pl->head = c->next;
+        if (c->term) {
+            unibi_destroy(c->term);
+        }
+        free(c);
+    }
+}
+
+struct entry {
+    const char *begin, *end;
+};
+
+struct parser {
+    struct entry *entries;
+    size_t count;
+    const unibi_term **built;
+    unsigned char *busy;
+    const unibi_term *(*resolve)(void *, const char *);
+    void *ctx;
+    struct pool pool;
+};
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Entries start at the beginning of a line; continuation lines are indented.
+ * Lines starting with '#' are comments. */
+static struct entry *split_entries(const char *text, size_t len, size_t *pcount) {
+    struct entry *entries = NULL;
+    size_t count = 0, size = 0;
+    const char *p = text, *const end = text + len;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        const char *q;
+        eol = eol ? eol + 1 : end;
+
+        for (q = p; q < eol && is_space(*q); q++) {
+        }
+
+        if (q < eol && *p != '#' && !is_space(*p)) {
+            if (count == size) {
+                struct entry *ne;
+                size = size * 3 / 2 + 5;
+                if (!(ne = realloc(entries, size * sizeof *ne))) {
+                    free(entries);
+                    return NULL;
+                }
+                entries = ne;
+            }
+            if (count) {
+                entries[count - 1].end = p;
+            }
+            entries[count].begin = p;
+            entries[count].end = end;
+            count++;
+        }
+
+        p = eol;
+    }
+
+    *pcount = count;
+    if (!count) {
+        errno = EINVAL;
+    }
+    return entries;
+}
+
+/* skips whitespace and comment lines between fields */
+static const char *skip_space(const char *p, const char *end) {
+    int bol = 0;
+    while (p < end) {
+        if (*p == '\n') {
+            bol = 1;
+            p++;
+        } else if (is_space(*p)) {
+            p++;
+        } else if (bol && *p == '#') {
+            while (p < end && *p != '\n') {
+                p++;
+            }
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+/* end of the field starting at p: the next unescaped ',' */
+static const char *field_end(const char *p, const char *end) {
+    while (p < end && *p != ',') {
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        p++;
+    }
+    return p;
+}
+
+static const char *names_end(const struct entry *e) {
+    return field_end(e->begin, e->end);
+}
+
+static int has_name(const struct entry *e, const char *name) {
+    const size_t n = strlen(name);
+    const char *p = e->begin, *const end = names_end(e);
+
+    while (p < end) {
+        const char *bar = memchr(p, '|', end - p);
+        if (!bar) {
+            bar = end;
+        }
+        if ((size_t)(bar - p) == n && memcmp(p, name, n) == 0) {
+            return 1;
+        }
+        p = bar + 1;
+    }
+    return 0;
+}
+
+static char *decode_str(char *d, const char *p, const char *end) {
+    while (p < end) {
+        char c = *p++;
+        if (c == '\\' && p < end) {
+            c = *p++;
+            switch (c) {
+                case 'E': case 'e': c = '\033'; break;
+                case 'n': case 'l': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 's': c = ' '; break;
+                case 'a': c = '\a'; break;
+                case '0': case '1': case '2': case '3':
+                case '4': case '5': case '6': case '7': {
+                    unsigned v = c - '0';
+                    int k;
+                    for (k = 1; k < 3 && p < end && *p >= '0' && *p <= '7'; k++) {
+                        v = v * 8 + (*p++ - '0');
+                    }
+                    /* NUL can't be stored in a C string; terminfo uses \200 */
+                    c = (char)(v & 0xff ? v & 0xff : 0200);
+                    break;
+                }
+                default:
+                    break;
+            }
+        } else if (c == '^' && p < end) {
+            c = *p++;
+            c = c == '?' ? '\177' : (char)(c & 037);
+            if (!c) {
+                c = (char)0200;
+            }
+        }
+        *d++ = c;
+    }
+    *d++ = '\0';
+    return d;
+}
+
+static int parse_num(const char *p, const char *end, int *pv) {
+    unsigned long v = 0;
+    unsigned base = 10;
+
+    if (p == end) {
+        return -1;
+    }
+    if (*p == '0') {
+        base = 8;
+        if (end - p > 1 && (p[1] == 'x' || p[1] == 'X')) {
+            base = 16;
+            p += 2;
+            if (p == end) {
+                return -1;
+            }
+        }
+    }
+
+    for (; p < end; p++) {
+        unsigned d;
+        if (*p >= '0' && *p <= '9') {
+            d = *p - '0';
+        } else if (*p >= 'a' && *p <= 'f') {
+            d = *p - 'a' + 10;
+        } else if (*p >= 'A' && *p <= 'F') {
+            d = *p - 'A' + 10;
+        } else {
+            return -1;
+        }
+        if (d >= base) {
+            return -1;
+        }
+        v = v * base + d;
+        if (v > MAX31BITS) {
+            return -1;
+        }
+    }
+
+    *pv = (int)v;
+    return 0;
+}
+
+static int has_ext(const unibi_term *t, const char *name) {
+    size_t i, n;
+    for (i = 0, n = unibi_count_ext_bool(t); i < n; i++) {
+        if (strcmp(unibi_get_ext_bool_name(t, i), name) == 0) {
+            return 1;
+        }
+    }
+    for (i = 0, n = unibi_count_ext_num(t); i < n; i++) {
+        if (strcmp(unibi_get_ext_num_name(t, i), name) == 0) {
+            return 1;
+        }
+    }
+    for (i = 0, n = unibi_count_ext_str(t); i < n; i++) {
+        if (strcmp(unibi_get_ext_str_name(t, i), name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int in_list(const char *const *list, size_t n, const char *name) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (strcmp(list[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Which standard capabilities the entry has decided on (set or cancelled),
+ * plus the extended capabilities it cancelled. */
+struct seen {
+    unsigned char bools[NBOOLS];
+    unsigned char nums[NNUMS];
+    unsigned char strs[NSTRS];
+    const char **ext_cancel;
+    size_t n_ext_cancel;
+};
+
+static int merge(unibi_term *t, const unibi_term *u, struct seen *sn) {
+    size_t i, n;
+
+    for (i = 0; i < NBOOLS; i++) {
+        const enum unibi_boolean v = unibi_boolean_begin_ + 1 + i;
+        if (!sn->bools[i] && unibi_get_bool(u, v)) {
+            unibi_set_bool(t, v, 1);
+            sn->bools[i] = 1;
+        }
+    }
+    for (i = 0; i < NNUMS; i++) {
+        const enum unibi_numeric v = unibi_numeric_begin_ + 1 + i;
+        if (!sn->nums[i] && unibi_get_num(u, v) >= 0) {
+            unibi_set_num(t, v, unibi_get_num(u, v));
+            sn->nums[i] = 1;
+        }
+    }
+    for (i = 0; i < NSTRS; i++) {
+        const enum unibi_string v = unibi_string_begin_ + 1 + i;
+        if (!sn->strs[i] && unibi_get_str(u, v)) {
+            unibi_set_str(t, v, unibi_get_str(u, v));
+            sn->strs[i] = 1;
+        }
+    }
+
+#define MERGE_EXT(T, ADD) \
+    for (i = 0, n = unibi_count_ext_ ## T(u); i < n; i++) { \
+        const char *const name = unibi_get_ext_ ## T ## _name(u, i); \
+        if ( \
+            !in_list(sn->ext_cancel, sn->n_ext_cancel, name) && \
+            !has_ext(t, name) && \
+            ADD(t, name, unibi_get_ext_ ## T(u, i)) == (size_t)-1 \
+        ) { \
+            return -1; \
+        } \
+    }
+
+    MERGE_EXT(bool, unibi_add_ext_bool)
+    MERGE_EXT(num, unibi_add_ext_num)
+    MERGE_EXT(str, unibi_add_ext_str)
+
+#undef MERGE_EXT
+
+    return 0;
+}
+
+static const unibi_term *build_entry(struct parser *ps, size_t k);
+
+static const unibi_term *resolve_use(struct parser *ps, const char *name) {
+    size_t i;
+    unibi_term *t;
+
+    for (i = 0; i < ps->count; i++) {
+        if (has_name(&ps->entries[i], name)) {
+            return build_entry(ps, i);
+        }
+    }
+
+    errno = 0;
+    if (ps->resolve) {
+        const unibi_term *const r = ps->resolve(ps->ctx, name);
+        if (!r && !errno) {
+            errno = ENOENT;
+        }
+        return r;
+    }
+
+    if (!(t = unibi_from_term(name))) {
+        return NULL;
+    }
+    if (pool_add_term(&ps->pool, t) < 0) {
+        unibi_destroy(t);
+        return NULL;
+    }
+    return t;
+}
+
+#define FAIL(e) do { errno = (e); return NULL; } while (0)
+
+static const unibi_term *build_entry(struct parser *ps, size_t k) {
+    const struct entry *const e = &ps->entries[k];
+    const char *p, *q, *end;
+    const char **aliases, **uses;
+    size_t nfields, naliases, nuses, i;
+    struct seen sn;
+    unibi_term *t;
+    char *buf, *d;
+
+    if (ps->built[k]) {
+        return ps->built[k];
+    }
+    if (ps->busy[k]) {
+        FAIL(ELOOP);
+    }
+
+    if (!(t = unibi_dummy())) {
+        return NULL;
+    }
+    if (pool_add_term(&ps->pool, t) < 0) {
+        unibi_destroy(t);
+        return NULL;
+    }
+
+    /* decoded text is never longer than the source, plus one '\0' per field */
+    nfields = 1;
+    for (p = e->begin; p < e->end; p++) {
+        nfields += *p == ',' || *p == '|';
+    }
+    if (
+        !(buf = pool_alloc(&ps->pool, (size_t)(e->end - e->begin) + nfields)) ||
+        !(aliases = pool_alloc(&ps->pool, (nfields + 1) * sizeof *aliases)) ||
+        !(uses = pool_alloc(&ps->pool, nfields * sizeof *uses)) ||
+        !(sn.ext_cancel = pool_alloc(&ps->pool, nfields * sizeof *sn.ext_cancel))
+    ) {
+        return NULL;
+    }
+    memset(sn.bools, 0, sizeof sn.bools);
+    memset(sn.nums, 0, sizeof sn.nums);
+    memset(sn.strs, 0, sizeof sn.strs);
+    sn.n_ext_cancel = 0;
+    nuses = 0;
+    d = buf;
+
+    /* names: "alias|alias|long name"; a single name is just the name */
+    end = names_end(e);
+    if (end == e->begin) {
+        FAIL(EINVAL);
+    }
+    naliases = 0;
+    for (p = e->begin; ; p = q + 1) {
+        q = memchr(p, '|', end - p);
+        if (!q) {
+            q = end;
+        }
+        memcpy(d, p, q - p);
+        d[q - p] = '\0';
+        aliases[naliases++] = d;
+        d += q - p + 1;
+        if (q == end) {
+            break;
+        }
+    }
+    unibi_set_name(t, aliases[--naliases]);
+    aliases[naliases] = NULL;
+    unibi_set_aliases(t, aliases);
+
+    for (p = end; p < e->end; p = q) {
+        const char *name, *op;
+        enum unibi_cap_type type;
+        int v;
+
+        p = skip_space(p + 1, e->end);
+        if (p >= e->end) {
+            break;
+        }
+        q = field_end(p, e->end);
+        end = q;
+        while (end > p && is_space(end[-1])) {
+            end--;
+        }
+        if (end == p) {
+            continue;
+        }
+
+        for (op = p; op < end && *op != '=' && *op != '#' && *op != '@'; op++) {
+        }
+        if (op == p) {
+            FAIL(EINVAL);
+        }
+        memcpy(d, p, op - p);
+        d[op - p] = '\0';
+        name = d;
+        d += op - p + 1;
+
+        if (strcmp(name, "use") == 0) {
+            if (op == end || *op != '=') {
+                FAIL(EINVAL);
+            }
+            memcpy(d, op + 1, end - op - 1);
+            d[end - op - 1] = '\0';
+            uses[nuses++] = d;
+            d += end - op;
+            continue;
+        }
+
+        if (op < end && *op == '@' && op + 1 != end) {
+            FAIL(EINVAL);
+        }
+
+        v = unibi_find_cap(name, &type);
+        if (v < 0) {
+            if (has_ext(t, name) || in_list(sn.ext_cancel, sn.n_ext_cancel, name)) {
+                continue;
+            }
+            if (op == end) {
+                if (unibi_add_ext_bool(t, name, 1) == (size_t)-1) {
+                    return NULL;
+                }
+            } else if (*op == '@') {
+                sn.ext_cancel[sn.n_ext_cancel++] = name;
+            } else if (*op == '#') {
+                int x;
+                if (parse_num(op + 1, end, &x) < 0) {
+                    FAIL(EINVAL);
+                }
+                if (unibi_add_ext_num(t, name, x) == (size_t)-1) {
+                    return NULL;
+                }
+            } else {
+                const char *const s = d;
+                d = decode_str(d, op + 1, end);
+                if (unibi_add_ext_str(t, name, s) == (size_t)-1) {
+                    return NULL;
+                }
+            }
+            continue;
+        }
+
+        switch (type) {
+            case unibi_cap_bool:
+                if (op < end && *op != '@') {
+                    FAIL(EINVAL);
+                }
+                i = v - unibi_boolean_begin_ - 1;
+                if (!sn.bools[i]) {
+                    sn.bools[i] = 1;
+                    unibi_set_bool(t, v, op == end);
+                }
+                break;
+
+            case unibi_cap_num:
+                if (op == end || *op == '=') {
+                    FAIL(EINVAL);
+                }
+                i = v - unibi_numeric_begin_ - 1;
+                if (!sn.nums[i]) {
+                    int x = -1;
+                    if (*op == '#' && parse_num(op + 1, end, &x) < 0) {
+                        FAIL(EINVAL);
+                    }
+                    sn.nums[i] = 1;
+                    unibi_set_num(t, v, x);
+                }
+                break;
+
+            case unibi_cap_str:
+                if (op == end || *op == '#') {
+                    FAIL(EINVAL);
+                }
+                i = v - unibi_string_begin_ - 1;
+                if (!sn.strs[i]) {
+                    sn.strs[i] = 1;
+                    if (*op == '=') {
+                        const char *const s = d;
+                        d = decode_str(d, op + 1, end);
+                        unibi_set_str(t, v, s);
+                    }
+                }
+                break;
+        }
+    }
+
+    assert(d <= buf + (e->end - e->begin) + nfields);
+
+    /* capabilities in the entry override inherited ones; earlier use=
+     * entries override later ones */
+    ps->busy[k] = 1;
+    for (i = 0; i < nuses; i++) {
+        const unibi_term *const u = resolve_use(ps, uses[i]);
+        if (!u || merge(t, u, &sn) < 0) {
+            ps->busy[k] = 0;
+            return NULL;
+        }
+    }
+    ps->busy[k] = 0;
+
+    ps->built[k] = t;
+    return t;
+}
+
+#undef FAIL
+
+/* gives a finished draft its own copy of everything */
+static unibi_term *copy_draft(const unibi_term *draft) {
+    unibi_term *t;
+    size_t n;
+    char *out;
+
+    n = unibi_dump(draft, NULL, 0);
+    if (n == (size_t)-1 || !(out = malloc(n))) {
+        return NULL;
+    }
+    unibi_dump(draft, out, n);
+    t = unibi_from_mem(out, n);
+    free(out);
+    return t;
+}
+
+unibi_term *unibi_from_source(
+    const char *text,
+    size_t len,
+    const unibi_term *(*resolve)(void *, const char *),
+    void *ctx
+) {
+    struct parser ps;
+    const unibi_term *draft;
+    unibi_term *t = NULL;
+    int e;
+
+    if (!(ps.entries = split_entries(text, len, &ps.count))) {
+        return NULL;
+    }
+    ps.built = calloc(ps.count, sizeof *ps.built);
+    ps.busy = calloc(ps.count, 1);
+    ps.resolve = resolve;
+    ps.ctx = ctx;
+    ps.pool.head = NULL;
+
+    if (ps.built && ps.busy && (draft = build_entry(&ps, 0))) {
+        t = copy_draft(draft);
+    }
+
+    e = errno;
+    pool_free(&ps.pool);
+    free(ps.busy);
+    free(ps.built);
+    free(ps.entries);
+    errno = e;
+    return t;
+}
+
+/* Termcap databases. unibi_termcap_from_mem() copies the text, splits it into
+ * entries and hashes every entry name once, so unibi_termcap_get() only
+ * parses the entry it is asked for and whatever that entry pulls in with tc=.
+ * Entries are turned into drafts like terminfo source, with termcap codes
+ * mapped to capabilities and termcap % codes rewritten as terminfo ones. */
+
+struct tc_slot {
+    const char *name;
+    size_t len;
+    size_t entry;
+};
+
+struct unibi_termcap {
+    char *text;
+    struct entry *entries;
+    size_t count;
+    struct tc_slot *slots;
+    size_t nslots;
+};
+
+static unsigned long name_hash(const char *s, size_t n) {
+    unsigned long h = 2166136261UL;
+    while (n--) {
+        h ^= (unsigned char)*s++;
+        h = (h * 16777619UL) & 0xffffffffUL;
+    }
+    return h;
+}
+
+static int is_blank_line(const char *p, const char *eol) {
+    for (; p < eol; p++) {
+        if (!is_space(*p)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* An entry is a line that doesn't start with '#' or whitespace, plus any
+ * lines joined to it by a trailing backslash or indentation. */
+static struct entry *tc_split_entries(const char *text, size_t len, size_t *pcount) {
+    struct entry *entries = NULL;
+    size_t count = 0, size = 0;
+    const char *p = text, *const end = text + len;
+    int open = 0, cont = 0;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p), *next, *le;
+        next = eol ? eol + 1 : end;
+        le = eol ? eol : end;
+        if (le > p && le[-1] == '\r') {
+            le--;
+        }
+
+        if (open && (cont || (is_space(*p) && !is_blank_line(p, le)))) {
+            entries[count - 1].end = next;
+        } else if (*p != '#' && !is_space(*p)) {
+            if (count == size) {
+                struct entry *ne;
+                size = size * 3 / 2 + 5;
+                if (!(ne = realloc(entries, size * sizeof *ne))) {
+                    free(entries);
+                    return NULL;
+                }
+                entries = ne;
+            }
+            entries[count].begin = p;
+            entries[count].end = next;
+            count++;
+            open = 1;
+        } else {
+            open = 0;
+        }
+        cont = open && le > p && le[-1] == '\\';
+
+        p = next;
+    }
+
+    *pcount = count;
+    if (!count) {
+        errno = EINVAL;
+    }
+    return entries;
+}
+
+static const char *tc_names_end(const struct entry *e) {
+    const char *p = e->begin;
+    while (p < e->end && *p != ':' && *p != '\n' && *p != '\r' && *p != '\\') {
+        p++;
+    }
+    return p;
+}
+
+static int tc_index(unibi_termcap *tc) {
+    size_t i, n = 0;
+
+    for (i = 0; i < tc->count; i++) {
+        const char *p, *const end = tc_names_end(&tc->entries[i]);
+        for (p = tc->entries[i].begin, n++; p < end; p++) {
+            n += *p == '|';
+        }
+    }
+
+    for (tc->nslots = 16; tc->nslots < n * 2; tc->nslots *= 2) {
+    }
+    if (!(tc->slots = calloc(tc->nslots, sizeof *tc->slots))) {
+        return -1;
+    }
+
+    for (i = 0; i < tc->count; i++) {
+        const char *p = tc->entries[i].begin, *const end = tc_names_end(&tc->entries[i]);
+        for (;;) {
+            const char *bar = memchr(p, '|', end - p);
+            unsigned long h;
+            if (!bar) {
+                bar = end;
+            }
+            for (h = name_hash(p, bar - p) & (tc->nslots - 1); tc->slots[h].name; h = (h + 1) & (tc->nslots - 1)) {
+            }
+            tc->slots[h].name = p;
+            tc->slots[h].len = bar - p;
+            tc->slots[h].entry = i;
+            if (bar == end) {
+                break;
+            }
+            p = bar + 1;
+        }
+    }
+
+    return 0;
+}
+
+/* earlier entries win if several share a name */
+static const struct entry *tc_lookup(const unibi_termcap *tc, const char *name) {
+    const size_t n = strlen(name);
+    const struct entry *found = NULL;
+    unsigned long h;
+
+    for (h = name_hash(name, n) & (tc->nslots - 1); tc->slots[h].name; h = (h + 1) & (tc->nslots - 1)) {
+        const struct tc_slot *const sl = &tc->slots[h];
+        if (sl->len == n && memcmp(sl->name, name, n) == 0 && (!found || &tc->entries[sl->entry] < found)) {
+            found = &tc->entries[sl->entry];
+        }
+    }
+    return found;
+}
+
+unibi_termcap *unibi_termcap_from_mem(const char *text, size_t len) {
+    unibi_termcap *tc;
+    int e;
+
+    if (!(tc = malloc(sizeof *tc))) {
+        return NULL;
+    }
+    tc->entries = NULL;
+    tc->slots = NULL;
+
+    if ((tc->text = malloc(len ? len : 1))) {
+        memcpy(tc->text, text, len);
+        if ((tc->entries = tc_split_entries(tc->text, len, &tc->count)) && tc_index(tc) == 0) {
+            return tc;
+        }
+    }
+
+    e = errno;
+    unibi_termcap_destroy(tc);
+    errno = e;
+    return NULL;
+}
+
+void unibi_termcap_destroy(unibi_termcap *tc) {
+    if (!tc) {
+        return;
+    }
+    free(tc->slots);
+    free(tc->entries);
+    free(tc->text);
+    free(tc);
+}
+
+/* entry text with line continuations removed */
+static char *tc_join(char *d, const char *p, const char *end) {
+    while (p < end) {
+        if (*p == '\\' && p + 1 < end && (p[1] == '\n' || p[1] == '\r')) {
+            p++;
+        } else if (*p == '\\' && p + 1 < end) {
+            *d++ = *p++;
+            *d++ = *p++;
+            continue;
+        } else if (*p != '\n' && *p != '\r') {
+            *d++ = *p++;
+            continue;
+        }
+        while (p < end && is_space(*p)) {
+            p++;
+        }
+    }
+    return d;
+}
+
+/* end of the field starting at p: the next unescaped ':' */
+static const char *tc_field_end(const char *p, const char *end) {
+    while (p < end && *p != ':') {
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        p++;
+    }
+    return p;
+}
+
+static char *put_cstr(char *d, const char *s) {
+    while (*s) {
+        *d++ = *s++;
+    }
+    return d;
+}
+
+static char *put_uint(char *d, unsigned v) {
+    char tmp[16];
+    size_t i = sizeof tmp;
+    do {
+        tmp[--i] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    memcpy(d, tmp + i, sizeof tmp - i);
+    return d + (sizeof tmp - i);
+}
+
+static char *put_const(char *d, unsigned char c) {
+    d = put_cstr(d, "%{");
+    d = put_uint(d, c);
+    return put_cstr(d, "}");
+}
+
+/* Room needed by tc_convert() for a decoded string of n bytes: "%B" is the
+ * longest expansion at 35 bytes for 2. */
+#define TC_CONVERT_SIZE(n) ((n) * 18 + 1)
+
+/* Rewrites termcap % codes as terminfo. Every output code consumes the next
+ * parameter, and %r swaps the first two; %>, %B and %D modify the parameter
+ * about to be output, so it is kept on the stack (and in variable a) until
+ * then. Returns NULL if the string needs more than 9 parameters. */
+static char *tc_convert(char *d, const char *s) {
+    unsigned n = 0;
+    int swap = 0, pushed = 0;
+
+    for (; *s; s++) {
+        if (*s != '%') {
+            *d++ = *s;
+            continue;
+        }
+
+        switch (*++s) {
+            case 'd': case '2': case '3': case '.': case '+':
+            case '>': case 'B': case 'D':
+                if (!pushed) {
+                    unsigned k = n + 1;
+                    if (swap && k <= 2) {
+                        k = 3 - k;
+                    }
+                    if (k > 9) {
+                        errno = EINVAL;
+                        return NULL;
+                    }
+                    d = put_cstr(d, "%p");
+                    *d++ = (char)('0' + k);
+                    pushed = 1;
+                }
+                break;
+        }
+
+        switch (*s) {
+            case 'd': d = put_cstr(d, "%d"); break;
+            case '2': d = put_cstr(d, "%2d"); break;
+            case '3': d = put_cstr(d, "%3d"); break;
+            case '.': d = put_cstr(d, "%c"); break;
+            case '+':
+                if (!s[1]) {
+                    d = put_cstr(d, "%c");
+                    break;
+                }
+                d = put_const(d, (unsigned char)*++s);
+                d = put_cstr(d, "%+%c");
+                break;
+            case '>':
+                if (!s[1] || !s[2]) {
+                    errno = EINVAL;
+                    return NULL;
+                }
+                d = put_cstr(d, "%Pa%?%ga");
+                d = put_const(d, (unsigned char)*++s);
+                d = put_cstr(d, "%>%t%ga");
+                d = put_const(d, (unsigned char)*++s);
+                d = put_cstr(d, "%+%e%ga%;");
+                continue;
+            case 'B': d = put_cstr(d, "%Pa%ga%{10}%/%{16}%*%ga%{10}%m%+"); continue;
+            case 'D': d = put_cstr(d, "%Pa%ga%ga%{16}%m%{2}%*%-"); continue;
+            case 'r': swap = 1; continue;
+            case 'i': d = put_cstr(d, "%i"); continue;
+            case '\0':
+                d = put_cstr(d, "%%");
+                s--;
+                continue;
+            default:
+                /* %% and unknown codes are copied as text */
+                d = put_cstr(d, "%%");
+                if (*s != '%') {
+                    *d++ = *s;
+                }
+                continue;
+        }
+
+        pushed = 0;
+        n++;
+    }
+
+    *d++ = '\0';
+    return d;
+}
+
+/* Decodes a termcap string value: leading padding ("20", "3.5*") becomes a
+ * trailing "$<...>", escapes are the ones shared with terminfo plus "\:". */
+static const char *tc_decode(struct pool *pl, const char *p, const char *end) {
+    const char *pad = p, *pad_end;
+    char *tmp, *out, *d;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (p > pad && p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+        }
+    }
+    if (p > pad && p < end && *p == '*') {
+        p++;
+    }
+    pad_end = p;
+
+    if (
+        !(tmp = pool_alloc(pl, (size_t)(end - p) + 1)) ||
+        !(out = pool_alloc(pl, TC_CONVERT_SIZE((size_t)(end - p)) + (size_t)(pad_end - pad) + 3))
+    ) {
+        return NULL;
+    }
+    decode_str(tmp, p, end);
+    if (!(d = tc_convert(out, tmp))) {
+        return NULL;
+    }
+    if (pad_end > pad) {
+        d--;
+        d = put_cstr(d, "$<");
+        memcpy(d, pad, pad_end - pad);
+        d += pad_end - pad;
+        d = put_cstr(d, ">");
+        *d = '\0';
+    }
+    return out;
+}
+
+struct tc_parser {
+    const unibi_termcap *tc;
+    const struct entry *chain[32];
+    size_t depth;
+    struct pool pool;
+};
+
+#define FAIL(e) do { errno = (e); return NULL; } while (0)
+
+static unibi_term *tc_build_entry(struct tc_parser *ps, const struct entry *e) {
+    const char *p, *q, *end;
+    const char **aliases, **uses;
+    size_t nfields, naliases, nuses, i;
+    struct seen sn;
+    unibi_term *t;
+    char *buf, *d;
+
+    for (i = 0; i < ps->depth; i++) {
+        if (ps->chain[i] == e) {
+            FAIL(ELOOP);
+        }
+    }
+    if (ps->depth == sizeof ps->chain / sizeof ps->chain[0]) {
+        FAIL(ELOOP);
+    }
+
+    if (!(t = unibi_dummy())) {
+        return NULL;
+    }
+    if (pool_add_term(&ps->pool, t) < 0) {
+        unibi_destroy(t);
+        return NULL;
+    }
+
+    nfields = 1;
+    for (p = e->begin; p < e->end; p++) {
+        nfields += *p == ':' || *p == '|';
+    }
+    if (
+        !(buf = pool_alloc(&ps->pool, 2 * (size_t)(e->end - e->begin) + nfields)) ||
+        !(aliases = pool_alloc(&ps->pool, (nfields + 1) * sizeof *aliases)) ||
+        !(uses = pool_alloc(&ps->pool, nfields * sizeof *uses)) ||
+        !(sn.ext_cancel = pool_alloc(&ps->pool, nfields * sizeof *sn.ext_cancel))
+    ) {
+        return NULL;
+    }
+    memset(sn.bools, 0, sizeof sn.bools);
+    memset(sn.nums, 0, sizeof sn.nums);
+    memset(sn.strs, 0, sizeof sn.strs);
+    sn.n_ext_cancel = 0;
+    nuses = 0;
+
+    /* the joined text goes in the first half of buf, names and codes in the
+     * second */
+    end = tc_join(buf, e->begin, e->end);
+    d = buf + (e->end - e->begin);
+
+    /* names: "xx|alias|long name"; a single name is just the name */
+    q = tc_field_end(buf, end);
+    if (q == buf) {
+        FAIL(EINVAL);
+    }
+    naliases = 0;
+    for (p = buf; ; p++) {
+        const char *bar = memchr(p, '|', q - p);
+        if (!bar) {
+            bar = q;
+        }
+        memcpy(d, p, bar - p);
+        d[bar - p] = '\0';
+        aliases[naliases++] = d;
+        d += bar - p + 1;
+        p = bar;
+        if (bar == q) {
+            break;
+        }
+    }
+    unibi_set_name(t, aliases[--naliases]);
+    aliases[naliases] = NULL;
+    unibi_set_aliases(t, aliases);
+
+    for (p = q; p < end; p = q) {
+        const char *name, *op, *fend;
+        int v = -1, x;
+
+        p++;
+        q = tc_field_end(p, end);
+        while (p < q && is_space(*p)) {
+            p++;
+        }
+        for (op = p; op < q && *op != '=' && *op != '#' && *op != '@'; op++) {
+        }
+        /* trailing blanks are only significant in strings */
+        fend = q;
+        if (op == q || *op != '=') {
+            while (fend > p && is_space(fend[-1])) {
+                fend--;
+            }
+            if (op > fend) {
+                op = fend;
+            }
+        }
+        /* a leading '.' comments out a capability */
+        if (op == p || *p == '.') {
+            continue;
+        }
+        memcpy(d, p, op - p);
+        d[op - p] = '\0';
+        name = d;
+        d += op - p + 1;
+
+        if (op == fend) {
+            if ((v = unibi_find_termcap(name, unibi_cap_bool)) >= 0) {
+                i = v - unibi_boolean_begin_ - 1;
+                if (!sn.bools[i]) {
+                    sn.bools[i] = 1;
+                    unibi_set_bool(t, v, 1);
+                }
+            } else if (
+                !has_ext(t, name) && !in_list(sn.ext_cancel, sn.n_ext_cancel, name) &&
+                unibi_add_ext_bool(t, name, 1) == (size_t)-1
+            ) {
+                return NULL;
+            }
+        } else if (*op == '@') {
+            if ((v = unibi_find_termcap(name, unibi_cap_bool)) >= 0) {
+                sn.bools[v - unibi_boolean_begin_ - 1] = 1;
+            }
+            if ((x = unibi_find_termcap(name, unibi_cap_num)) >= 0) {
+                sn.nums[x - unibi_numeric_begin_ - 1] = 1;
+                v = x;
+            }
+            if ((x = unibi_find_termcap(name, unibi_cap_str)) >= 0) {
+                sn.strs[x - unibi_string_begin_ - 1] = 1;
+                v = x;
+            }
+            if (v < 0) {
+                sn.ext_cancel[sn.n_ext_cancel++] = name;
+            }
+        } else if (*op == '#') {
+            /* numbers are decimal, or octal with a leading 0 */
+            if (parse_num(op + 1, fend, &x) < 0) {
+                FAIL(EINVAL);
+            }
+            if ((v = unibi_find_termcap(name, unibi_cap_num)) >= 0) {
+                i = v - unibi_numeric_begin_ - 1;
+                if (!sn.nums[i]) {
+                    sn.nums[i] = 1;
+                    unibi_set_num(t, v, x);
+                }
+            } else if (
+                !has_ext(t, name) && !in_list(sn.ext_cancel, sn.n_ext_cancel, name) &&
+                unibi_add_ext_num(t, name, x) == (size_t)-1
+            ) {
+                return NULL;
+            }
+        } else if (strcmp(name, "tc") == 0) {
+            memcpy(d, op + 1, fend - op - 1);
+            d[fend - op - 1] = '\0';
+            uses[nuses++] = d;
+            d += fend - op;
+        } else {
+            const char *s;
+            v = unibi_find_termcap(name, unibi_cap_str);
+            if (v >= 0 ? sn.strs[v - unibi_string_begin_ - 1] : has_ext(t, name) || in_list(sn.ext_cancel, sn.n_ext_cancel, name)) {
+                continue;
+            }
+            if (!(s = tc_decode(&ps->pool, op + 1, fend))) {
+                return NULL;
+            }
+            if (v >= 0) {
+                sn.strs[v - unibi_string_begin_ - 1] = 1;
+                unibi_set_str(t, v, s);
+            } else if (unibi_add_ext_str(t, name, s) == (size_t)-1) {
+                return NULL;
+            }
+        }
+    }
+
+    assert(d <= buf + 2 * (e->end - e->begin) + nfields);
+
+    /* like use= in terminfo, but tc= conventionally comes last */
+    ps->chain[ps->depth++] = e;
+    for (i = 0; i < nuses; i++) {
+        const struct entry *const u = tc_lookup(ps->tc, uses[i]);
+        const unibi_term *ut;
+        if (!u) {
+            ps->depth--;
+            FAIL(ENOENT);
+        }
+        if (!(ut = tc_build_entry(ps, u)) || merge(t, ut, &sn) < 0) {
+            ps->depth--;
+            return NULL;
+        }
+    }
+    ps->depth--;
+
+    return t;
+}
+
+#undef FAIL
+
+/* old termcap capabilities that stand in for terminfo strings */
+static void tc_fixup(unibi_term *t) {
+    if (!unibi_get_str(t, unibi_cursor_left)) {
+        if (unibi_get_str(t, unibi_backspace_if_not_bs)) {
+            unibi_set_str(t, unibi_cursor_left, unibi_get_str(t, unibi_backspace_if_not_bs));
+        } else if (unibi_get_bool(t, unibi_backspaces_with_bs)) {
+            unibi_set_str(t, unibi_cursor_left, "\b");
+        }
+    }
+    if (!unibi_get_str(t, unibi_tab) && unibi_get_bool(t, unibi_has_hardware_tabs)) {
+        unibi_set_str(t, unibi_tab, "\t");
+    }
+    if (!unibi_get_str(t, unibi_reset_2string)) {
+        unibi_set_str(t, unibi_reset_2string, unibi_get_str(t, unibi_termcap_reset));
+    }
+    if (!unibi_get_str(t, unibi_init_3string)) {
+        unibi_set_str(t, unibi_init_3string, unibi_get_str(t, unibi_termcap_init2));
+    }
+}
+
+unibi_term *unibi_termcap_get(const unibi_termcap *tc, const char *name) {
+    struct tc_parser ps;
+    const struct entry *e;
+    unibi_term *draft, *t = NULL;
+    int err;
+
+    if (!(e = tc_lookup(tc, name))) {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    ps.tc = tc;
+    ps.depth = 0;
+    ps.pool.head = NULL;
+
+    if ((draft = tc_build_entry(&ps, e))) {
+        tc_fixup(draft);
+        t = copy_draft(draft);
+    }
+
+    err = errno;
+    pool_free(&ps.pool);
+    errno = err;
+    return t;
+}
+
+size_t unibi_tgoto(const char *cap, int col, int row, char *p, size_t n) {
+    unibi_var_t vars[9] = {{0}};
+    vars[0] = unibi_var_from_num(row);
+    vars[1] = unibi_var_from_num(col);
+    return unibi_run(cap, vars, p, n);
+}
+
+/* unibi_to_source() writes one capability per line, standard capabilities in
+ * table order followed by the extended ones, like "infocmp -1 -sd -x". Output
+ * is collected in a small buffer and handed to the callback in blocks. */
+
+struct src_out {
+    int (*write)(void *, const char *, size_t);
+    void *ctx;
+    int failed;
+    size_t total;
+    size_t used;
+    char buf[512];
+};
+
+static void so_flush(struct src_out *o) {
+    if (o->used && !o->failed && o->write(o->ctx, o->buf, o->used)) {
+        o->failed = 1;
+    }
+    o->used = 0;
+}
+
+static void so_char(struct src_out *o, char c) {
+    if (o->used == sizeof o->buf) {
+        so_flush(o);
+    }
+    o->buf[o->used++] = c;
+    o->total++;
+}
+
+static void so_mem(struct src_out *o, const char *p, size_t n) {
+    while (n) {
+        size_t k;
+        if (o->used == sizeof o->buf) {
+            so_flush(o);
+        }
+        k = sizeof o->buf - o->used;
+        if (k > n) {
+            k = n;
+        }
+        memcpy(o->buf + o->used, p, k);
+        o->used += k;
+        o->total += k;
+        p += k;
+        n -= k;
+    }
+}
+
+static void so_cstr(struct src_out *o, const char *s) {
+    so_mem(o, s, strlen(s));
+}
+
+static void so_num(struct src_out *o, int n) {
+    char tmp[16];
+    size_t i = sizeof tmp;
+    unsigned u = n;
+    assert(n >= 0);
+    do {
+        tmp[--i] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    so_mem(o, tmp + i, sizeof tmp - i);
+}
+
+static void so_str_esc(struct src_out *o, const char *s) {
+    const char *const s0 = s;
+    for (; *s; s++) {
+        const unsigned char c = *s;
+        switch (c) {
+            case '\033': so_mem(o, "\\E", 2); break;
+            case '\n': so_mem(o, "\\n", 2); break;
+            case '\r': so_mem(o, "\\r", 2); break;
+            case '\t': so_mem(o, "\\t", 2); break;
+            case '\b': so_mem(o, "\\b", 2); break;
+            case '\f': so_mem(o, "\\f", 2); break;
+            case ' ':
+                /* the parser would drop surrounding blanks */
+                if (s == s0 || !s[1]) {
+                    so_mem(o, "\\s", 2);
+                } else {
+                    so_char(o, ' ');
+                }
+                break;
+            case '\\': so_mem(o, "\\\\", 2); break;
+            case ',': so_mem(o, "\\,", 2); break;
+            case '^': so_mem(o, "\\^", 2); break;
+            case '\177': so_mem(o, "^?", 2); break;
+            default:
+                if (c < 32) {
+                    so_char(o, '^');
+                    so_char(o, (char)(c + '@'));
+                } else if (c < 127) {
+                    so_char(o, (char)c);
+                } else {
+                    so_char(o, '\\');
+                    so_char(o, (char)('0' + (c >> 6)));
+                    so_char(o, (char)('0' + (c >> 3 & 7)));
+                    so_char(o, (char)('0' + (c & 7)));
+                }
+                break;
+        }
+    }
+}
+
+size_t unibi_escape_str(const char *s, int (*write)(void *, const char *, size_t), void *ctx) {
+    struct src_out o;
+
+    o.write = write;
+    o.ctx = ctx;
+    o.failed = 0;
+    o.total = 0;
+    o.used = 0;
+
+    so_str_esc(&o, s);
+    so_flush(&o);
+
+    return o.failed ? (size_t)-1 : o.total;
+}
+
+static void so_cap(struct src_out *o, const char *name, char op) {
+    so_char(o, '\t');
+    so_cstr(o, name);
+    if (op) {
+        so_char(o, op);
+    }
+}
+
+static void so_end_cap(struct src_out *o) {
+    so_mem(o, ",\n", 2);
+}
+
+size_t unibi_to_source(const unibi_term *t, int (*write)(void *, const char *, size_t), void *ctx) {
+    struct src_out o;
+    const char **a;
+    size_t i, n;
+
+    o.write = write;
+    o.ctx = ctx;
+    o.failed = 0;
+    o.total = 0;
+    o.used = 0;
+
+    for (a = unibi_get_aliases(t); *a; a++) {
+        so_cstr(&o, *a);
+        so_char(&o, '|');
+    }
+    so_cstr(&o, unibi_get_name(t));
+    so_mem(&o, ",\n", 2);
+
+    for (i = unibi_boolean_begin_ + 1; i < unibi_boolean_end_; i++) {
+        if (unibi_get_bool(t, i)) {
+            so_cap(&o, unibi_short_name_bool(i), '\0');
+            so_end_cap(&o);
+        }
+    }
+    for (i = 0, n = unibi_count_ext_bool(t); i < n; i++) {
+        if (unibi_get_ext_bool(t, i)) {
+            so_cap(&o, unibi_get_ext_bool_name(t, i), '\0');
+            so_end_cap(&o);
+        }
+    }
+
+    for (i = unibi_numeric_begin_ + 1; i < unibi_numeric_end_; i++) {
+        const int v = unibi_get_num(t, i);
+        if (v >= 0) {
+            so_cap(&o, unibi_short_name_num(i), '#');
+            so_num(&o, v);
+            so_end_cap(&o);
+        }
+    }
+    for (i = 0, n = unibi_count_ext_num(t); i < n; i++) {
+        const int v = unibi_get_ext_num(t, i);
+        if (v >= 0) {
+            so_cap(&o, unibi_get_ext_num_name(t, i), '#');
+            so_num(&o, v);
+            so_end_cap(&o);
+        }
+    }
+
+    for (i = unibi_string_begin_ + 1; i < unibi_string_end_; i++) {
+        const char *const s = unibi_get_str(t, i);
+        if (s) {
+            so_cap(&o, unibi_short_name_str(i), '=');
+            so_str_esc(&o, s);
+            so_end_cap(&o);
+        }
+    }
+    for (i = 0, n = unibi_count_ext_str(t); i < n; i++) {
+        const char *const s = unibi_get_ext_str(t, i);
+        if (s) {
+            so_cap(&o, unibi_get_ext_str_name(t, i), '=');
+            so_str_esc(&o, s);
+            so_end_cap(&o);
+        }
+    }
+
+    so_flush(&o);
+
+    return o.failed ? (size_t)-1 : o.total;
+}
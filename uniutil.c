@@ -19,6 +19,10 @@ along with unibilium.  If not, see <http://www.gnu.org/licenses/>.
 
 */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+# define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "unibilium.h"
 
 #include <stdio.h>
@@ -92,6 +96,48 @@ unibi_term *unibi_from_file(const char *file) {
     return ut;
 }
 
+unibi_termcap *unibi_termcap_from_file(const char *file) {
+    unibi_termcap *tc = NULL;
+    char *buf = NULL;
+    size_t n = 0, size = 0;
+    ssize_t r;
+    int fd, e;
+
+    if ((fd = open(file, O_RDONLY)) < 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        if (n == size) {
+            char *nb;
+            size = size ? size * 2 : MAX_BUF;
+            if (!(nb = realloc(buf, size))) {
+                goto out;
+            }
+            buf = nb;
+        }
+        if ((r = read(fd, buf + n, size - n)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            goto out;
+        }
+        if (r == 0) {
+            break;
+        }
+        n += r;
+    }
+
+    tc = unibi_termcap_from_mem(buf, n);
+
+out:
+    e = errno;
+    free(buf);
+    close(fd);
+    errno = e;
+    return tc;
+}
+
 static int add_overflowed(size_t *dst, size_t src) {
     *dst += src;
     return *dst < src;
@@ -201,11 +247,12 @@ unibi_term *unibi_from_term(const char *term) {
         }
     }
 
-    if ((env = getenv("TERMINFO_DIRS"))) {
-        return from_dirs(env, term);
+    env = getenv("TERMINFO_DIRS");
+    ut = from_dirs(env ? env : unibi_terminfo_dirs, term);
+    if (!ut && errno == ENOENT) {
+        ut = unibi_from_builtin(term);
     }
-
-    return from_dirs(unibi_terminfo_dirs, term);
+    return ut;
 }
 
 unibi_term *unibi_from_env(void) {
@@ -217,3 +264,229 @@ unibi_term *unibi_from_env(void) {
 
     return unibi_from_term(term);
 }
+
+/* unibi_install() writes each entry to a temporary file in the target
+ * directory and renames it into place, so readers never see a partially
+ * written entry. Aliases become hard links to the same file. */
+
+static int valid_file_name(const char *name) {
+    return name[0] != '\0' && name[0] != '.' && !strchr(name, '/');
+}
+
+static int is_dir(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/* dir/c/name or, if the tree already uses that layout, dir/hh/name */
+static char *entry_path(const char *dir, const char *name) {
+    const size_t dir_len = strlen(dir), name_len = strlen(name);
+    char *path;
+
+    if (!(path = malloc(dir_len + 1 + 2 + 1 + name_len + 1))) {
+        return NULL;
+    }
+
+    memcpy(path, dir, dir_len);
+    sprintf(path + dir_len, "/%c", name[0]);
+    if (!is_dir(path)) {
+        sprintf(path + dir_len, "/%02x", (unsigned int)((unsigned char)name[0] & 0xff));
+        if (!is_dir(path)) {
+            sprintf(path + dir_len, "/%c", name[0]);
+        }
+    }
+    return path;
+}
+
+static char *join_path(const char *dir, const char *name) {
+    const size_t dir_len = strlen(dir), name_len = strlen(name);
+    char *path;
+
+    if (!(path = malloc(dir_len + 1 + name_len + 1))) {
+        return NULL;
+    }
+    memcpy(path, dir, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+static int make_dir(const char *path) {
+#ifdef _WIN32
+    (void)path;
+    errno = ENOSYS;
+    return -1;
+#else
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+/* creates a unique temporary file next to path; returns its name */
+static char *make_temp(const char *path, int *pfd) {
+#ifdef _WIN32
+    (void)path;
+    (void)pfd;
+    errno = ENOSYS;
+    return NULL;
+#else
+    const char *base = strrchr(path, '/') + 1;
+    const size_t dir_len = base - path;
+    char *tmp;
+    int fd;
+
+    if (!(tmp = malloc(dir_len + 1 + strlen(base) + 8 + 1))) {
+        return NULL;
+    }
+    sprintf(tmp, "%.*s.%s.XXXXXX", (int)dir_len, path, base);
+    if ((fd = mkstemp(tmp)) < 0) {
+        free(tmp);
+        return NULL;
+    }
+    if (fchmod(fd, 0644) < 0) {
+        const int e = errno;
+        close(fd);
+        unlink(tmp);
+        free(tmp);
+        errno = e;
+        return NULL;
+    }
+    *pfd = fd;
+    return tmp;
+#endif
+}
+
+static char *write_temp(const char *path, const unibi_term *t) {
+    char *tmp;
+    int fd, e;
+
+    if (!(tmp = make_temp(path, &fd))) {
+        return NULL;
+    }
+    if (unibi_dump_fd(t, fd) == (size_t)-1) {
+        e = errno;
+        close(fd);
+        goto fail;
+    }
+    if (close(fd) < 0) {
+        e = errno;
+        goto fail;
+    }
+    return tmp;
+
+fail:
+    unlink(tmp);
+    free(tmp);
+    errno = e;
+    return NULL;
+}
+
+/* places a hard link to src (or, failing that, a copy of t) at path */
+static char *link_temp(const char *src, const char *path, const unibi_term *t) {
+#ifndef _WIN32
+    char *tmp;
+    int fd;
+
+    if (!(tmp = make_temp(path, &fd))) {
+        return NULL;
+    }
+    close(fd);
+    unlink(tmp);
+    if (link(src, tmp) == 0) {
+        return tmp;
+    }
+    free(tmp);
+#else
+    (void)src;
+#endif
+    return write_temp(path, t);
+}
+
+int unibi_install(const char *dir, const unibi_term *t) {
+    const char *const *names;
+    const char *single[2];
+    char **paths, **tmps;
+    size_t count, i;
+    int e, r;
+
+    assert(dir != NULL);
+
+    names = (const char *const *)unibi_get_aliases(t);
+    if (!names[0]) {
+        single[0] = unibi_get_name(t);
+        single[1] = NULL;
+        names = single;
+    }
+
+    for (count = 0; names[count]; count++) {
+        if (!valid_file_name(names[count])) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    if (!(paths = calloc(count, sizeof *paths))) {
+        return -1;
+    }
+    if (!(tmps = calloc(count, sizeof *tmps))) {
+        free(paths);
+        return -1;
+    }
+
+    r = -1;
+    e = 0;
+
+    if (make_dir(dir) < 0) {
+        e = errno;
+        goto out;
+    }
+
+    for (i = 0; i < count; i++) {
+        char *const sub = entry_path(dir, names[i]);
+        if (!sub) {
+            e = errno;
+            goto out;
+        }
+        if (make_dir(sub) < 0 || !(paths[i] = join_path(sub, names[i]))) {
+            e = errno;
+            free(sub);
+            goto out;
+        }
+        free(sub);
+
+        tmps[i] = i == 0 ? write_temp(paths[i], t) : link_temp(tmps[0], paths[i], t);
+        if (!tmps[i]) {
+            e = errno;
+            goto out;
+        }
+    }
+
+    /* the primary name goes last, so it only appears once all aliases exist */
+    for (i = count; i--; ) {
+        if (rename(tmps[i], paths[i]) < 0) {
+            e = errno;
+            goto out;
+        }
+        free(tmps[i]);
+        tmps[i] = NULL;
+    }
+
+    r = 0;
+
+out:
+    for (i = 0; i < count; i++) {
+        if (tmps[i]) {
+            unlink(tmps[i]);
+            free(tmps[i]);
+        }
+        free(paths[i]);
+    }
+    free(tmps);
+    free(paths);
+    if (r < 0) {
+        errno = e;
+    }
+    return r;
+}